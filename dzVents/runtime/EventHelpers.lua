@@ -92,15 +92,75 @@ local function EventHelpers(domoticz, mainMethod)
 		end
 	end
 
+	-- per data module, the serialized values and the sequence range of each history variable
+	-- as they are in the database, used to only write what changed
+	local storedData = {}
+
+	local function getDataModuleName(module)
+		return string.match(module, '([^/\\]+)$')
+	end
+
+	local function loadStoredData(module)
+		if (_G.dzVents_dataLoad == nil) then
+			return nil
+		end
+
+		local name = getDataModuleName(module)
+		local stored, storedHistory = dzVents_dataLoad(name)
+		if (next(stored) == nil and next(storedHistory) == nil) then
+			return nil
+		end
+
+		local function restore(var, source)
+			local chunk, err = load(source)
+			local ok, value = false, err
+			if (chunk ~= nil) then
+				ok, value = pcall(chunk)
+			end
+			if (not ok) then
+				utils.log('Unable to restore data "' .. var .. '" of ' .. name .. ': ' .. tostring(value), utils.LOG_ERROR)
+				return nil
+			end
+			return value
+		end
+
+		local data = {}
+		for var, source in pairs(stored) do
+			data[var] = restore(var, source)
+		end
+
+		-- history entries are stored one per row, youngest first
+		local history = {}
+		for var, entries in pairs(storedHistory) do
+			local items = {}
+			for _, entry in ipairs(entries) do
+				local item = restore(var, entry[2])
+				if (item ~= nil) then
+					item._seq = entry[1]
+					table.insert(items, item)
+				end
+			end
+			data[var] = items
+			history[var] = { first = entries[#entries][1], last = entries[1][1] }
+		end
+
+		storedData[name] = { values = stored, history = history }
+		return data
+	end
+
 	function self.getStorageContext(storageDef, module)
 
 		local storageContext = {}
 		local fileStorage, value, ok
 		
 		if (storageDef ~= nil) then
-			-- load the datafile for this module
-			ok, fileStorage = pcall(require, module)
-			package.loaded[module] = nil -- no caching
+			-- load the stored data, or the datafile for this module when it has not been migrated yet
+			fileStorage = loadStoredData(module)
+			ok = (fileStorage ~= nil)
+			if (not ok) then
+				ok, fileStorage = pcall(require, module)
+				package.loaded[module] = nil -- no caching
+			end
 			if (ok) then
 				-- only transfer data as defined in storageDef
 				for _var, _def in pairs(storageDef) do
@@ -177,9 +237,76 @@ local function EventHelpers(domoticz, mainMethod)
 		return storageContext
 	end
 
+	-- write the variables that changed since they were loaded to the database,
+	-- history variables only get their new entries added and the dropped ones removed
+	function self.storeData(name, dataFilePath, data, historyVars)
+		local previous = storedData[name]
+		local previousValues = previous ~= nil and previous.values or {}
+		local previousHistory = previous ~= nil and previous.history or {}
+		local stored = { values = {}, history = {} }
+		local changes = {}
+		local historyChanges = {}
+
+		for var, value in pairs(data) do
+			if (historyVars[var]) then
+				local range = previousHistory[var]
+				local last = range ~= nil and range.last or 0
+				local first = nil
+				local added = {}
+
+				-- oldest first, so new entries get increasing sequence numbers
+				for i = #value, 1, -1 do
+					local item = value[i]
+					if (item._seq == nil) then
+						last = last + 1
+						table.insert(added, { last, persistence.serialize({ time = item.time, data = item.data }) })
+						first = first or last
+					elseif (first == nil) then
+						first = item._seq
+					end
+				end
+
+				-- entries are only dropped at the old end, or all of them on a reset
+				local trim = first or (last + 1)
+				if (range == nil or trim <= range.first) then
+					trim = nil
+				end
+				if (#added > 0 or trim ~= nil) then
+					historyChanges[var] = { trim = trim, added = added }
+				end
+				stored.history[var] = first ~= nil and { first = first, last = last } or nil
+			else
+				local source = persistence.serialize(value)
+				stored.values[var] = source
+				if (previousValues[var] ~= source) then
+					changes[var] = source
+				end
+			end
+		end
+		for var, _ in pairs(previousValues) do
+			if (stored.values[var] == nil) then
+				changes[var] = false
+			end
+		end
+		for var, range in pairs(previousHistory) do
+			if (stored.history[var] == nil and historyChanges[var] == nil) then
+				historyChanges[var] = { trim = range.last + 1, added = {} }
+			end
+		end
+
+		dzVents_dataStore(name, changes, historyChanges)
+		storedData[name] = stored
+
+		if (previous == nil) then
+			-- migrated, the old data file is no longer used
+			os.remove(dataFilePath)
+		end
+	end
+
 	function self.writeStorageContext(storageDef, dataFilePath, dataFileModuleName, storageContext)
 
 		local data = {}
+		local historyVars = {}
 
 		if (storageDef ~= nil) then
 			-- transfer only stuf as described in storageDef
@@ -190,12 +317,18 @@ local function EventHelpers(domoticz, mainMethod)
 				else
 					if (def.history ~= nil and def.history == true) then
 						data[var] = storageContext[var]._getForStorage()
+						historyVars[var] = true
 					else
 						data[var] = storageContext[var]
 					end
 				end
 			end
-			local ok, err = pcall(persistence.store, dataFilePath, data)
+			local ok, err
+			if (_G.dzVents_dataStore ~= nil) then
+				ok, err = pcall(self.storeData, getDataModuleName(dataFileModuleName), dataFilePath, data, historyVars)
+			else
+				ok, err = pcall(persistence.store, dataFilePath, data)
+			end
 
 			-- make sure there is no cache for this 'data' module
 			package.loaded[dataFileModuleName] = nil
@@ -358,6 +491,19 @@ local function EventHelpers(domoticz, mainMethod)
 			return {}
 		end
 
+		-- Domoticz passes the script names it already knows, no need to list the folder
+		local catalog = _G.globalvariables ~= nil and _G.globalvariables[type .. '_scripts'] or nil
+		if (catalog ~= nil) then
+			for _, name in ipairs(catalog) do
+				table.insert(t, {
+					['type'] = type,
+					['name'] = name
+				})
+				namesLookup[name] = true
+			end
+			return t, namesLookup
+		end
+
 		if (sep == '/') then
 			cmd = 'ls -a "' .. directory .. '"'
 		else
@@ -95,7 +95,8 @@ local function HistoricalStorage(data, maxItems, maxHours, maxMinutes, getData)
 					add = false
 				end
 				if (add) then
-					table.insert(self.storage, { time = t, data = sample.data })
+					-- _seq identifies an entry that is already stored in the database
+					table.insert(self.storage, { time = t, data = sample.data, _seq = sample._seq })
 					count = count + 1
 				end
 			end
@@ -163,7 +164,8 @@ local function HistoricalStorage(data, maxItems, maxHours, maxMinutes, getData)
 		self.forEach(function(item)
 			table.insert(res,{
 				time = item.time.raw,
-				data = item.data
+				data = item.data,
+				_seq = item._seq
 			})
 		end)
 		return res
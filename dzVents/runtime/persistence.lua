@@ -3,6 +3,7 @@
 --[[ Provides ]]
 -- persistence.store(path, ...): Stores arbitrary items to the file at the given path
 -- persistence.load(path): Loads files that were previously stored with store and returns them
+-- persistence.serialize(...): Returns what store would write, as a string
 
 --[[ Limitations ]]
 -- Does not export userdata, threads or most function values
@@ -76,6 +77,16 @@ persistence =
 		file:close();
 	end;
 
+	-- Returns the same chunk store would write, as a string
+	serialize = function (...)
+		local buffer = {};
+		persistence.store({
+			write = function (self, s) buffer[#buffer + 1] = s; end;
+			close = function (self) end;
+		}, ...);
+		return table.concat(buffer);
+	end;
+
 	load = function (path)
 		local f, e = loadfile(path);
 		if f then
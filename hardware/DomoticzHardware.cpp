@@ -7,6 +7,7 @@
 #include "../main/RFXtrx.h"
 #include "../main/SQLHelper.h"
 #include "../main/mainworker.h"
+#include "../notifications/NotificationHelper.h"
 #include "hardwaretypes.h"
 #include "HardwareCereal.h"
 
@@ -854,8 +855,13 @@ void CDomoticzHardwareBase::SendCustomSensor(const int NodeID, const uint8_t Chi
 		m_mainworker.PushAndWaitRxMessage(this, (const unsigned char*)& gDevice, defaultname.c_str(), BatteryLevel, nullptr);
 		//Set the Label
 		std::string soptions = "1;" + defaultLabel;
-		m_sql.safe_query("UPDATE DeviceStatus SET Options='%q' WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Type==%d) AND (Subtype==%d)",
-			soptions.c_str(), m_HwdID, sTmp.c_str(), int(pTypeGeneral), int(sTypeCustom));
+		result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Type==%d) AND (Subtype==%d)",
+			m_HwdID, sTmp.c_str(), int(pTypeGeneral), int(sTypeCustom));
+		if (!result.empty())
+		{
+			m_sql.safe_query("UPDATE DeviceStatus SET Options='%q' WHERE (ID==%s)", soptions.c_str(), result[0][0].c_str());
+			m_notifications.DeviceChanged(std::stoull(result[0][0]));
+		}
 	}
 }
 
@@ -1108,6 +1114,9 @@ void CDomoticzHardwareBase::SendSelectorSwitch(const int NodeID, const uint8_t C
 		build_str << ";LevelActions:" << LevelActions.c_str();
 		std::string options_str = m_sql.FormatDeviceOptions(m_sql.BuildDeviceOptions( build_str.str(), false));
 		m_sql.safe_query("UPDATE DeviceStatus SET Name='%q', sValue=%i, SwitchType=%d, CustomImage=%i,options='%q' WHERE(HardwareID == %d) AND (DeviceID=='%08X') AND (Unit == '%d')", defaultname.c_str(), xcmd.level, (switchtype), customImage, options_str.c_str(), m_HwdID, NodeID, xcmd.unitcode);
+		result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%08X') AND (Unit == '%d')", m_HwdID, NodeID, xcmd.unitcode);
+		if (!result.empty())
+			m_mainworker.m_devicestore.Refresh(std::stoull(result[0][0]));
         // The Selector switch has been created
 	}
 	else
@@ -1115,7 +1124,9 @@ void CDomoticzHardwareBase::SendSelectorSwitch(const int NodeID, const uint8_t C
 		//Check Level
 		if (xcmd.level == std::stoi(result[0][1]))
 			return; // no need to uodate
+		uint64_t ulID = std::stoull(result[0][0]);
 		result = m_sql.safe_query("UPDATE DeviceStatus SET sValue=%i WHERE (HardwareID==%d) AND (DeviceID=='%08X')", xcmd.level, m_HwdID, NodeID);
+		m_mainworker.m_devicestore.Refresh(ulID);
 	}
 }
                             
@@ -1176,6 +1187,9 @@ int CDomoticzHardwareBase::MigrateSelectorSwitch(const int NodeID, const uint8_t
 			return -1;  // Signnal  selector switch is not latest version
 		std::string options_str = m_sql.FormatDeviceOptions(m_sql.BuildDeviceOptions(options, false));
 		m_sql.safe_query("UPDATE DeviceStatus SET options='%q' WHERE (HardwareID==%d) AND (DeviceID=='%08X')", options_str.c_str(), m_HwdID, NodeID);
+		result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%08X')", m_HwdID, NodeID);
+		for (const auto &sd : result)
+			m_mainworker.m_devicestore.Refresh(std::stoull(sd[0]));
 	   return 1; // signal migratreion completed
 	}
     return 0;	// signal no need for migration
@@ -6,11 +6,21 @@
 #include "../main/mainworker.h"
 #include "../main/WebServerHelper.h"
 #include "../webserver/proxyclient.h"
+#include "../tcpserver/TCPServer.h"
+#include <zlib.h>
 
 #define RETRY_DELAY 30
 
 extern http::server::CWebServerHelper m_webservers;
 
+namespace
+{
+	uint32_t ReadUInt32(const uint8_t *pData)
+	{
+		return pData[0] | (pData[1] << 8) | (pData[2] << 16) | (static_cast<uint32_t>(pData[3]) << 24);
+	}
+} // namespace
+
 DomoticzTCP::DomoticzTCP(const int ID, const std::string &IPAddress, const unsigned short usIPPort, const std::string &username, const std::string &password)
 	: m_szIPAddress(IPAddress)
 	, m_username(username)
@@ -81,10 +91,17 @@ bool DomoticzTCP::StopHardware()
 void DomoticzTCP::OnConnect()
 {
 	Log(LOG_STATUS, "connected to: %s:%d", m_szIPAddress.c_str(), m_usIPPort);
+	{
+		std::lock_guard<std::mutex> l(readQueueMutex);
+		m_bFirstData = true;
+		m_bReplicationV2 = false;
+		m_rxFrame.clear();
+	}
 	if (!m_username.empty())
 	{
-		std::string sAuth = std_format("AUTH;%s;%s", m_username.c_str(), m_password.c_str());
-		WriteToHardware(sAuth.c_str(), (unsigned char)sAuth.size());
+		// older servers only look at the user/password fields and keep sending unframed messages
+		std::string sAuth = std_format("%s:%u:%u;%s;%s", REPLICATION_AUTH, m_replicationSession, m_replicationSequence, m_username.c_str(), m_password.c_str());
+		write(sAuth);
 	}
 	sOnConnected(this);
 }
@@ -102,7 +119,71 @@ void DomoticzTCP::OnData(const unsigned char *pData, size_t length)
 		return;
 	}
 	std::lock_guard<std::mutex> l(readQueueMutex);
-	onInternalMessage((const unsigned char *)pData, length, false); // Do not check validity, this might be non RFX-message
+	if (m_bFirstData)
+	{
+		// the server answers a v2 login with a (possibly empty) frame, anything else is a legacy server
+		m_rxFrame.append((const char *)pData, length);
+		if ((m_rxFrame.size() < 4) && (strncmp(REPLICATION_MAGIC, m_rxFrame.c_str(), m_rxFrame.size()) == 0))
+			return;
+		m_bFirstData = false;
+		m_bReplicationV2 = (m_rxFrame.compare(0, 4, REPLICATION_MAGIC) == 0);
+		if (!m_bReplicationV2)
+		{
+			onInternalMessage((const unsigned char *)m_rxFrame.data(), m_rxFrame.size(), false);
+			m_rxFrame.clear();
+			return;
+		}
+		Debug(DEBUG_HARDWARE, "Using replication protocol v2");
+	}
+	else if (!m_bReplicationV2)
+	{
+		onInternalMessage((const unsigned char *)pData, length, false); // Do not check validity, this might be non RFX-message
+		return;
+	}
+	else
+		m_rxFrame.append((const char *)pData, length);
+	ParseReplicationFrames();
+}
+
+// caller holds readQueueMutex
+void DomoticzTCP::ParseReplicationFrames()
+{
+	size_t pos = 0;
+	while (m_rxFrame.size() - pos >= REPLICATION_HEADER_SIZE)
+	{
+		const uint8_t *pFrame = (const uint8_t *)m_rxFrame.data() + pos;
+		const uint32_t rawLength = ReadUInt32(pFrame + 13);
+		const uint32_t payloadLength = ReadUInt32(pFrame + 17);
+		if ((memcmp(pFrame, REPLICATION_MAGIC, 4) != 0) || (rawLength > REPLICATION_MAX_PAYLOAD) || (payloadLength > REPLICATION_MAX_PAYLOAD))
+		{
+			// skip to the next frame
+			Log(LOG_ERROR, "Replication stream out of sync!");
+			size_t next = m_rxFrame.find(REPLICATION_MAGIC, pos + 1);
+			pos = (next != std::string::npos) ? next : m_rxFrame.size() - 3;
+			continue;
+		}
+		if (m_rxFrame.size() - pos < REPLICATION_HEADER_SIZE + payloadLength)
+			break; // wait for the rest of the frame
+
+		const uint8_t flags = pFrame[4];
+		const uint8_t *pPayload = pFrame + REPLICATION_HEADER_SIZE;
+		if (flags & REPLICATION_FLAG_ZLIB)
+		{
+			std::vector<uint8_t> raw(rawLength);
+			uLongf destLen = rawLength;
+			if ((uncompress(raw.data(), &destLen, pPayload, payloadLength) == Z_OK) && (destLen == rawLength))
+				onInternalMessage(raw.data(), raw.size(), false);
+			else
+				Log(LOG_ERROR, "Invalid compressed replication frame received!");
+		}
+		else if (payloadLength != 0)
+			onInternalMessage(pPayload, payloadLength, false);
+
+		m_replicationSession = ReadUInt32(pFrame + 5);
+		m_replicationSequence = ReadUInt32(pFrame + 9);
+		pos += REPLICATION_HEADER_SIZE + payloadLength;
+	}
+	m_rxFrame.erase(0, pos);
 }
 
 void DomoticzTCP::OnError(const boost::system::error_code& error)
@@ -28,6 +28,7 @@ class DomoticzTCP : public CRFXBase, ASyncTCP
 	bool StartHardware() override;
 	bool StopHardware() override;
 	void Do_Work();
+	void ParseReplicationFrames();
 
 #ifndef NOCLOUD
 	bool StartHardwareProxy();
@@ -42,6 +43,13 @@ class DomoticzTCP : public CRFXBase, ASyncTCP
 	std::string m_username;
 	std::string m_password;
 	std::shared_ptr<std::thread> m_thread;
+
+	// replication protocol v2, the session/sequence survive reconnects so we can resume
+	bool m_bFirstData = true;
+	bool m_bReplicationV2 = false;
+	std::string m_rxFrame;
+	uint32_t m_replicationSession = 0;
+	uint32_t m_replicationSequence = 0;
 #ifndef NOCLOUD
 	std::string token;
 	bool b_ProxyConnected;
@@ -685,6 +685,7 @@ void CHEOS::UpdateNodeStatus(const std::string &DevID, const _eMediaStatus nStat
 
 	result = m_sql.safe_query("UPDATE DeviceStatus SET nValue=%d, sValue='%q', LastUpdate='%q' WHERE (HardwareID == %d) AND (DeviceID == '%q') AND (Unit == 1) AND (SwitchType == %d)",
 		int(nStatus), sStatus.c_str(), szLastUpdate, m_HwdID, DevID.c_str(), STYPE_Media);
+	RefreshNodeState(DevID);
 }
 
 void CHEOS::UpdateNodesStatus(const std::string &DevID, const std::string &sStatus)
@@ -700,6 +701,16 @@ void CHEOS::UpdateNodesStatus(const std::string &DevID, const std::string &sStat
 
 	result = m_sql.safe_query("UPDATE DeviceStatus SET sValue='%q', LastUpdate='%q' WHERE (HardwareID == %d) AND (DeviceID == '%q') AND (Unit == 1) AND (SwitchType == %d)",
 		sStatus.c_str(), szLastUpdate, m_HwdID, DevID.c_str(), STYPE_Media);
+	RefreshNodeState(DevID);
+}
+
+//The node status is written to DeviceStatus directly, republish it to the device state store
+void CHEOS::RefreshNodeState(const std::string &DevID)
+{
+	auto result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID == %d) AND (DeviceID == '%q') AND (Unit == 1) AND (SwitchType == %d)",
+		m_HwdID, DevID.c_str(), STYPE_Media);
+	for (const auto &sd : result)
+		m_mainworker.m_devicestore.Refresh(std::stoull(sd[0]));
 }
 
 void CHEOS::AddNode(const std::string &Name, const std::string &PlayerID)
@@ -721,6 +732,7 @@ void CHEOS::AddNode(const std::string &Name, const std::string &PlayerID)
 void CHEOS::UpdateNode(const int ID, const std::string &Name)
 {
 	m_sql.safe_query("UPDATE DeviceStatus SET Name='%q' WHERE (HardwareID==%d) AND (ID=='%d')", Name.c_str(), m_HwdID, ID);
+	m_mainworker.m_devicestore.Refresh(ID);
 
 	ReloadNodes();
 }
@@ -45,6 +45,7 @@ class CHEOS : public CDomoticzHardwareBase, ASyncTCP
 	void UpdateNode(int ID, const std::string &Name);
 	void UpdateNodeStatus(const std::string &DevID, _eMediaStatus nStatus, const std::string &sStatus);
 	void UpdateNodesStatus(const std::string &DevID, const std::string &sStatus);
+	void RefreshNodeState(const std::string &DevID);
 	//	void RemoveNode(const int ID);
 	void ReloadNodes();
 
@@ -542,6 +542,7 @@ void CKodiNode::UpdateStatus()
 	{
 		result = m_sql.safe_query("UPDATE DeviceStatus SET nValue=%d, sValue='%q', LastUpdate='%q' WHERE (HardwareID == %d) AND (DeviceID == '%q') AND (Unit == 1) AND (SwitchType == %d)",
 			int(m_CurrentStatus.Status()), m_CurrentStatus.StatusMessage().c_str(), m_CurrentStatus.LastOK().c_str(), m_HwdID, m_szDevID, STYPE_Media);
+		m_mainworker.m_devicestore.Refresh(m_ID);
 	}
 
 	// 2:	Log the event if the actual status has changed (not counting the percentage)
@@ -1107,6 +1108,9 @@ bool CKodi::UpdateNode(const int ID, const std::string &Name, const std::string
 
 	//Also update Light/Switch
 	m_sql.safe_query("UPDATE DeviceStatus SET Name='%q' WHERE (HardwareID==%d) AND (DeviceID=='%q')", Name.c_str(), m_HwdID, szID);
+	result = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q')", m_HwdID, szID);
+	if (!result.empty())
+		m_mainworker.m_devicestore.Refresh(std::stoull(result[0][0]));
 	ReloadNodes();
 	return true;
 }
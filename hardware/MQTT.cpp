@@ -19,6 +19,10 @@
 #define QOS 1
 #define RETAIN_BIT 0x80
 
+#define MQTT_PUBLISH_QUEUE_MAX 10000
+#define MQTT_PUBLISH_COALESCE_MS 50
+#define MQTT_PUBLISH_BATCH 250
+
 namespace
 {
 	constexpr std::array<const char *, 3> szTLSVersions{
@@ -86,6 +90,15 @@ bool MQTT::StartHardware()
 	m_LastUpdatedDeviceRowIdx = 0;
 	m_LastUpdatedSceneRowIdx = 0;
 
+	{
+		std::lock_guard<std::mutex> l(m_publishMutex);
+		m_publishOrder.clear();
+		m_publishPending.clear();
+		m_bPublishStop = false;
+	}
+	m_publishThread = std::make_shared<std::thread>([this] { Do_Publish(); });
+	SetThreadName(m_publishThread->native_handle(), "MQTT_Publish");
+
 	// Start worker thread
 	m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
 	SetThreadNameInt(m_thread->native_handle());
@@ -109,6 +122,16 @@ bool MQTT::StopHardware()
 		m_thread->join();
 		m_thread.reset();
 	}
+	if (m_publishThread)
+	{
+		{
+			std::lock_guard<std::mutex> l(m_publishMutex);
+			m_bPublishStop = true;
+		}
+		m_publishCondition.notify_one();
+		m_publishThread->join();
+		m_publishThread.reset();
+	}
 	m_IsConnected = false;
 	return true;
 }
@@ -731,6 +754,7 @@ void MQTT::WriteInt(const std::string &sendStr)
 
 void MQTT::SendDeviceInfo(const int HwdID, const uint64_t DeviceRowIdx, const std::string & /*DeviceName*/, const unsigned char * /*pRXCommand*/)
 {
+	// Called from the receive path, only queue the device, the publisher thread reads and sends it
 	if (!m_IsConnected)
 		return;
 
@@ -741,138 +765,237 @@ void MQTT::SendDeviceInfo(const int HwdID, const uint64_t DeviceRowIdx, const st
 		return;
 	}
 
-	std::vector<std::vector<std::string>> result;
-	result = m_sql.safe_query("SELECT HardwareID, DeviceID, Unit, Name, [Type], SubType, nValue, sValue, SwitchType, SignalLevel, BatteryLevel, Options, Description, LastLevel, Color, LastUpdate "
-				  "FROM DeviceStatus WHERE (HardwareID==%d) AND (ID==%" PRIu64 ")",
-				  HwdID, DeviceRowIdx);
-	if (!result.empty())
-	{
-		int iIndex = 0;
-		std::vector<std::string> sd = result[0];
-		std::string hwid = sd[iIndex++];
-		std::string did = sd[iIndex++];
-		int dunit = atoi(sd[iIndex++].c_str());
-		std::string name = sd[iIndex++];
-		int dType = atoi(sd[iIndex++].c_str());
-		int dSubType = atoi(sd[iIndex++].c_str());
-		int nvalue = atoi(sd[iIndex++].c_str());
-		std::string svalue = sd[iIndex++];
-		_eSwitchType switchType = (_eSwitchType)atoi(sd[iIndex++].c_str());
-		int RSSI = atoi(sd[iIndex++].c_str());
-		int BatteryLevel = atoi(sd[iIndex++].c_str());
-		std::map<std::string, std::string> options = m_sql.BuildDeviceOptions(sd[iIndex++]);
-		std::string description = sd[iIndex++];
-		int LastLevel = atoi(sd[iIndex++].c_str());
-		std::string sColor = sd[iIndex++];
-		std::string sLastUpdate = sd[iIndex++];
-
-		Json::Value root;
-
-		root["idx"] = Json::Value::UInt64(DeviceRowIdx);
-		root["hwid"] = hwid;
-
-		if ((dType == pTypeTEMP) || (dType == pTypeTEMP_BARO) || (dType == pTypeTEMP_HUM) || (dType == pTypeTEMP_HUM_BARO) || (dType == pTypeBARO) || (dType == pTypeHUM) ||
-		    (dType == pTypeWIND) || (dType == pTypeRAIN) || (dType == pTypeUV) || (dType == pTypeCURRENT) || (dType == pTypeCURRENTENERGY) || (dType == pTypeENERGY) ||
-		    (dType == pTypeRFXMeter) || (dType == pTypeAirQuality) || (dType == pTypeRFXSensor) || (dType == pTypeP1Power) || (dType == pTypeP1Gas))
+	{
+		std::lock_guard<std::mutex> l(m_publishMutex);
+		if (m_publishPending.find(DeviceRowIdx) != m_publishPending.end())
+			return; // already queued, the latest state is read when published
+		if (m_publishPending.size() >= MQTT_PUBLISH_QUEUE_MAX)
 		{
-			try
+			time_t atime = mytime(nullptr);
+			if (atime - m_LastQueueFullLog >= 60)
 			{
-				root["id"] = std_format("%04X", std::stoi(did));
+				m_LastQueueFullLog = atime;
+				Log(LOG_ERROR, "MQTT: Publish queue full (%d devices), dropping updates!", MQTT_PUBLISH_QUEUE_MAX);
 			}
-			catch (const std::exception &)
-			{
-				//illegal ID here !? probably caused by a plugin/script that does not use numbers as 'ID' (which it should!)
-				root["id"] = did;
-			}
-		}
-		else
-		{
-			root["id"] = did;
+			return;
 		}
-		root["unit"] = dunit;
-		root["name"] = name;
-		root["dtype"] = RFX_Type_Desc((uint8_t)dType, 1);
-		root["stype"] = RFX_Type_SubType_Desc((uint8_t)dType, (uint8_t)dSubType);
+		m_publishPending[DeviceRowIdx] = HwdID;
+		m_publishOrder.push_back(DeviceRowIdx);
+	}
+	m_publishCondition.notify_one();
+}
 
-		if (IsLightOrSwitch(dType, dSubType) == true)
+void MQTT::Do_Publish()
+{
+	std::vector<std::pair<uint64_t, int>> batch;
+	while (true)
+	{
 		{
-			root["switchType"] = Switch_Type_Desc(switchType);
+			std::unique_lock<std::mutex> l(m_publishMutex);
+			m_publishCondition.wait(l, [this] { return m_bPublishStop || !m_publishOrder.empty(); });
+			if (m_bPublishStop)
+				break;
+			// give a burst of updates for the same device(s) the chance to collapse
+			if (m_publishCondition.wait_for(l, std::chrono::milliseconds(MQTT_PUBLISH_COALESCE_MS), [this] { return m_bPublishStop; }))
+				break;
+			batch.clear();
+			for (const auto idx : m_publishOrder)
+				batch.emplace_back(idx, m_publishPending[idx]);
+			m_publishOrder.clear();
+			m_publishPending.clear();
 		}
-		else if ((dType == pTypeRFXMeter) || (dType == pTypeRFXSensor))
+		try
 		{
-			root["meterType"] = Meter_Type_Desc((_eMeterType)switchType);
+			PublishDevices(batch);
 		}
-		// Add device options
-		for (const auto &option : options)
+		catch (const std::exception &e)
 		{
-			std::string optionName = option.first;
-			std::string optionValue = option.second;
-			root[optionName] = optionValue;
+			Log(LOG_ERROR, "MQTT: Error publishing device info (%s)", e.what());
 		}
+	}
+}
 
-		root["RSSI"] = RSSI;
-		root["Battery"] = BatteryLevel;
-		root["nvalue"] = nvalue;
-		root["description"] = description;
-		root["LastUpdate"] = sLastUpdate;
+void MQTT::PublishDevices(const std::vector<std::pair<uint64_t, int>> &batch)
+{
+	for (size_t iStart = 0; iStart < batch.size(); iStart += MQTT_PUBLISH_BATCH)
+	{
+		if (!m_IsConnected)
+			return;
+
+		size_t iEnd = std::min(batch.size(), iStart + MQTT_PUBLISH_BATCH);
 
-		if (switchType == STYPE_Dimmer)
+		// device state comes from the in-memory store, which is updated right after the writer connection.
+		// The plan mapping is read on that same connection, the reader pool may not see an open transaction yet
+		std::multimap<uint64_t, std::string> rooms;
+		if (m_publish_scheme & PT_floor_room)
 		{
-			root["Level"] = LastLevel;
-			if (dType == pTypeColorSwitch)
+			std::string szIDs;
+			for (size_t ii = iStart; ii < iEnd; ii++)
 			{
-				_tColor color(sColor);
-				root["Color"] = color.toJSONValue();
+				if (!szIDs.empty())
+					szIDs += ",";
+				szIDs += std::to_string(batch[ii].first);
 			}
+			auto result = m_sql.safe_query(
+				"SELECT M.DeviceRowID, F.Name, P.Name FROM Plans as P, Floorplans as F, DeviceToPlansMap as M WHERE P.FloorplanID=F.ID and M.PlanID=P.ID and M.DeviceRowID IN (%s)",
+				szIDs.c_str());
+			for (const auto &sd : result)
+				rooms.emplace(std::stoull(sd[0]), sd[1] + "/" + sd[2]);
 		}
 
-		// give all svalues separate
-		std::vector<std::string> strarray;
-		StringSplit(svalue, ";", strarray);
+		for (size_t ii = iStart; ii < iEnd; ii++)
+		{
+			CDeviceStateStore::_tDeviceStatePtr state = m_mainworker.m_devicestore.Get(batch[ii].first);
+			if (!state)
+				continue;
+			if (state->HardwareID != batch[ii].second)
+				continue;
+			PublishDevice(*state, rooms);
+		}
+	}
+}
 
-		int sIndex = 1;
-		for (const auto &str : strarray)
+void MQTT::PublishDevice(const CDeviceStateStore::_tDeviceState &state, const std::multimap<uint64_t, std::string> &rooms)
+{
+	const uint64_t DeviceRowIdx = state.ID;
+	std::string hwid = std::to_string(state.HardwareID);
+	const std::string &did = state.DeviceID;
+	int dunit = state.Unit;
+	const std::string &name = state.Name;
+	int dType = state.devType;
+	int dSubType = state.subType;
+	int nvalue = state.nValue;
+	const std::string &svalue = state.sValue;
+	_eSwitchType switchType = (_eSwitchType)state.SwitchType;
+	int RSSI = state.SignalLevel;
+	int BatteryLevel = state.BatteryLevel;
+	std::map<std::string, std::string> options = m_sql.BuildDeviceOptions(state.Options);
+	const std::string &description = state.Description;
+	int LastLevel = state.LastLevel;
+	const std::string &sColor = state.Color;
+	const std::string &sLastUpdate = state.LastUpdate;
+
+	Json::Value root;
+
+	root["idx"] = Json::Value::UInt64(DeviceRowIdx);
+	root["hwid"] = hwid;
+
+	if ((dType == pTypeTEMP) || (dType == pTypeTEMP_BARO) || (dType == pTypeTEMP_HUM) || (dType == pTypeTEMP_HUM_BARO) || (dType == pTypeBARO) || (dType == pTypeHUM) ||
+	    (dType == pTypeWIND) || (dType == pTypeRAIN) || (dType == pTypeUV) || (dType == pTypeCURRENT) || (dType == pTypeCURRENTENERGY) || (dType == pTypeENERGY) ||
+	    (dType == pTypeRFXMeter) || (dType == pTypeAirQuality) || (dType == pTypeRFXSensor) || (dType == pTypeP1Power) || (dType == pTypeP1Gas))
+	{
+		try
 		{
-			std::stringstream szQuery;
-			szQuery << "svalue" << sIndex;
-			root[szQuery.str()] = str;
-			sIndex++;
+			root["id"] = std_format("%04X", std::stoi(did));
 		}
-		std::string message = root.toStyledString();
-		if (m_publish_scheme & PT_out)
+		catch (const std::exception &)
 		{
-			SendMessage(m_TopicOut, message);
+			//illegal ID here !? probably caused by a plugin/script that does not use numbers as 'ID' (which it should!)
+			root["id"] = did;
 		}
+	}
+	else
+	{
+		root["id"] = did;
+	}
+	root["unit"] = dunit;
+	root["name"] = name;
+	root["dtype"] = RFX_Type_Desc((uint8_t)dType, 1);
+	root["stype"] = RFX_Type_SubType_Desc((uint8_t)dType, (uint8_t)dSubType);
 
-		if (m_publish_scheme & PT_floor_room)
-		{
-			result = m_sql.safe_query(
-				"SELECT F.Name, P.Name, M.DeviceRowID FROM Plans as P, Floorplans as F, DeviceToPlansMap as M WHERE P.FloorplanID=F.ID and M.PlanID=P.ID and M.DeviceRowID=='%" PRIu64
-				"'",
-				DeviceRowIdx);
-			for (const auto &sd : result)
-			{
-				std::string floor = sd[0];
-				std::string room = sd[1];
-				std::stringstream topic;
-				topic << m_TopicOut << "/" << floor << "/" + room;
+	if (IsLightOrSwitch(dType, dSubType) == true)
+	{
+		root["switchType"] = Switch_Type_Desc(switchType);
+	}
+	else if ((dType == pTypeRFXMeter) || (dType == pTypeRFXSensor))
+	{
+		root["meterType"] = Meter_Type_Desc((_eMeterType)switchType);
+	}
+	// Add device options
+	for (const auto &option : options)
+	{
+		std::string optionName = option.first;
+		std::string optionValue = option.second;
+		root[optionName] = optionValue;
+	}
 
-				SendMessage(topic.str(), message);
-			}
+	root["RSSI"] = RSSI;
+	root["Battery"] = BatteryLevel;
+	root["nvalue"] = nvalue;
+	root["description"] = description;
+	root["LastUpdate"] = sLastUpdate;
+
+	if (switchType == STYPE_Dimmer)
+	{
+		root["Level"] = LastLevel;
+		if (dType == pTypeColorSwitch)
+		{
+			_tColor color(sColor);
+			root["Color"] = color.toJSONValue();
 		}
+	}
 
-		if (m_publish_scheme & PT_device_idx)
+	// give all svalues separate
+	std::vector<std::string> strarray;
+	StringSplit(svalue, ";", strarray);
+
+	int sIndex = 1;
+	for (const auto &str : strarray)
+	{
+		std::stringstream szQuery;
+		szQuery << "svalue" << sIndex;
+		root[szQuery.str()] = str;
+		sIndex++;
+	}
+
+	std::string message = root.toStyledString();
+
+	if (m_publish_scheme & PT_out)
+	{
+		SendMessage(m_TopicOut, message);
+	}
+
+	if (m_publish_scheme & PT_floor_room)
+	{
+		auto range = rooms.equal_range(DeviceRowIdx);
+		for (auto itt = range.first; itt != range.second; ++itt)
 		{
-			std::stringstream topic;
-			topic << m_TopicOut << "/" << DeviceRowIdx;
-			SendMessage(topic.str(), message);
+			SendMessage(m_TopicOut + "/" + itt->second, message);
 		}
-		if (m_publish_scheme & PT_device_name)
+	}
+
+	if (m_publish_scheme & PT_device_idx)
+	{
+		SendMessage(m_TopicOut + "/" + std::to_string(DeviceRowIdx), message);
+	}
+	if (m_publish_scheme & PT_device_name)
+	{
+		SendMessage(m_TopicOut + "/" + name, message);
+	}
+	if (m_publish_scheme & PT_device_values)
+	{
+		// one topic per value, for consumers that do not want to parse the JSON
+		std::string szBase = m_TopicOut + "/" + std::to_string(DeviceRowIdx) + "/";
+		size_t baseLen = szBase.size();
+		m_valueTopic = szBase;
+		m_valueTopic += "nvalue";
+		SendMessage(m_valueTopic, std::to_string(nvalue));
+		m_valueTopic.resize(baseLen);
+		m_valueTopic += "svalue";
+		SendMessage(m_valueTopic, svalue);
+		sIndex = 1;
+		for (const auto &str : strarray)
 		{
-			std::stringstream topic;
-			topic << m_TopicOut << "/" << name;
-			SendMessage(topic.str(), message);
+			m_valueTopic.resize(baseLen);
+			m_valueTopic += "svalue" + std::to_string(sIndex++);
+			SendMessage(m_valueTopic, str);
 		}
+		m_valueTopic.resize(baseLen);
+		m_valueTopic += "battery";
+		SendMessage(m_valueTopic, std::to_string(BatteryLevel));
+		m_valueTopic.resize(baseLen);
+		m_valueTopic += "rssi";
+		SendMessage(m_valueTopic, std::to_string(RSSI));
 	}
 }
 
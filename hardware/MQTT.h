@@ -2,6 +2,9 @@
 
 #include "MySensorsBase.h"
 #include "../main/mosquitto_helper.h"
+#include "../main/DeviceStateStore.h"
+#include <condition_variable>
+#include <deque>
 
 class MQTT : public MySensorsBase, mosqdz::mosquittodz
 {
@@ -42,6 +45,7 @@ class MQTT : public MySensorsBase, mosqdz::mosquittodz
 		PT_floor_room_and_out = PT_out | PT_floor_room,
 		PT_device_idx = 0x04,  // publish on domoticz/out/idx
 		PT_device_name = 0x08, // publish on domoticz/out/name
+		PT_device_values = 0x10, // publish on domoticz/out/idx/<value>
 	};
 	std::string m_szIPAddress;
 	unsigned short m_usIPPort;
@@ -56,12 +60,23 @@ class MQTT : public MySensorsBase, mosqdz::mosquittodz
 	bool ConnectInt();
 	bool ConnectIntEx();
 	void SendDeviceInfo(int HwdID, uint64_t DeviceRowIdx, const std::string &DeviceName, const unsigned char *pRXCommand);
+	void Do_Publish();
+	void PublishDevices(const std::vector<std::pair<uint64_t, int>> &batch);
+	void PublishDevice(const CDeviceStateStore::_tDeviceState &state, const std::multimap<uint64_t, std::string> &rooms);
 	void SendSceneInfo(uint64_t SceneIdx, const std::string &SceneName);
 	void StopMQTT();
 	void Do_Work();
 	virtual void SendHeartbeat();
 	void WriteInt(const std::string &sendStr) override;
 	std::shared_ptr<std::thread> m_thread;
+	std::shared_ptr<std::thread> m_publishThread;
+	std::mutex m_publishMutex;
+	std::condition_variable m_publishCondition;
+	std::deque<uint64_t> m_publishOrder;
+	std::map<uint64_t, int> m_publishPending; // DeviceRowIdx -> HwdID, repeated updates collapse into one publish
+	bool m_bPublishStop = false;
+	time_t m_LastQueueFullLog = 0;
+	std::string m_valueTopic;
 	boost::signals2::connection m_sDeviceReceivedConnection;
 	boost::signals2::connection m_sSwitchSceneConnection;
 	_ePublishTopics m_publish_scheme;
@@ -308,11 +308,21 @@ COpenZWave::~COpenZWave()
 //-----------------------------------------------------------------------------
 COpenZWave::NodeInfo* COpenZWave::GetNodeInfo(const unsigned int homeID, const uint8_t nodeID)
 {
-	for (auto &node : m_nodes)
-		if ((node.homeId == homeID) && (node.nodeId == nodeID))
-			return &node;
+	auto itt = m_nodeIndex.find(NodeIndexKey(homeID, nodeID));
+	if (itt == m_nodeIndex.end())
+		return nullptr;
+	return itt->second;
+}
 
-	return nullptr;
+uint64_t COpenZWave::NodeIndexKey(const unsigned int homeID, const uint8_t nodeID)
+{
+	return (static_cast<uint64_t>(homeID) << 8) | nodeID;
+}
+
+void COpenZWave::ClearNodes()
+{
+	m_nodes.clear();
+	m_nodeIndex.clear();
 }
 
 std::string COpenZWave::GetNodeStateString(const unsigned int homeID, const uint8_t nodeID)
@@ -508,6 +518,8 @@ void COpenZWave::OnZWaveNotification(OpenZWave::Notification const* _notificatio
 
 		nodeInfo.LastSeen = m_updateTime;
 		m_nodes.push_back(nodeInfo);
+		if (m_nodeIndex.find(NodeIndexKey(_homeID, _nodeID)) == m_nodeIndex.end())
+			m_nodeIndex[NodeIndexKey(_homeID, _nodeID)] = &m_nodes.back();
 		m_LastIncludedNode = _nodeID;
 		m_LastIncludedNodeType = nodeInfo.szType;
 		m_bHaveLastIncludedNodeInfo = !nodeInfo.Product_name.empty();
@@ -526,6 +538,7 @@ void COpenZWave::OnZWaveNotification(OpenZWave::Notification const* _notificatio
 		{
 			if ((it->homeId == _homeID) && (it->nodeId == _nodeID))
 			{
+				m_nodeIndex.erase(NodeIndexKey(_homeID, _nodeID));
 				m_nodes.erase(it);
 				//DeleteNode(_homeID, _nodeID);
 				break;
@@ -538,7 +551,7 @@ void COpenZWave::OnZWaveNotification(OpenZWave::Notification const* _notificatio
 	case OpenZWave::Notification::Type_NodeProtocolInfo:
 		break;
 	case OpenZWave::Notification::Type_DriverReset:
-		m_nodes.clear();
+		ClearNodes();
 		m_controllerID = _notification->GetHomeId();
 		break;
 	case OpenZWave::Notification::Type_ValueAdded:
@@ -753,7 +766,7 @@ void COpenZWave::OnZWaveNotification(OpenZWave::Notification const* _notificatio
 		break;
 	case OpenZWave::Notification::Type_DriverFailed:
 		m_initFailed = true;
-		m_nodes.clear();
+		ClearNodes();
 		Log(LOG_ERROR, "Driver Failed!!");
 		break;
 	case OpenZWave::Notification::Type_DriverRemoved:
@@ -905,7 +918,7 @@ bool COpenZWave::OpenSerialConnector()
 	m_updateTime = mytime(nullptr);
 	CloseSerialConnector();
 
-	m_nodes.clear();
+	ClearNodes();
 	std::string ConfigPath = szStartupFolder + "Config/";
 	std::string UserPath = ConfigPath;
 	if (szStartupFolder != szUserDataFolder)
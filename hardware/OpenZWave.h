@@ -173,6 +173,10 @@ class COpenZWave : public ZWaveBase
 	OpenZWave::Manager *m_pManager;
 
 	std::list<NodeInfo> m_nodes;
+	//m_nodes by (homeID, nodeID), list elements do not move
+	std::unordered_map<uint64_t, NodeInfo *> m_nodeIndex;
+	static uint64_t NodeIndexKey(unsigned int homeID, uint8_t nodeID);
+	void ClearNodes();
 
 	std::string m_szSerialPort;
 	unsigned int m_controllerID;
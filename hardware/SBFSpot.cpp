@@ -324,6 +324,7 @@ void CSBFSpot::ImportOldMonthData(const uint64_t DevID, const int Year, const in
 					//Insert value into our database
 					m_sql.safe_query("INSERT INTO Meter_Calendar (DeviceRowID, Value, Date) VALUES ('%" PRIu64 "', '%llu', '%q')", DevID, ulCounter, szDate);
 					Log(LOG_STATUS, "SBFSpot Import Old Month Data: Inserting %s",szDate);
+					m_sql.HistoryChanged();
 				}
 
 			}
@@ -392,6 +393,7 @@ void CSBFSpot::ImportOldMonthData(const uint64_t DevID, const int Year, const in
 							m_sql.safe_query("INSERT INTO Meter_Calendar (DeviceRowID, Value, Date) VALUES ('%" PRIu64 "', '%llu', '%q')",
 								DevID, ulCounter, szDate);
 							Log(LOG_STATUS, "SBFSpot Import Old Month Data: Inserting %s", szDate);
+							m_sql.HistoryChanged();
 						}
 					}
 				}
@@ -140,7 +140,26 @@ void ZWaveBase::InsertDevice(_tZWaveDevice device)
 #endif
 	//insert or update device in internal record
 	device.sequence_number = 1;
-	m_devices[device.string_id] = device;
+	auto itt = m_devices.find(device.string_id);
+	if (itt != m_devices.end())
+	{
+		if ((itt->second.nodeID != device.nodeID) || (itt->second.devType != device.devType))
+		{
+			RemoveFromDeviceIndex(&itt->second);
+			itt->second = device;
+			itt = m_devices.end();
+		}
+		else
+			itt->second = device;
+	}
+	if (itt == m_devices.end())
+	{
+		_tZWaveDevice *pDevice = &m_devices[device.string_id];
+		*pDevice = device;
+		auto &devices = m_deviceIndex[DeviceIndexKey(device.nodeID, device.devType)];
+		auto pos = std::lower_bound(devices.begin(), devices.end(), pDevice, [](const _tZWaveDevice *a, const _tZWaveDevice *b) { return a->string_id < b->string_id; });
+		devices.insert(pos, pDevice);
+	}
 
 	SendSwitchIfNotExists(&device);
 }
@@ -794,34 +813,47 @@ void ZWaveBase::SendDevice2Domoticz(_tZWaveDevice* pDevice)
 	}
 }
 
+uint32_t ZWaveBase::DeviceIndexKey(const uint8_t nodeID, const _eZWaveDeviceType devType)
+{
+	return (static_cast<uint32_t>(nodeID) << 16) | static_cast<uint32_t>(devType);
+}
+
+void ZWaveBase::RemoveFromDeviceIndex(const _tZWaveDevice *pDevice)
+{
+	auto itt = m_deviceIndex.find(DeviceIndexKey(pDevice->nodeID, pDevice->devType));
+	if (itt == m_deviceIndex.end())
+		return;
+	itt->second.erase(std::remove(itt->second.begin(), itt->second.end(), pDevice), itt->second.end());
+	if (itt->second.empty())
+		m_deviceIndex.erase(itt);
+}
+
 ZWaveBase::_tZWaveDevice* ZWaveBase::FindDevice(const uint8_t nodeID, const int instanceID, const _eZWaveDeviceType devType)
 {
-	for (auto &m : m_devices)
+	auto itt = m_deviceIndex.find(DeviceIndexKey(nodeID, devType));
+	if (itt == m_deviceIndex.end())
+		return nullptr;
+	for (auto pDevice : itt->second)
 	{
-		if (
-			(m.second.nodeID == nodeID)
-			&& ((m.second.instanceID == instanceID) || (instanceID == -1))
-		    && (m.second.devType == devType)
-			)
-		{
-			return &m.second;
-		}
+		if ((pDevice->instanceID == instanceID) || (instanceID == -1))
+			return pDevice;
 	}
 	return nullptr;
 }
 
 ZWaveBase::_tZWaveDevice *ZWaveBase::FindDevice(const uint8_t nodeID, const int instanceID, const uint8_t CommandClassID, const _eZWaveDeviceType devType)
 {
-	for (auto &m : m_devices)
+	auto itt = m_deviceIndex.find(DeviceIndexKey(nodeID, devType));
+	if (itt == m_deviceIndex.end())
+		return nullptr;
+	for (auto pDevice : itt->second)
 	{
 		if (
-			(m.second.nodeID == nodeID)
-			&& ((m.second.instanceID == instanceID) || (instanceID == -1))
-		    && (m.second.commandClassID == CommandClassID)
-			&& (m.second.devType == devType)
+			((pDevice->instanceID == instanceID) || (instanceID == -1))
+			&& (pDevice->commandClassID == CommandClassID)
 			)
 		{
-			return &m.second;
+			return pDevice;
 		}
 	}
 	return nullptr;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <time.h>
+#include <unordered_map>
 #include "DomoticzHardware.h"
 
 class ZWaveBase : public CDomoticzHardwareBase
@@ -155,6 +156,8 @@ class ZWaveBase : public CDomoticzHardwareBase
 
 	_tZWaveDevice *FindDevice(uint8_t nodeID, int instanceID, _eZWaveDeviceType devType);
 	_tZWaveDevice *FindDevice(uint8_t nodeID, int instanceID, uint8_t CommandClassID, _eZWaveDeviceType devType);
+	static uint32_t DeviceIndexKey(uint8_t nodeID, _eZWaveDeviceType devType);
+	void RemoveFromDeviceIndex(const _tZWaveDevice *pDevice);
 
 	std::string GenerateDeviceStringID(const _tZWaveDevice *pDevice);
 	void InsertDevice(_tZWaveDevice device);
@@ -181,5 +184,7 @@ class ZWaveBase : public CDomoticzHardwareBase
 	time_t m_updateTime{ 0 };
 	bool m_bInitState;
 	std::map<std::string, _tZWaveDevice> m_devices;
+	//devices by node and type, each list in m_devices (string_id) order
+	std::unordered_map<uint32_t, std::vector<_tZWaveDevice *>> m_deviceIndex;
 	std::shared_ptr<std::thread> m_thread;
 };
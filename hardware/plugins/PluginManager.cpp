@@ -32,6 +32,7 @@
 #include "../../main/EventsPythonModule.h"
 
 #define MINIMUM_PYTHON_VERSION "3.4.0"
+#define MAXIMUM_IO_THREADS 8
 
 #define ATTRIBUTE_VALUE(pElement, Name, Value) \
 		{	\
@@ -302,16 +303,24 @@ namespace Plugins {
 			_log.Log(LOG_STATUS, "PluginSystem: %d plugins started.", (int)m_pPlugins.size());
 		}
 
-		// Create initial IO Service thread
+		// Size the IO Service pool, each connection's handlers are serialized by its own strand
+		int iIOThreads = 0;
+		m_sql.GetPreferencesVar("PluginIOThreads", iIOThreads);
+		if (iIOThreads <= 0)
+			iIOThreads = (int)std::thread::hardware_concurrency();
+		iIOThreads = std::min(std::max(iIOThreads, 1), MAXIMUM_IO_THREADS);
+
+		// Create IO Service threads
 		ios.restart();
 		// Create some work to keep IO Service alive
 		auto work = boost::asio::io_service::work(ios);
 		boost::thread_group BoostThreads;
-		for (int i = 0; i < 1; i++)
+		for (int i = 0; i < iIOThreads; i++)
 		{
 			boost::thread*	bt = BoostThreads.create_thread(BoostWorkers);
 			SetThreadName(bt->native_handle(), "Plugin_ASIO");
 		}
+		_log.Log(LOG_STATUS, "PluginSystem: %d IO thread(s) started.", iIOThreads);
 
 		while (!IsStopRequested(500))
 		{
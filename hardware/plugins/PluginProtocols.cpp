@@ -7,6 +7,7 @@
 
 #include "PluginMessages.h"
 #include "PluginProtocols.h"
+#include "PluginTransports.h"
 #include "../../main/Helper.h"
 #include "../../main/json_helper.h"
 #include "../../main/Logger.h"
@@ -16,6 +17,55 @@
 
 namespace Plugins {
 
+	// Queue a framed message for the plugin and count it in the connection's statistics
+	static void QueueMessage(onMessageCallback *pMessage)
+	{
+		if (pMessage->m_pConnection && pMessage->m_pConnection->pTransport)
+			pMessage->m_pConnection->pTransport->MessageReceived();
+		pMessage->m_pPlugin->MessagePlugin(pMessage);
+	}
+
+	void CPluginBuffer::append(const std::vector<byte> &vData)
+	{
+		// Reclaim consumed space once it is at least half the buffer, this keeps appends amortised constant time
+		if (m_iStart && (m_iStart >= (m_vData.size() / 2)))
+		{
+			m_vData.erase(m_vData.begin(), m_vData.begin() + m_iStart);
+			m_iStart = 0;
+		}
+		m_vData.insert(m_vData.end(), vData.begin(), vData.end());
+	}
+
+	void CPluginBuffer::consume(size_t iLength)
+	{
+		m_iStart += std::min(iLength, size());
+		if (m_iStart == m_vData.size())
+			clear();
+	}
+
+	size_t CPluginBuffer::find(const std::string &sDelimiter, size_t iFrom) const
+	{
+		if (iFrom >= size())
+			return std::string::npos;
+		const byte *pEnd = data() + size();
+		const byte *pPos = std::search(data() + iFrom, pEnd, sDelimiter.begin(), sDelimiter.end());
+		return (pPos == pEnd) ? std::string::npos : (size_t)(pPos - data());
+	}
+
+	std::string CPluginBuffer::string(size_t iOffset, size_t iLength) const
+	{
+		iOffset = std::min(iOffset, size());
+		iLength = std::min(iLength, size() - iOffset);
+		return std::string((const char *)data() + iOffset, iLength);
+	}
+
+	std::vector<byte> CPluginBuffer::vector(size_t iOffset, size_t iLength) const
+	{
+		iOffset = std::min(iOffset, size());
+		iLength = std::min(iLength, size() - iOffset);
+		return std::vector<byte>(data() + iOffset, data() + iOffset + iLength);
+	}
+
 	CPluginProtocol *CPluginProtocol::Create(const std::string &sProtocol)
 	{
 		if (sProtocol == "Line") return (CPluginProtocol*) new CPluginProtocolLine();
@@ -46,7 +96,7 @@ namespace Plugins {
 	void CPluginProtocol::ProcessInbound(const ReadEvent* Message)
 	{
 		// Raw protocol is to just always dispatch data to plugin without interpretation
-		Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, Message->m_Buffer));
+		QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, Message->m_Buffer));
 	}
 
 	std::vector<byte> CPluginProtocol::ProcessOutbound(const WriteDirective* WriteMessage)
@@ -87,7 +137,7 @@ namespace Plugins {
 		if (!m_sRetainedData.empty())
 		{
 			// Forced buffer clear, make sure the plugin gets a look at the data in case it wants it
-			pPlugin->MessagePlugin(new onMessageCallback(pPlugin, pConnection, m_sRetainedData));
+			QueueMessage(new onMessageCallback(pPlugin, pConnection, m_sRetainedData.vector()));
 			m_sRetainedData.clear();
 		}
 	}
@@ -97,21 +147,25 @@ namespace Plugins {
 		//
 		//	Handles the cases where a read contains a partial message or multiple messages
 		//
-		std::vector<byte>	vData = m_sRetainedData;										// if there was some data left over from last time add it back in
-		vData.insert(vData.end(), Message->m_Buffer.begin(), Message->m_Buffer.end());		// add the new data
+		m_sRetainedData.append(Message->m_Buffer);		// add the new data to any left over from last time
 
-		std::string		sData(vData.begin(), vData.end());
-		int iPos = sData.find_first_of('\r');		//  Look for message terminator
+		size_t iPos = m_sRetainedData.find("\r", m_iScanned);		//  Look for message terminator
 		while (iPos != std::string::npos)
 		{
-			Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, std::vector<byte>(&sData[0], &sData[iPos])));
+			QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, m_sRetainedData.vector(0, iPos)));
 
-			if (sData[iPos + 1] == '\n') iPos++;				//  Handle \r\n
-			sData = sData.substr(iPos + 1);
-			iPos = sData.find_first_of('\r');
+			if ((iPos + 1 < m_sRetainedData.size()) && (m_sRetainedData[iPos + 1] == '\n')) iPos++;		//  Handle \r\n
+			m_sRetainedData.consume(iPos + 1);
+			iPos = m_sRetainedData.find("\r");
 		}
 
-		m_sRetainedData.assign(sData.c_str(), sData.c_str() + sData.length()); // retain any residual for next time
+		m_iScanned = m_sRetainedData.size(); // residual is retained for next time, no need to search it again
+	}
+
+	void CPluginProtocolLine::Flush(CPlugin *pPlugin, CConnection *pConnection)
+	{
+		CPluginProtocol::Flush(pPlugin, pConnection);
+		m_iScanned = 0;
 	}
 
 	static void AddBytesToDict(PyObject* pDict, const char* key, const std::string& value)
@@ -310,57 +364,82 @@ namespace Plugins {
 		return sJson;
 	}
 
+	static long BraceBalance(const byte *pData, size_t iLength)
+	{
+		long iBalance = 0;
+		for (size_t i = 0; i < iLength; i++)
+		{
+			if (pData[i] == '{')
+				iBalance++;
+			else if (pData[i] == '}')
+				iBalance--;
+		}
+		return iBalance;
+	}
+
+	void CPluginProtocolJSON::DispatchMessage(const ReadEvent *Message, const std::string &sMessage)
+	{
+		Json::Value root;
+		bool bRet = ParseJSon(sMessage, root);
+		if ((!bRet) || (!root.isObject()))
+		{
+			_log.Log(LOG_ERROR, "JSON Protocol: Parse Error on '%s'", sMessage.c_str());
+			QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, sMessage));
+		}
+		else
+		{
+			PyObject *pMessage = JSONtoPython(&root);
+			QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pMessage));
+		}
+	}
+
 	void CPluginProtocolJSON::ProcessInbound(const ReadEvent* Message)
 	{
 		//
 		//	Handles the cases where a read contains a partial message or multiple messages
 		//
-		std::vector<byte>	vData = m_sRetainedData;										// if there was some data left over from last time add it back in
-		vData.insert(vData.end(), Message->m_Buffer.begin(), Message->m_Buffer.end());		// add the new data
+		m_sRetainedData.append(Message->m_Buffer);		// add the new data to any left over from last time
+		m_iBraceBalance += BraceBalance(Message->m_Buffer.data(), Message->m_Buffer.size());
 
-		std::string		sData(vData.begin(), vData.end());
-		int iPos = 1;
-		while (iPos) {
-			Json::Value		root;
-			iPos = sData.find("}{", 0) + 1;		//  Look for message separater in case there is more than one
-			if (!iPos) // no, just one or part of one
-			{
-				if ((sData.substr(sData.length() - 1, 1) == "}") &&
-					(std::count(sData.begin(), sData.end(), '{') == std::count(sData.begin(), sData.end(), '}'))) // whole message so queue the whole buffer
-				{
-					bool bRet = ParseJSon(sData, root);
-					if ((!bRet) || (!root.isObject()))
-					{
-						_log.Log(LOG_ERROR, "JSON Protocol: Parse Error on '%s'", sData.c_str());
-						Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, sData));
-					}
-					else
-					{
-						PyObject* pMessage = JSONtoPython(&root);
-						Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pMessage));
-					}
-					sData.clear();
-				}
-			}
-			else  // more than one message so queue the first one
+		while (!m_sRetainedData.empty())
+		{
+			size_t iPos = m_sRetainedData.find("}{", m_iScanned);		//  Look for message separater in case there is more than one
+			if (iPos == std::string::npos) // no, just one or part of one
 			{
-				std::string sMessage = sData.substr(0, iPos);
-				sData = sData.substr(iPos);
-				bool bRet = ParseJSon(sMessage, root);
-				if ((!bRet) || (!root.isObject()))
+				if ((m_sRetainedData[m_sRetainedData.size() - 1] == '}') && (m_iBraceBalance == 0)) // whole message so queue the whole buffer
 				{
-					_log.Log(LOG_ERROR, "JSON Protocol: Parse Error on '%s'", sData.c_str());
-					Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, sMessage));
+					DispatchMessage(Message, m_sRetainedData.string());
+					m_sRetainedData.clear();
+					m_iScanned = 0;
 				}
 				else
 				{
-					PyObject* pMessage = JSONtoPython(&root);
-					Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pMessage));
+					// Separator may straddle the next read so rescan the last byte
+					m_iScanned = m_sRetainedData.size() - 1;
 				}
+				break;
 			}
+
+			// more than one message so queue the first one
+			m_iBraceBalance -= BraceBalance(m_sRetainedData.data(), iPos + 1);
+			std::string sMessage = m_sRetainedData.string(0, iPos + 1);
+			m_sRetainedData.consume(iPos + 1);
+			m_iScanned = 0;
+			DispatchMessage(Message, sMessage);
 		}
 
-		m_sRetainedData.assign(sData.c_str(), sData.c_str() + sData.length()); // retain any residual for next time
+		if (m_sRetainedData.empty())
+		{
+			m_iBraceBalance = 0;
+			m_iScanned = 0;
+		}
+	}
+
+	void CPluginProtocolJSON::Flush(CPlugin *pPlugin, CConnection *pConnection)
+	{
+		CPluginProtocol::Flush(pPlugin, pConnection);
+		m_iBraceBalance = 0;
+		m_iScanned = 0;
 	}
 
 	void CPluginProtocolXML::ProcessInbound(const ReadEvent* Message)
@@ -369,10 +448,7 @@ namespace Plugins {
 		//	Only returns whole XML messages. Does not handle <tag /> as the top level tag
 		//	Handles the cases where a read contains a partial message or multiple messages
 		//
-		std::vector<byte>	vData = m_sRetainedData;										// if there was some data left over from last time add it back in
-		vData.insert(vData.end(), Message->m_Buffer.begin(), Message->m_Buffer.end());		// add the new data
-
-		std::string		sData(vData.begin(), vData.end());
+		m_sRetainedData.append(Message->m_Buffer);		// add the new data to any left over from last time
 		try
 		{
 			while (true)
@@ -382,53 +458,60 @@ namespace Plugins {
 				//
 				if (!m_Tag.length())
 				{
-					if (sData.find("<?xml") != std::string::npos)	// step over '<?xml version="1.0" encoding="utf-8"?>' if present
+					size_t iDecl = m_sRetainedData.find("<?xml");
+					if (iDecl != std::string::npos)	// step over '<?xml version="1.0" encoding="utf-8"?>' if present
 					{
-						int iEnd = sData.find("?>");
-						sData = sData.substr(iEnd + 2);
+						size_t iEnd = m_sRetainedData.find("?>", iDecl);
+						if (iEnd == std::string::npos)
+							break;
+						m_sRetainedData.consume(iEnd + 2);
 					}
 
-					int iStart = sData.find_first_of('<');
+					size_t iStart = m_sRetainedData.find("<");
 					if (iStart == std::string::npos)
 					{
 						// start of a tag not found so discard
 						m_sRetainedData.clear();
 						break;
 					}
-					if (iStart) sData = sData.substr(iStart);		// remove any leading data
-					int iEnd = sData.find_first_of(" >");
-					if (iEnd != std::string::npos)
-					{
-						m_Tag = sData.substr(1, (iEnd - 1));
-					}
+					m_sRetainedData.consume(iStart);		// remove any leading data
+					size_t iEnd = std::min(m_sRetainedData.find(" "), m_sRetainedData.find(">"));
+					if (iEnd == std::string::npos)
+						break;
+					m_Tag = m_sRetainedData.string(1, iEnd - 1);
+					m_iScanned = 0;
 				}
 
-				int	iPos = sData.find("</" + m_Tag + ">");
+				std::string sClosingTag = "</" + m_Tag + ">";
+				size_t iPos = m_sRetainedData.find(sClosingTag, m_iScanned);
 				if (iPos != std::string::npos)
 				{
-					int iEnd = iPos + m_Tag.length() + 3;
-					Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, sData.substr(0, iEnd)));
+					size_t iEnd = iPos + sClosingTag.length();
+					QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, m_sRetainedData.string(0, iEnd)));
 
-					if (iEnd == sData.length())
-					{
-						sData.clear();
-					}
-					else
-					{
-						sData = sData.substr(++iEnd);
-					}
+					m_sRetainedData.consume(iEnd + 1);	// also steps over the character following the closing tag
 					m_Tag = "";
+					m_iScanned = 0;
 				}
 				else
+				{
+					// Closing tag may straddle the next read so leave room to match it
+					m_iScanned = (m_sRetainedData.size() >= sClosingTag.length()) ? m_sRetainedData.size() - sClosingTag.length() + 1 : 0;
 					break;
+				}
 			}
 		}
 		catch (std::exception const& exc)
 		{
-			_log.Log(LOG_ERROR, "(CPluginProtocolXML::ProcessInbound) Unexpected exception thrown '%s', Data '%s'.", exc.what(), sData.c_str());
+			_log.Log(LOG_ERROR, "(CPluginProtocolXML::ProcessInbound) Unexpected exception thrown '%s', Data '%s'.", exc.what(), m_sRetainedData.string().c_str());
 		}
+	}
 
-		m_sRetainedData.assign(sData.c_str(), sData.c_str() + sData.length()); // retain any residual for next time
+	void CPluginProtocolXML::Flush(CPlugin *pPlugin, CConnection *pConnection)
+	{
+		CPluginProtocol::Flush(pPlugin, pConnection);
+		m_Tag = "";
+		m_iScanned = 0;
 	}
 
 	void CPluginProtocolHTTP::ExtractHeaders(std::string* pData)
@@ -499,18 +582,39 @@ namespace Plugins {
 			ProcessInbound(new ReadEvent(pPlugin, pConnection, 0, nullptr));
 			m_sRetainedData.clear();
 		}
+		// The next message starts from scratch, don't wait for the rest of the flushed one
+		m_iMessageLength = 0;
+		m_bAwaitingLastChunk = false;
+		m_ContentLength = 0;
+		m_Chunked = false;
+		m_RemainingChunk = 0;
+		m_Status.clear();
 	}
 
 	void CPluginProtocolHTTP::ProcessInbound(const ReadEvent* Message)
 	{
 		// There won't be a buffer if the connection closed
+		size_t iPrevious = m_sRetainedData.size();
 		if (!Message->m_Buffer.empty())
 		{
-			m_sRetainedData.insert(m_sRetainedData.end(), Message->m_Buffer.begin(), Message->m_Buffer.end());
+			m_sRetainedData.append(Message->m_Buffer);
+
+			// Don't reparse a partial message until the data that can complete it has arrived
+			if (m_iMessageLength && (m_sRetainedData.size() < m_iMessageLength))
+			{
+				return;
+			}
+			// the last chunk line or its terminator may have started arriving in the tail of the previous read
+			if (m_bAwaitingLastChunk && (m_sRetainedData.find("\n0", (iPrevious > 256) ? iPrevious - 256 : 0) == std::string::npos))
+			{
+				return;
+			}
 		}
+		m_iMessageLength = 0;
+		m_bAwaitingLastChunk = false;
 
 		// HTML is non binary so use strings
-		std::string		sData(m_sRetainedData.begin(), m_sRetainedData.end());
+		std::string		sData = m_sRetainedData.string();
 
 		m_ContentLength = -1;
 		m_Chunked = false;
@@ -594,9 +698,13 @@ namespace Plugins {
 								_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", "HTTP", "Data", sData.c_str());
 						}
 
-						Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
+						QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
 						m_sRetainedData.clear();
 					}
+					else if (m_ContentLength > (int)sData.length())
+					{
+						m_iMessageLength = m_sRetainedData.size() - sData.length() + m_ContentLength;
+					}
 				}
 				else
 				{
@@ -644,7 +752,7 @@ namespace Plugins {
 										_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", "HTTP", "Data", sPayload.c_str());
 								}
 
-								Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
+								QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
 								m_sRetainedData.clear();
 								break;
 							}
@@ -659,6 +767,7 @@ namespace Plugins {
 						sData = sData.substr(m_RemainingChunk);
 						m_RemainingChunk = 0;
 					}
+					m_bAwaitingLastChunk = !m_sRetainedData.empty();
 				}
 			}
 		}
@@ -708,9 +817,13 @@ namespace Plugins {
 							_log.Log(LOG_ERROR, "(%s) failed to add key '%s', value '%s' to dictionary.", "HTTP", "Data", sPayload.c_str());
 					}
 
-					Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, DataDict));
+					QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, DataDict));
 					m_sRetainedData.clear();
 				}
+				else if (m_ContentLength > (int)sPayload.length())
+				{
+					m_iMessageLength = m_sRetainedData.size() - sPayload.length() + m_ContentLength;
+				}
 			}
 		}
 	}
@@ -1161,7 +1274,7 @@ namespace Plugins {
 
 		if (pDataDict)
 		{
-			Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
+			QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
 		}
 	}
 
@@ -1208,7 +1321,7 @@ namespace Plugins {
 		}
 
 		byte loop = 0;
-		m_sRetainedData.insert(m_sRetainedData.end(), Message->m_Buffer.begin(), Message->m_Buffer.end());
+		m_sRetainedData.append(Message->m_Buffer);
 
 		do {
 			std::vector<byte>::iterator it = m_sRetainedData.begin();
@@ -1471,9 +1584,9 @@ namespace Plugins {
 				m_bErrored = true;
 			}
 
-			if (!m_bErrored) Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pMqttDict));
+			if (!m_bErrored) QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pMqttDict));
 
-			m_sRetainedData.erase(m_sRetainedData.begin(), pktend);
+			m_sRetainedData.consume(std::distance(m_sRetainedData.begin(), pktend));
 		} while (!m_bErrored && !m_sRetainedData.empty());
 
 		if (m_bErrored)
@@ -1835,7 +1948,7 @@ namespace Plugins {
 
 	*/
 
-	bool CPluginProtocolWS::ProcessWholeMessage(std::vector<byte>& vMessage, const ReadEvent* Message)
+	bool CPluginProtocolWS::ProcessWholeMessage(CPluginBuffer& vMessage, const ReadEvent* Message)
 	{
 		while (!vMessage.empty())
 		{
@@ -1975,10 +2088,10 @@ namespace Plugins {
 					_log.Log(LOG_ERROR, "(%s) failed to add key '%s' to dictionary.", __func__, "Payload");
 			}
 
-			Message->m_pPlugin->MessagePlugin(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
+			QueueMessage(new onMessageCallback(Message->m_pPlugin, Message->m_pConnection, pDataDict));
 
 			// Remove the processed message from retained data
-			vMessage.erase(vMessage.begin(), vMessage.begin() + iOffset);
+			vMessage.consume(iOffset);
 
 			return true;
 		}
@@ -1990,14 +2103,15 @@ namespace Plugins {
 	{
 		//	Although messages can be fragmented, control messages can be inserted in between fragments
 		//	so try to process just the message first, then retained data and the message
-		std::vector<byte>	Buffer = Message->m_Buffer;
+		CPluginBuffer	Buffer;
+		Buffer.append(Message->m_Buffer);
 		if (ProcessWholeMessage(Buffer, Message))
 		{
 			return;		// Message processed
 		}
 
 		// Add new message to retained data, process all messages if this one is the finish of a message
-		m_sRetainedData.insert(m_sRetainedData.end(), Message->m_Buffer.begin(), Message->m_Buffer.end());
+		m_sRetainedData.append(Message->m_Buffer);
 
 		// Always process the whole buffer because we can't know if we have whole, multiple or even complete messages unless we work through from the start
 		if (ProcessWholeMessage(m_sRetainedData, Message))
@@ -4,10 +4,39 @@ namespace Plugins {
 
 	class CPluginMessage;
 
+	//
+	//	Receive buffer for protocols: data is appended at the end and consumed from the front without moving the remainder,
+	//	consumed space is only reclaimed once it makes up most of the allocation so each byte is copied a bounded number of times
+	//
+	class CPluginBuffer
+	{
+	private:
+		std::vector<byte>	m_vData;
+		size_t				m_iStart{ 0 };
+
+	public:
+		void				append(const std::vector<byte> &vData);
+		void				consume(size_t iLength);
+		size_t				find(const std::string &sDelimiter, size_t iFrom = 0) const;
+		void				clear()
+		{
+			m_vData.clear();
+			m_iStart = 0;
+		};
+		bool				empty() const { return m_iStart == m_vData.size(); };
+		size_t				size() const { return m_vData.size() - m_iStart; };
+		const byte *		data() const { return m_vData.data() + m_iStart; };
+		byte &				operator[](size_t iOffset) { return m_vData[m_iStart + iOffset]; };
+		std::vector<byte>::iterator begin() { return m_vData.begin() + m_iStart; };
+		std::vector<byte>::iterator end() { return m_vData.end(); };
+		std::string			string(size_t iOffset = 0, size_t iLength = std::string::npos) const;
+		std::vector<byte>	vector(size_t iOffset = 0, size_t iLength = std::string::npos) const;
+	};
+
 	class CPluginProtocol
 	{
 	protected:
-		std::vector<byte>	m_sRetainedData;
+		CPluginBuffer	m_sRetainedData;
 		bool m_Secure{ false };
 
 	      public:
@@ -23,25 +52,34 @@ namespace Plugins {
 
 	class CPluginProtocolLine : CPluginProtocol
 	{
+		size_t			m_iScanned{ 0 };	// leading bytes of retained data already known not to hold a terminator
 		void ProcessInbound(const ReadEvent *Message) override;
+		void Flush(CPlugin *pPlugin, CConnection *pConnection) override;
 	};
 
 	class CPluginProtocolXML : CPluginProtocol
 	{
 	private:
 		std::string		m_Tag;
+		size_t			m_iScanned{ 0 };	// leading bytes of retained data already searched for the closing tag
 	public:
 	  void ProcessInbound(const ReadEvent *Message) override;
+	  void Flush(CPlugin *pPlugin, CConnection *pConnection) override;
 	};
 
 	class CPluginProtocolJSON : CPluginProtocol
 	{
+	private:
+		long			m_iBraceBalance{ 0 };	// count of '{' less count of '}' in retained data
+		size_t			m_iScanned{ 0 };		// leading bytes of retained data already searched for a message separator
+		void			DispatchMessage(const ReadEvent *Message, const std::string &sMessage);
 	protected:
 		PyObject* JSONtoPython(Json::Value* pJSON);
 	public:
 	  PyObject *JSONtoPython(const std::string &sJSON);
 	  std::string PythontoJSON(PyObject *pDict);
 	  void ProcessInbound(const ReadEvent *Message) override;
+	  void Flush(CPlugin *pPlugin, CConnection *pConnection) override;
 	};
 
 	class CPluginProtocolHTTP : public CPluginProtocol
@@ -52,6 +90,8 @@ namespace Plugins {
 		void*			m_Headers;
 		bool			m_Chunked;
 		size_t			m_RemainingChunk;
+		size_t			m_iMessageLength;	// total length of a partially received message when known from its headers
+		bool			m_bAwaitingLastChunk;	// chunked message is incomplete until the zero length chunk arrives
 	protected:
 		void			ExtractHeaders(std::string*	pData);
 		void Flush(CPlugin *pPlugin, CConnection *pConnection) override;
@@ -62,6 +102,8 @@ namespace Plugins {
 			, m_Headers(nullptr)
 			, m_Chunked(false)
 			, m_RemainingChunk(0)
+			, m_iMessageLength(0)
+			, m_bAwaitingLastChunk(false)
 		{
 			m_Secure = Secure;
 		};
@@ -72,7 +114,7 @@ namespace Plugins {
 	class CPluginProtocolWS : public CPluginProtocolHTTP
 	{
 	private:
-		bool	ProcessWholeMessage(std::vector<byte> &vMessage, const ReadEvent * Message);
+		bool	ProcessWholeMessage(CPluginBuffer &vMessage, const ReadEvent * Message);
 	public:
 		CPluginProtocolWS(bool Secure) : CPluginProtocolHTTP(Secure) {};
 		void ProcessInbound(const ReadEvent *Message) override;
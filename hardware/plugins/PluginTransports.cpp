@@ -25,7 +25,7 @@ namespace Plugins {
 				m_Timer = new boost::asio::deadline_timer(ios);
 			}
 			m_Timer->expires_from_now(boost::posix_time::milliseconds(m_pConnection->Timeout));
-			m_Timer->async_wait([this](const boost::system::error_code &ec) { handleTimeout(ec); });
+			m_Timer->async_wait(boost::asio::bind_executor(m_Strand, [this](const boost::system::error_code &ec) { handleTimeout(ec); }));
 		}
 		else
 		{
@@ -121,7 +121,7 @@ namespace Plugins {
 				//
 				//	Async resolve/connect based on http://www.boost.org/doc/libs/1_45_0/doc/html/boost_asio/example/http/client/async_client.cpp
 				//
-				m_Resolver.async_resolve(query, [this](auto &&err, auto end) { handleAsyncResolve(err, end); });
+				m_Resolver.async_resolve(query, boost::asio::bind_executor(m_Strand, [this](auto &&err, auto end) { handleAsyncResolve(err, end); }));
 			}
 		}
 		catch (std::exception& e)
@@ -146,7 +146,7 @@ namespace Plugins {
 		if (!err)
 		{
 			boost::asio::ip::tcp::endpoint endpoint = *endpoint_iterator;
-			m_Socket->async_connect(endpoint, [this, endpoint_iterator](auto &&err) mutable { handleAsyncConnect(err, ++endpoint_iterator); });
+			m_Socket->async_connect(endpoint, boost::asio::bind_executor(m_Strand, [this, endpoint_iterator](auto &&err) mutable { handleAsyncConnect(err, ++endpoint_iterator); }));
 		}
 		else
 		{
@@ -174,7 +174,7 @@ namespace Plugins {
 		{
 			m_bConnected = true;
 			m_tLastSeen = time(nullptr);
-			m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+			m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), boost::asio::bind_executor(m_Strand, [this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 			configureTimeout();
 		}
 		else
@@ -206,7 +206,7 @@ namespace Plugins {
 				//	Acceptor based on http://www.boost.org/doc/libs/1_62_0/doc/html/boost_asio/tutorial/tutdaytime3/src.html
 				//
 				auto pSocket = new boost::asio::ip::tcp::socket(ios);
-				m_Acceptor->async_accept(*pSocket, [this, pSocket](auto &&err) { handleAsyncAccept(pSocket, err); });
+				m_Acceptor->async_accept(*pSocket, boost::asio::bind_executor(m_Strand, [this, pSocket](auto &&err) { handleAsyncAccept(pSocket, err); }));
 				m_bConnecting = true;
 			}
 		}
@@ -275,7 +275,7 @@ namespace Plugins {
 			}
 
 			pTcpTransport->m_Socket->async_read_some(boost::asio::buffer(pTcpTransport->m_Buffer, sizeof pTcpTransport->m_Buffer),
-								 [pTcpTransport](auto &&err, auto bytes) { pTcpTransport->handleRead(err, bytes); });
+								 boost::asio::bind_executor(pTcpTransport->m_Strand, [pTcpTransport](auto &&err, auto bytes) { pTcpTransport->handleRead(err, bytes); }));
 
 			// Requeue listener
 			if (m_Acceptor)
@@ -308,12 +308,12 @@ namespace Plugins {
 			pPlugin->MessagePlugin(new ReadEvent(pPlugin, m_pConnection, bytes_transferred, m_Buffer));
 
 			m_tLastSeen = time(nullptr);
-			m_iTotalBytes += bytes_transferred;
+			RecordRead(bytes_transferred);
 
 			//ready for next read
 			if (m_Socket)
 			{
-				m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_Socket->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), boost::asio::bind_executor(m_Strand, [this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 				configureTimeout();
 			}
 		}
@@ -356,7 +356,7 @@ namespace Plugins {
 			try
 			{
 				int	iSentBytes = boost::asio::write(*m_Socket, boost::asio::buffer(pMessage, pMessage.size()));
-				m_iTotalBytes += iSentBytes;
+				RecordWrite(iSentBytes);
 				if (iSentBytes != pMessage.size())
 				{
 					CPlugin* pPlugin = ((CConnection*)m_pConnection)->pPlugin;
@@ -430,7 +430,7 @@ namespace Plugins {
 			try
 			{
 				int		iSentBytes = boost::asio::write(*m_TLSSock, boost::asio::buffer(pMessage, pMessage.size()));
-				m_iTotalBytes += iSentBytes;
+				RecordWrite(iSentBytes);
 				if (iSentBytes != pMessage.size())
 				{
 					CPlugin* pPlugin = ((CConnection*)m_pConnection)->pPlugin;
@@ -497,7 +497,7 @@ namespace Plugins {
 				pPlugin->MessagePlugin(new onConnectCallback(pPlugin, m_pConnection, err.value(), err.message()));
 
 				m_tLastSeen = time(nullptr);
-				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), boost::asio::bind_executor(m_Strand, [this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 				configureTimeout();
 			}
 			catch (boost::system::system_error se)
@@ -556,12 +556,12 @@ namespace Plugins {
 			pPlugin->MessagePlugin(new ReadEvent(pPlugin, m_pConnection, bytes_transferred, m_Buffer));
 
 			m_tLastSeen = time(nullptr);
-			m_iTotalBytes += bytes_transferred;
+			RecordRead(bytes_transferred);
 
 			//ready for next read
 			if (m_TLSSock)
 			{
-				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_TLSSock->async_read_some(boost::asio::buffer(m_Buffer, sizeof m_Buffer), boost::asio::bind_executor(m_Strand, [this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 				configureTimeout();
 			}
 		}
@@ -642,7 +642,7 @@ namespace Plugins {
 				}
 			}
 
-			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_remote_endpoint, [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_remote_endpoint, boost::asio::bind_executor(m_Strand, [this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 
 			m_bConnected = true;
 		}
@@ -693,7 +693,7 @@ namespace Plugins {
 			pConnection->pPlugin->MessagePlugin(new ReadEvent(pConnection->pPlugin, pConnection, bytes_transferred, m_Buffer));
 
 			m_tLastSeen = time(nullptr);
-			m_iTotalBytes += bytes_transferred;
+			RecordRead(bytes_transferred);
 
 			// Make sure only the only Message objects are referring to Connection so that it is cleaned up right after plugin onMessage
 			Py_DECREF(pConnection);
@@ -747,11 +747,13 @@ namespace Plugins {
 				m_Socket->set_option(boost::asio::socket_base::broadcast(true));
 				boost::asio::ip::udp::endpoint destination(boost::asio::ip::address_v4::broadcast(), atoi(m_Port.c_str()));
 				int bytes_transferred = m_Socket->send_to(boost::asio::buffer(pMessage, pMessage.size()), destination);
+				RecordWrite(bytes_transferred);
 			}
 			else
 			{
 				boost::asio::ip::udp::endpoint destination(boost::asio::ip::address::from_string(m_IP.c_str()), atoi(m_Port.c_str()));
 				int bytes_transferred = m_Socket->send_to(boost::asio::buffer(pMessage, pMessage.size()), destination);
+				RecordWrite(bytes_transferred);
 			}
 		}
 		catch (boost::system::system_error err)
@@ -823,7 +825,7 @@ namespace Plugins {
 			std::vector<byte>	vBody(&body[0], &body[body.length()]);
 			handleWrite(vBody);
 
-			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+			m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, boost::asio::bind_executor(m_Strand, [this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 		}
 		else
 		{
@@ -851,11 +853,11 @@ namespace Plugins {
 				//
 				//	Async resolve/connect based on http://www.boost.org/doc/libs/1_51_0/doc/html/boost_asio/example/icmp/ping.cpp
 				//
-				m_Resolver.async_resolve(query, [this](auto &&err, auto i) { handleAsyncResolve(err, i); });
+				m_Resolver.async_resolve(query, boost::asio::bind_executor(m_Strand, [this](auto &&err, auto i) { handleAsyncResolve(err, i); }));
 			}
 			else
 			{
-				m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, [this](auto &&err, auto bytes) { handleRead(err, bytes); });
+				m_Socket->async_receive_from(boost::asio::buffer(m_Buffer, sizeof m_Buffer), m_Endpoint, boost::asio::bind_executor(m_Strand, [this](auto &&err, auto bytes) { handleRead(err, bytes); }));
 			}
 		}
 		catch (std::exception& e)
@@ -935,7 +937,7 @@ namespace Plugins {
 				pPlugin->MessagePlugin(new ReadEvent(pPlugin, m_pConnection, bytes_transferred, m_Buffer, (iMsElapsed ? iMsElapsed : 1)));
 
 				m_tLastSeen = time(nullptr);
-				m_iTotalBytes += bytes_transferred;
+				RecordRead(bytes_transferred);
 			}
 
 			// Set up listener again
@@ -982,7 +984,7 @@ namespace Plugins {
 			m_Timer = new boost::asio::deadline_timer(ios);
 		}
 		m_Timer->expires_from_now(boost::posix_time::seconds(5));
-		m_Timer->async_wait([this](auto &&err) { handleTimeout(err); });
+		m_Timer->async_wait(boost::asio::bind_executor(m_Strand, [this](auto &&err) { handleTimeout(err); }));
 
 		// Create an ICMP header for an echo request.
 		icmp_header echo_request;
@@ -1004,7 +1006,7 @@ namespace Plugins {
 
 		// Send the request and mark the time
 		m_Clock = clock();
-		m_Socket->send_to(request_buffer.data(), m_Endpoint);
+		RecordWrite(m_Socket->send_to(request_buffer.data(), m_Endpoint));
 	}
 
 	bool CPluginTransportICMP::handleDisconnect()
@@ -1115,7 +1117,7 @@ namespace Plugins {
 			pPlugin->MessagePlugin(new ReadEvent(pPlugin, m_pConnection, bytes_transferred, (const unsigned char*)data));
 			configureTimeout();
 			m_tLastSeen = time(nullptr);
-			m_iTotalBytes += bytes_transferred;
+			RecordRead(bytes_transferred);
 		}
 		else
 		{
@@ -1128,6 +1130,7 @@ namespace Plugins {
 		if (!data.empty())
 		{
 			write((const char *)&data[0], data.size());
+			RecordWrite(data.size());
 		}
 	}
 
@@ -2,6 +2,7 @@
 
 #include "../ASyncSerial.h"
 #include <boost/asio.hpp>
+#include <atomic>
 #include <ctime>
 
 namespace Plugins {
@@ -17,7 +18,10 @@ namespace Plugins {
 		bool			m_bDisconnectQueued;
 		bool			m_bConnecting;
 		bool			m_bConnected;
-		long			m_iTotalBytes;
+		std::atomic<long>	m_iBytesIn;
+		std::atomic<long>	m_iBytesOut;
+		std::atomic<long>	m_iMessagesIn;
+		std::atomic<long>	m_iMessagesOut;
 		time_t			m_tLastSeen;
 
 		unsigned char	m_Buffer[4096];
@@ -26,10 +30,20 @@ namespace Plugins {
 
 	protected:
 		boost::asio::deadline_timer *m_Timer;
+		boost::asio::io_service::strand m_Strand;	// serializes this connection's handlers across the I/O pool
 		virtual void configureTimeout();
+		void RecordRead(std::size_t bytes)
+		{
+			m_iBytesIn += (long)bytes;
+		};
+		void RecordWrite(std::size_t bytes)
+		{
+			m_iBytesOut += (long)bytes;
+			m_iMessagesOut++;
+		};
 
 	      public:
-		CPluginTransport(int HwdID, CConnection *pConnection) : m_HwdID(HwdID), m_pConnection(pConnection), m_bDisconnectQueued(false), m_bConnecting(false), m_bConnected(false), m_iTotalBytes(0), m_tLastSeen(0), m_Timer(NULL)
+		CPluginTransport(int HwdID, CConnection *pConnection) : m_HwdID(HwdID), m_pConnection(pConnection), m_bDisconnectQueued(false), m_bConnecting(false), m_bConnected(false), m_iBytesIn(0), m_iBytesOut(0), m_iMessagesIn(0), m_iMessagesOut(0), m_tLastSeen(0), m_Timer(NULL), m_Strand(ios)
 	  {
 		  Py_INCREF(m_pConnection);
 	  };
@@ -50,7 +64,12 @@ namespace Plugins {
 		time_t				LastSeen() { return m_tLastSeen; };
 		virtual bool		AsyncDisconnect() { return false; };
 		virtual bool		ThreadPoolRequired() { return false; };
-		long				TotalBytes() { return m_iTotalBytes; };
+		long				TotalBytes() { return m_iBytesIn + m_iBytesOut; };
+		long				BytesIn() { return m_iBytesIn; };
+		long				BytesOut() { return m_iBytesOut; };
+		long				MessagesIn() { return m_iMessagesIn; };
+		long				MessagesOut() { return m_iMessagesOut; };
+		void				MessageReceived() { m_iMessagesIn++; };	// called by the protocol for every framed message it dispatches
 		virtual void		VerifyConnection();
 		CConnection *		Connection()
 		{
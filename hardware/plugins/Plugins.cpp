@@ -955,13 +955,7 @@ namespace Plugins
 		RequestStart();
 
 		// Flush the message queue (should already be empty)
-		{
-			std::lock_guard<std::mutex> l(m_QueueMutex);
-			while (!m_MessageQueue.empty())
-			{
-				m_MessageQueue.pop_front();
-			}
-		}
+		FlushMessageQueue();
 
 		// Start worker thread
 		try
@@ -1006,6 +1000,12 @@ namespace Plugins
 
 			RequestStop();
 
+			// Wake the worker so it notices the stop request even when nothing else is queued
+			{
+				std::lock_guard<std::mutex> l(m_QueueMutex);
+			}
+			m_QueueCondition.notify_one();
+
 			if (m_bIsStarted)
 			{
 				// If we have connections queue disconnects
@@ -1073,66 +1073,65 @@ namespace Plugins
 		return true;
 	}
 
+	CPluginMessageBase *CPlugin::PopReadyMessage()
+	{
+		std::lock_guard<std::mutex> l(m_QueueMutex);
+
+		// Move delayed messages that have fallen due behind anything already waiting
+		time_t Now = time(nullptr);
+		while (!m_DelayedQueue.empty() && (m_DelayedQueue.begin()->first <= Now))
+		{
+			m_MessageQueue.push_back(m_DelayedQueue.begin()->second);
+			m_DelayedQueue.erase(m_DelayedQueue.begin());
+		}
+
+		if (m_MessageQueue.empty())
+			return nullptr;
+
+		CPluginMessageBase *Message = m_MessageQueue.front();
+		m_MessageQueue.pop_front();
+		return Message;
+	}
+
+	void CPlugin::FlushMessageQueue()
+	{
+		std::lock_guard<std::mutex> l(m_QueueMutex);
+		m_MessageQueue.clear();
+		m_DelayedQueue.clear();
+	}
+
 	void CPlugin::Do_Work()
 	{
 		Log(LOG_STATUS, "(%s) Entering work loop.", m_Name.c_str());
 		m_LastHeartbeat = mytime(nullptr);
-		while (!IsStopRequested(50) || !m_bIsStopped)
+		while (!IsStopRequested(0) || !m_bIsStopped)
 		{
-			time_t Now = time(nullptr);
-			bool bProcessed = true;
-			while (bProcessed)
+			CPluginMessageBase *Message = nullptr;
+			while ((Message = PopReadyMessage()) != nullptr)
 			{
-				CPluginMessageBase *Message = nullptr;
-				bProcessed = false;
-
-				// Cycle once through the queue looking for the 1st message that is ready to process
+				try
 				{
-					std::lock_guard<std::mutex> l(m_QueueMutex);
-					for (size_t i = 0; i < m_MessageQueue.size(); i++)
+					const CPlugin *pPlugin = Message->Plugin();
+					if (pPlugin && (pPlugin->m_bDebug & PDM_QUEUE))
 					{
-						CPluginMessageBase *FrontMessage = m_MessageQueue.front();
-						m_MessageQueue.pop_front();
-						if (!FrontMessage->m_Delay || FrontMessage->m_When <= Now)
-						{
-							// Message is ready now or was already ready (this is the case for almost all messages)
-							Message = FrontMessage;
-							break;
-						}
-						// Message is for sometime in the future so requeue it (this happens when the 'Delay' parameter is used on a Send)
-						m_MessageQueue.push_back(FrontMessage);
+						_log.Log(LOG_NORM, "(" + pPlugin->m_Name + ") Processing '" + std::string(Message->Name()) + "' message");
 					}
+					Message->Process();
 				}
-
-				if (Message)
+				catch (...)
 				{
-					bProcessed = true;
-					try
-					{
-						const CPlugin *pPlugin = Message->Plugin();
-						if (pPlugin && (pPlugin->m_bDebug & PDM_QUEUE))
-						{
-							_log.Log(LOG_NORM, "(" + pPlugin->m_Name + ") Processing '" + std::string(Message->Name()) + "' message");
-						}
-						Message->Process();
-					}
-					catch (...)
-					{
-						_log.Log(LOG_ERROR, "PluginSystem: Exception processing message.");
-					}
+					_log.Log(LOG_ERROR, "PluginSystem: Exception processing message.");
 				}
+
 				// Free the memory for the message
-				if (Message)
-				{
-					std::lock_guard<std::mutex> l(PythonMutex); // Take mutex to guard access to CPluginTransport::m_pConnection inside the message
-					CPlugin *pPlugin = (CPlugin *)Message->Plugin();
-					pPlugin->RestoreThread();
-					delete Message;
-					pPlugin->ReleaseThread();
-				}
+				std::lock_guard<std::mutex> l(PythonMutex); // Take mutex to guard access to CPluginTransport::m_pConnection inside the message
+				CPlugin *pPlugin = (CPlugin *)Message->Plugin();
+				pPlugin->RestoreThread();
+				delete Message;
+				pPlugin->ReleaseThread();
 			}
 
-			if (Now >= (m_LastHeartbeat + m_iPollInterval))
+			if (time(nullptr) >= (m_LastHeartbeat + m_iPollInterval))
 			{
 				//	Add heartbeat to message queue
 				MessagePlugin(new onHeartbeatCallback(this));
@@ -1158,6 +1157,16 @@ namespace Plugins
 			{
 				Log(LOG_NORM, "(%s) Transport vector changed during %s loop, continuing.", m_Name.c_str(), __func__);
 			}
+
+			// Sleep until a message is queued, the first delayed message falls due or the next heartbeat is due
+			std::unique_lock<std::mutex> l(m_QueueMutex);
+			if (m_MessageQueue.empty() && !(IsStopRequested(0) && m_bIsStopped))
+			{
+				time_t tWakeUp = m_LastHeartbeat + m_iPollInterval;
+				if (!m_DelayedQueue.empty())
+					tWakeUp = std::min(tWakeUp, m_DelayedQueue.begin()->first);
+				m_QueueCondition.wait_until(l, std::chrono::system_clock::from_time_t(tWakeUp));
+			}
 		}
 
 		Log(LOG_STATUS, "(%s) Exiting work loop.", m_Name.c_str());
@@ -1990,9 +1999,15 @@ namespace Plugins
 			Log(LOG_NORM, "(" + m_Name + ") Pushing '" + std::string(pMessage->Name()) + "' on to queue");
 		}
 
-		// Add message to queue
-		std::lock_guard<std::mutex> l(m_QueueMutex);
-		m_MessageQueue.push_back(pMessage);
+		// Add message to queue, delayed messages are held aside until they fall due
+		{
+			std::lock_guard<std::mutex> l(m_QueueMutex);
+			if (pMessage->m_Delay && (pMessage->m_When > time(nullptr)))
+				m_DelayedQueue.emplace(pMessage->m_When, pMessage);
+			else
+				m_MessageQueue.push_back(pMessage);
+		}
+		m_QueueCondition.notify_one();
 	}
 
 	void CPlugin::DeviceAdded(const std::string DeviceID, int Unit)
@@ -2288,13 +2303,7 @@ namespace Plugins
 		m_bIsStarted = false;
 
 		// Flush the message queue (should already be empty)
-		{
-			std::lock_guard<std::mutex> l(m_QueueMutex);
-			while (!m_MessageQueue.empty())
-			{
-				m_MessageQueue.pop_front();
-			}
-		}
+		FlushMessageQueue();
 
 		m_bIsStopped = true;
 	}
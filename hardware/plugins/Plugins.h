@@ -1,5 +1,7 @@
 #pragma once
 
+#include <condition_variable>
+
 #include "../DomoticzHardware.h"
 #include "../hardwaretypes.h"
 #include "../../notifications/NotificationBase.h"
@@ -50,8 +52,10 @@ namespace Plugins {
 
 		std::mutex	m_TransportsMutex;
 		std::vector<CPluginTransport*>	m_Transports;
-		std::mutex m_QueueMutex; // controls access to the message queue
-		std::deque<CPluginMessageBase *> m_MessageQueue;
+		std::mutex m_QueueMutex; // controls access to the message queues
+		std::condition_variable m_QueueCondition; // signalled when a message is queued or a stop is requested
+		std::deque<CPluginMessageBase *> m_MessageQueue; // messages ready to be processed, in arrival order
+		std::multimap<time_t, CPluginMessageBase *> m_DelayedQueue; // delayed messages keyed on due time, equal keys keep arrival order
 
 		std::shared_ptr<std::thread> m_thread;
 
@@ -59,6 +63,8 @@ namespace Plugins {
 		bool m_bIsStopped;
 
 		void Do_Work();
+		CPluginMessageBase *PopReadyMessage();
+		void FlushMessageQueue();
 
 		void LogPythonException();
 		void LogPythonException(const std::string &);
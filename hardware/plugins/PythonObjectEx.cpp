@@ -768,6 +768,7 @@ namespace Plugins {
 			m_sql.safe_query("UPDATE DeviceStatus SET Name='%s', Description='%s', Used=%d, Type=%d, SubType=%d, SwitchType=%d, CustomImage=%d, Color='%s', SignalLevel=%d, BatteryLevel=%d, Options='%s', LastUpdate='%s' WHERE (HardwareID==%d) AND (DeviceID=='%s') AND (Unit==%d)", 
 								sName.c_str(), sDescription.c_str(), self->Used, iType, iSubType, iSwitchType, self->Image, sColor.c_str(), self->SignalLevel,
 								self->BatteryLevel, sOptionValue.c_str(), TimeToString(nullptr, TF_DateTime).c_str(), pModState->pPlugin->m_HwdID, sDeviceID.c_str(), self->Unit);
+			m_notifications.DeviceChanged(self->ID);
 			Py_END_ALLOW_THREADS
 
 			// Suppress Triggers updates non-key fields only (specifically NOT nValue or sValue)
@@ -991,6 +991,7 @@ namespace Plugins {
 					m_sql.UpdateDeviceValue("Options", iUsed, sID);
 					m_sql.safe_query("UPDATE DeviceStatus SET Options='%q', LastUpdate='%04d-%02d-%02d %02d:%02d:%02d' WHERE (HardwareID==%d) and (Unit==%d)",
 						sOptionValue.c_str(), ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec, self->HwdID, self->Unit);
+					m_notifications.DeviceChanged(self->ID);
 					Py_END_ALLOW_THREADS
 				}
 			}
@@ -1489,6 +1490,24 @@ namespace Plugins {
 		return PyBool_FromLong(0);
 	}
 
+	PyObject * CConnection_stats(CConnection * self)
+	{
+		PyObject *pDict = PyDict_New();
+		if (pDict && self->pTransport)
+		{
+			PyNewRef pBytesIn = PyLong_FromLong(self->pTransport->BytesIn());
+			PyDict_SetItemString(pDict, "BytesIn", pBytesIn);
+			PyNewRef pBytesOut = PyLong_FromLong(self->pTransport->BytesOut());
+			PyDict_SetItemString(pDict, "BytesOut", pBytesOut);
+			PyNewRef pMessagesIn = PyLong_FromLong(self->pTransport->MessagesIn());
+			PyDict_SetItemString(pDict, "MessagesIn", pMessagesIn);
+			PyNewRef pMessagesOut = PyLong_FromLong(self->pTransport->MessagesOut());
+			PyDict_SetItemString(pDict, "MessagesOut", pMessagesOut);
+		}
+
+		return pDict;
+	}
+
 	PyObject * CConnection_isconnecting(CConnection * self)
 	{
 		if (self->pTransport)
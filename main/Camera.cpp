@@ -15,12 +15,14 @@
 #include <json/json.h>
 
 #define CAMERA_POLL_INTERVAL 30
+#define CAMERA_SNAPSHOT_MAX_AGE 2
 
 extern std::string szUserDataFolder;
 
 CCameraHandler::CCameraHandler()
 {
 	m_seconds_counter = 0;
+	m_snapshotMaxAge = CAMERA_SNAPSHOT_MAX_AGE;
 }
 
 void CCameraHandler::ReloadCameras()
@@ -55,6 +57,24 @@ void CCameraHandler::ReloadCameras()
 		//Get Active Devices/Scenes
 		ReloadCameraActiveDevices(camera);
 	}
+
+	int nValue = CAMERA_SNAPSHOT_MAX_AGE;
+	m_sql.GetPreferencesVar("CameraSnapshotMaxAge", nValue);
+
+	//Drop cached frames, entries that are still referenced by a fetch or waiter are only invalidated
+	std::lock_guard<std::mutex> s(m_snapshotMutex);
+	m_snapshotMaxAge = (nValue < 0) ? 0 : nValue;
+	for (auto itt = m_snapshots.begin(); itt != m_snapshots.end();)
+	{
+		if ((itt->second.bFetching) || (itt->second.Waiters > 0))
+		{
+			itt->second.bCached = false;
+			itt->second.bReloaded = true;
+			++itt;
+		}
+		else
+			itt = m_snapshots.erase(itt);
+	}
 }
 
 void CCameraHandler::ReloadCameraActiveDevices(const std::string &CamID)
@@ -233,21 +253,86 @@ bool CCameraHandler::TakeUVCSnapshot(const std::string &device, std::vector<unsi
 
 bool CCameraHandler::TakeSnapshot(const uint64_t CamID, std::vector<unsigned char> &camimage)
 {
-	std::lock_guard<std::mutex> l(m_mutex);
-
-	cameraDevice *pCamera = GetCamera(CamID);
-	if (pCamera == nullptr)
+	//Only configured cameras get a cache entry, same lock order as ReloadCameras
+	std::unique_lock<std::mutex> cameraLock(m_mutex);
+	if (GetCamera(CamID) == nullptr)
 		return false;
+	std::unique_lock<std::mutex> lock(m_snapshotMutex);
+	cameraLock.unlock();
+	_tCameraSnapshot &snapshot = m_snapshots[CamID];
 
-	std::string szURL = GetCameraURL(pCamera);
-	szURL += "/" + pCamera->ImageURL;
-	stdreplace(szURL, "#USERNAME", pCamera->Username);
-	stdreplace(szURL, "#PASSWORD", pCamera->Password);
+	if (snapshot.bFetching)
+	{
+		//Someone is already fetching this camera, use that result
+		uint32_t generation = snapshot.Generation;
+		snapshot.Waiters++;
+		m_snapshotCondition.wait(lock, [&snapshot, generation] { return snapshot.Generation != generation; });
+		snapshot.Waiters--;
+		bool bRet = snapshot.bValid;
+		if (bRet)
+			camimage = snapshot.Image;
+		if ((!snapshot.bCached) && (snapshot.Waiters == 0) && (!snapshot.bFetching))
+			m_snapshots.erase(CamID);
+		return bRet;
+	}
+	if ((snapshot.bCached) && (std::chrono::steady_clock::now() - snapshot.FetchTime < std::chrono::seconds(m_snapshotMaxAge)))
+	{
+		camimage = snapshot.Image;
+		return true;
+	}
+
+	snapshot.bFetching = true;
+	snapshot.bReloaded = false;
+	lock.unlock();
+
+	std::vector<unsigned char> image;
+	bool bRet = FetchSnapshot(CamID, image);
+
+	lock.lock();
+	snapshot.bFetching = false;
+	snapshot.bValid = bRet;
+	//A frame fetched while the cameras were reloaded is handed to the waiters but not kept
+	snapshot.bCached = (bRet && !snapshot.bReloaded);
+	snapshot.FetchTime = std::chrono::steady_clock::now();
+	snapshot.Generation++;
+	if (bRet)
+	{
+		snapshot.Image = image;
+		camimage.swap(image);
+	}
+	else
+		snapshot.Image.clear();
+	if ((!snapshot.bCached) && (snapshot.Waiters == 0))
+		m_snapshots.erase(CamID);
+	lock.unlock();
+	m_snapshotCondition.notify_all();
+	return bRet;
+}
+
+bool CCameraHandler::FetchSnapshot(const uint64_t CamID, std::vector<unsigned char> &camimage)
+{
+	std::string szURL;
+	std::string ImageURL;
+	std::string Username;
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+
+		cameraDevice *pCamera = GetCamera(CamID);
+		if (pCamera == nullptr)
+			return false;
+
+		szURL = GetCameraURL(pCamera);
+		szURL += "/" + pCamera->ImageURL;
+		stdreplace(szURL, "#USERNAME", pCamera->Username);
+		stdreplace(szURL, "#PASSWORD", pCamera->Password);
+		ImageURL = pCamera->ImageURL;
+		Username = pCamera->Username;
+	}
 
-	if (pCamera->ImageURL == "raspberry.cgi")
+	if (ImageURL == "raspberry.cgi")
 		return TakeRaspberrySnapshot(camimage);
-	if (pCamera->ImageURL == "uvccapture.cgi")
-		return TakeUVCSnapshot(pCamera->Username, camimage);
+	if (ImageURL == "uvccapture.cgi")
+		return TakeUVCSnapshot(Username, camimage);
 
 	std::vector<std::string> ExtraHeaders;
 	return HTTPClient::GETBinary(szURL, ExtraHeaders, camimage, 5);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <map>
+#include <condition_variable>
 
 class CCameraHandler
 {
@@ -29,6 +31,18 @@ class CCameraHandler
 		std::string ImageURL;
 		std::vector<cameraActiveDevice> mActiveDevices;
 	};
+
+	struct _tCameraSnapshot
+	{
+		std::vector<unsigned char> Image;
+		std::chrono::steady_clock::time_point FetchTime;
+		bool bFetching = false;
+		bool bValid = false; //result of the last fetch, handed to the waiters
+		bool bCached = false; //the frame may be served to later requests
+		bool bReloaded = false; //cameras were reloaded during the fetch
+		uint32_t Generation = 0;
+		int Waiters = 0;
+	};
 public:
   CCameraHandler();
   ~CCameraHandler() = default;
@@ -51,9 +65,16 @@ public:
 
 private:
 	void ReloadCameraActiveDevices(const std::string &CamID);
+	bool FetchSnapshot(const uint64_t CamID, std::vector<unsigned char> &camimage);
 
 	std::mutex m_mutex;
 	unsigned char m_seconds_counter;
 	std::vector<cameraDevice> m_cameradevices;
+
+	//Last frame per camera, concurrent requests wait for the fetch in flight
+	std::mutex m_snapshotMutex;
+	std::condition_variable m_snapshotCondition;
+	std::map<uint64_t, _tCameraSnapshot> m_snapshots;
+	int m_snapshotMaxAge;
 };
 
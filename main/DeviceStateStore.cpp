@@ -0,0 +1,213 @@
+#include "stdafx.h"
+#include "DeviceStateStore.h"
+#include "Logger.h"
+#include "SQLHelper.h"
+#include <inttypes.h>
+
+#define DEVICESTATE_COLUMNS \
+	"A.ID, A.HardwareID, B.Enabled, A.DeviceID, A.Unit, A.Name, A.Used, A.Type, A.SubType, A.SwitchType, A.nValue, A.sValue, A.SignalLevel, A.BatteryLevel, A.LastLevel, " \
+	"A.Protected, A.AddjValue, A.AddjMulti, A.AddjValue2, A.AddjMulti2, A.Options, A.Description, A.Color, A.LastUpdate " \
+	"FROM DeviceStatus AS A LEFT JOIN Hardware AS B ON (B.ID == A.HardwareID)"
+
+#define DEVICESTATE_REFRESH_ATTEMPTS 3
+
+CDeviceStateStore::CDeviceStateStore()
+	: m_index(std::make_shared<const _tIndex>())
+{
+	m_generation = 0;
+}
+
+void CDeviceStateStore::FillState(_tDeviceState &state, const std::vector<std::string> &sd)
+{
+	state.ID = std::stoull(sd[0]);
+	state.HardwareID = atoi(sd[1].c_str());
+	state.bHardwareEnabled = atoi(sd[2].c_str()) != 0;
+	state.DeviceID = sd[3];
+	state.Unit = atoi(sd[4].c_str());
+	state.Name = sd[5];
+	state.bUsed = atoi(sd[6].c_str()) != 0;
+	state.devType = (uint8_t)atoi(sd[7].c_str());
+	state.subType = (uint8_t)atoi(sd[8].c_str());
+	state.SwitchType = atoi(sd[9].c_str());
+	state.nValue = atoi(sd[10].c_str());
+	state.sValue = sd[11];
+	state.SignalLevel = atoi(sd[12].c_str());
+	state.BatteryLevel = atoi(sd[13].c_str());
+	state.LastLevel = atoi(sd[14].c_str());
+	state.bProtected = atoi(sd[15].c_str()) != 0;
+	state.AddjValue = static_cast<float>(atof(sd[16].c_str()));
+	state.AddjMulti = static_cast<float>(atof(sd[17].c_str()));
+	state.AddjValue2 = static_cast<float>(atof(sd[18].c_str()));
+	state.AddjMulti2 = static_cast<float>(atof(sd[19].c_str()));
+	state.Options = sd[20];
+	state.Description = sd[21];
+	state.Color = sd[22];
+	state.LastUpdate = sd[23];
+}
+
+void CDeviceStateStore::Publish(const std::shared_ptr<_tSlot> &slot, const std::shared_ptr<_tDeviceState> &state)
+{
+	std::shared_ptr<const _tDeviceState> previous = std::atomic_load(&slot->state);
+	state->Version = (previous) ? previous->Version + 1 : 1;
+	std::atomic_store(&slot->state, std::shared_ptr<const _tDeviceState>(state));
+	m_generation++;
+}
+
+uint64_t CDeviceStateStore::GetVersion(const _tIndex &index, const uint64_t idx)
+{
+	auto itt = index.find(idx);
+	if (itt == index.end())
+		return 0;
+	std::shared_ptr<const _tDeviceState> state = std::atomic_load(&itt->second->state);
+	return (state) ? state->Version : 0;
+}
+
+//Full reload, device rows that still exist keep their slot so running readers stay valid.
+//Reads on the writer connection, devices published by another writer during the read keep that newer state
+void CDeviceStateStore::Load()
+{
+	std::map<uint64_t, uint64_t> versions;
+	{
+		std::shared_ptr<const _tIndex> before = std::atomic_load(&m_index);
+		for (const auto &itt : *before)
+			versions[itt.first] = GetVersion(*before, itt.first);
+	}
+
+	std::vector<std::vector<std::string> > result;
+	result = m_sql.safe_query("SELECT " DEVICESTATE_COLUMNS);
+
+	std::lock_guard<std::mutex> l(m_writeMutex);
+	std::shared_ptr<const _tIndex> current = std::atomic_load(&m_index);
+	auto index = std::make_shared<_tIndex>();
+	for (const auto &sd : result)
+	{
+		auto state = std::make_shared<_tDeviceState>();
+		FillState(*state, sd);
+
+		std::shared_ptr<_tSlot> slot;
+		auto itt = current->find(state->ID);
+		if (itt != current->end())
+		{
+			slot = itt->second;
+			auto vitt = versions.find(state->ID);
+			if ((vitt == versions.end()) || (vitt->second != GetVersion(*current, state->ID)))
+			{
+				(*index)[state->ID] = slot;
+				continue;
+			}
+		}
+		else
+			slot = std::make_shared<_tSlot>();
+		Publish(slot, state);
+		(*index)[state->ID] = slot;
+	}
+	//devices added after the read started
+	for (const auto &itt : *current)
+	{
+		if ((index->find(itt.first) == index->end()) && (versions.find(itt.first) == versions.end()))
+			(*index)[itt.first] = itt.second;
+	}
+	std::atomic_store(&m_index, std::shared_ptr<const _tIndex>(index));
+	m_generation++;
+	_log.Debug(DEBUG_NORM, "DeviceStateStore: loaded %d devices", (int)index->size());
+}
+
+//Re-read one device, used after changes made outside UpdateValue. Runs on the writer connection so it sees an open transaction.
+//The row is read before m_writeMutex is taken. When another writer published the device meanwhile it is read again
+void CDeviceStateStore::Refresh(const uint64_t idx)
+{
+	for (int iAttempt = 0; iAttempt < DEVICESTATE_REFRESH_ATTEMPTS; iAttempt++)
+	{
+		uint64_t version = GetVersion(*std::atomic_load(&m_index), idx);
+
+		std::vector<std::vector<std::string> > result;
+		result = m_sql.safe_query("SELECT " DEVICESTATE_COLUMNS " WHERE (A.ID == %" PRIu64 ")", idx);
+
+		std::lock_guard<std::mutex> l(m_writeMutex);
+		std::shared_ptr<const _tIndex> current = std::atomic_load(&m_index);
+		if (GetVersion(*current, idx) != version)
+			continue;
+		auto itt = current->find(idx);
+		if (result.empty())
+		{
+			if (itt == current->end())
+				return;
+			auto index = std::make_shared<_tIndex>(*current);
+			index->erase(idx);
+			std::atomic_store(&m_index, std::shared_ptr<const _tIndex>(index));
+			m_generation++;
+			return;
+		}
+
+		auto state = std::make_shared<_tDeviceState>();
+		FillState(*state, result[0]);
+		if (itt != current->end())
+		{
+			Publish(itt->second, state);
+			return;
+		}
+		auto slot = std::make_shared<_tSlot>();
+		Publish(slot, state);
+		auto index = std::make_shared<_tIndex>(*current);
+		(*index)[idx] = slot;
+		std::atomic_store(&m_index, std::shared_ptr<const _tIndex>(index));
+		return;
+	}
+	//still changing, the writers doing so keep it current
+	_log.Debug(DEBUG_NORM, "DeviceStateStore: device %" PRIu64 " kept changing during refresh", idx);
+}
+
+//Copy the current state of a device, let func change it and publish the result
+void CDeviceStateStore::Modify(const uint64_t idx, const std::function<void(_tDeviceState &)> &func)
+{
+	{
+		std::lock_guard<std::mutex> l(m_writeMutex);
+		std::shared_ptr<const _tIndex> current = std::atomic_load(&m_index);
+		auto itt = current->find(idx);
+		if (itt != current->end())
+		{
+			std::shared_ptr<const _tDeviceState> previous = std::atomic_load(&itt->second->state);
+			auto state = std::make_shared<_tDeviceState>(*previous);
+			func(*state);
+			Publish(itt->second, state);
+			return;
+		}
+	}
+	//not known yet (new device), read it completely
+	Refresh(idx);
+}
+
+void CDeviceStateStore::Remove(const uint64_t idx)
+{
+	std::lock_guard<std::mutex> l(m_writeMutex);
+	std::shared_ptr<const _tIndex> current = std::atomic_load(&m_index);
+	if (current->find(idx) == current->end())
+		return;
+	auto index = std::make_shared<_tIndex>(*current);
+	index->erase(idx);
+	std::atomic_store(&m_index, std::shared_ptr<const _tIndex>(index));
+	m_generation++;
+}
+
+CDeviceStateStore::_tDeviceStatePtr CDeviceStateStore::Get(const uint64_t idx) const
+{
+	std::shared_ptr<const _tIndex> current = std::atomic_load(&m_index);
+	auto itt = current->find(idx);
+	if (itt == current->end())
+		return nullptr;
+	return std::atomic_load(&itt->second->state);
+}
+
+void CDeviceStateStore::GetSnapshot(std::vector<_tDeviceStatePtr> &states) const
+{
+	std::shared_ptr<const _tIndex> current = std::atomic_load(&m_index);
+	states.clear();
+	states.reserve(current->size());
+	for (const auto &itt : *current)
+		states.push_back(std::atomic_load(&itt.second->state));
+}
+
+uint64_t CDeviceStateStore::GetGeneration() const
+{
+	return m_generation;
+}
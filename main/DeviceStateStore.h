@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Authoritative in-memory copy of DeviceStatus.
+//Readers take immutable snapshots and never wait for writers or SQL, writers publish a new copy of the changed device.
+//The shared_ptr atomics are not lock-free (libstdc++ guards them with a small spinlock pool), so readers can briefly contend there
+class CDeviceStateStore
+{
+public:
+	struct _tDeviceState
+	{
+		uint64_t ID = 0;
+		int HardwareID = 0;
+		bool bHardwareEnabled = false;
+		std::string DeviceID;
+		int Unit = 0;
+		std::string Name;
+		bool bUsed = false;
+		uint8_t devType = 0;
+		uint8_t subType = 0;
+		int SwitchType = 0;
+		int nValue = 0;
+		std::string sValue;
+		int SignalLevel = 12;
+		int BatteryLevel = 255;
+		int LastLevel = 0;
+		bool bProtected = false;
+		float AddjValue = 0;
+		float AddjMulti = 1;
+		float AddjValue2 = 0;
+		float AddjMulti2 = 1;
+		std::string Options;
+		std::string Description;
+		std::string Color;
+		std::string LastUpdate;
+		uint64_t Version = 0; //incremented on every change of this device
+	};
+	typedef std::shared_ptr<const _tDeviceState> _tDeviceStatePtr;
+
+	CDeviceStateStore();
+	~CDeviceStateStore() = default;
+
+	void Load();
+	void Refresh(uint64_t idx);
+	void Modify(uint64_t idx, const std::function<void(_tDeviceState &)> &func);
+	void Remove(uint64_t idx);
+
+	_tDeviceStatePtr Get(uint64_t idx) const;
+	void GetSnapshot(std::vector<_tDeviceStatePtr> &states) const;
+	uint64_t GetGeneration() const;
+
+private:
+	struct _tSlot
+	{
+		_tDeviceStatePtr state;
+	};
+	typedef std::map<uint64_t, std::shared_ptr<_tSlot>> _tIndex;
+
+	static void FillState(_tDeviceState &state, const std::vector<std::string> &sd);
+	static uint64_t GetVersion(const _tIndex &index, uint64_t idx);
+	void Publish(const std::shared_ptr<_tSlot> &slot, const std::shared_ptr<_tDeviceState> &state);
+
+	//Serializes publishing only, never held during SQL. Readers use atomic loads of m_index and the slot states
+	std::mutex m_writeMutex;
+	std::shared_ptr<const _tIndex> m_index;
+	std::atomic<uint64_t> m_generation;
+};
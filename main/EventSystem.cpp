@@ -24,6 +24,7 @@
 #include "../main/LuaTable.h"
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
+#include <sys/stat.h>
 
 extern "C" {
 #include <lua.h>
@@ -45,6 +46,11 @@ extern http::server::CWebServerHelper m_webservers;
 extern PyObject * PDevice_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
 #endif
 
+static uint64_t ElapsedMicroseconds(const std::chrono::steady_clock::time_point &tstart)
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tstart).count();
+}
+
 // Helper table for Blockly and SQL name mapping
 const std::string CEventSystem::m_szReason[] =
 {
@@ -211,6 +217,7 @@ void CEventSystem::LoadEvents()
 	dzvents->m_scriptsDir = szUserDataFolder + "scripts/dzVents/scripts/";
 	dzvents->m_runtimeDir = szStartupFolder + "dzVents/runtime/";
 #endif
+	m_dzv_Dir = dzv_Dir;
 
 	boost::unique_lock<boost::shared_mutex> eventsMutexLock(m_eventsMutex);
 	_log.Log(LOG_STATUS, "EventSystem: reset all events...");
@@ -430,89 +437,88 @@ void CEventSystem::UpdateJsonMap(_tDeviceStatus &item, const uint64_t ulDevID)
 
 void CEventSystem::GetCurrentStates()
 {
-	std::vector<std::vector<std::string> > result;
+	//the device state store is reloaded here as well, every caller wants it in line with the database
+	m_mainworker.m_devicestore.Load();
+	std::vector<CDeviceStateStore::_tDeviceStatePtr> states;
+	m_mainworker.m_devicestore.GetSnapshot(states);
 
 	boost::unique_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
 
 	_log.Log(LOG_STATUS, "EventSystem: reset all device statuses...");
 	m_devicestates.clear();
 
-	result = m_sql.safe_query(
-		"SELECT A.HardwareID, A.ID, A.Name, A.nValue, A.sValue, A.Type, A.SubType, A.SwitchType, A.LastUpdate, A.LastLevel, A.Options, A.Description, A.BatteryLevel, A.SignalLevel, A.Unit, A.DeviceID, A.Protected, A.AddjValue, A.AddjMulti, A.AddjValue2, A.AddjMulti2 "
-		"FROM DeviceStatus AS A, Hardware AS B "
-		"WHERE (A.Used = '1') AND (B.ID == A.HardwareID) AND (B.Enabled == 1)");
-	if (!result.empty())
+	std::map<uint64_t, _tDeviceStatus> m_devicestates_temp;
+	for (const auto &state : states)
 	{
-		std::map<uint64_t, _tDeviceStatus> m_devicestates_temp;
-		for (auto &sd : result)
-		{
-			_tDeviceStatus sitem;
+		if ((!state->bUsed) || (!state->bHardwareEnabled))
+			continue;
 
-			// Fix string capacity to avoid map entry resizing
-			std::string l_deviceName;		l_deviceName.reserve(100);
-			std::string l_sValue;			l_sValue.reserve(200);
-			std::string l_nValueWording;	l_nValueWording.reserve(20);
-			std::string l_lastUpdate;		l_lastUpdate.reserve(30);
-			std::string l_description;		l_description.reserve(200);
-			std::string l_deviceID;			l_deviceID.reserve(25);
+		_tDeviceStatus sitem;
 
-			sitem.hardwareID = atoi(sd[0].c_str());
-			sitem.ID = std::stoull(sd[1]);
-			sitem.deviceName = l_deviceName.assign(sd[2]);
+		// Fix string capacity to avoid map entry resizing
+		std::string l_deviceName;		l_deviceName.reserve(100);
+		std::string l_sValue;			l_sValue.reserve(200);
+		std::string l_nValueWording;	l_nValueWording.reserve(20);
+		std::string l_lastUpdate;		l_lastUpdate.reserve(30);
+		std::string l_description;		l_description.reserve(200);
+		std::string l_deviceID;			l_deviceID.reserve(25);
 
-			sitem.devType = atoi(sd[5].c_str());
-			sitem.subType = atoi(sd[6].c_str());
+		sitem.hardwareID = state->HardwareID;
+		sitem.ID = state->ID;
+		sitem.deviceName = l_deviceName.assign(state->Name);
 
-			if ((sitem.devType == pTypeGeneral) && (sitem.subType == sTypeCounterIncremental))
-			{
-				//special case for incremental counter, need to calculate the actual count value
+		sitem.devType = state->devType;
+		sitem.subType = state->subType;
 
-				uint64_t total_min, total_max, total_real;
-				std::vector<std::vector<std::string> > result2;
+		std::string sValue = state->sValue;
+		if ((sitem.devType == pTypeGeneral) && (sitem.subType == sTypeCounterIncremental))
+		{
+			//special case for incremental counter, need to calculate the actual count value
 
-				result2 = m_sql.safe_query("SELECT sValue FROM DeviceStatus WHERE (ID=%" PRIu64 ")", sitem.ID);
-				total_max = std::stoull(result2[0][0]);
+			uint64_t total_min, total_max, total_real;
+			std::vector<std::vector<std::string> > result2;
 
-				//get value of today
-				std::string szDate = TimeToString(nullptr, TF_Date);
-				result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", sitem.ID, szDate.c_str());
-				if (!result2.empty())
-				{
-					total_min = std::stoull(result2[0][0]);
-					total_real = total_max - total_min;
+			total_max = std::stoull(sValue);
 
-					sd[4] = std::to_string(total_real); //sitem.sValue = l_sValue.assign(sd[4]);
-				}
+			//get value of today
+			std::string szDate = TimeToString(nullptr, TF_Date);
+			result2 = m_sql.safe_query_read("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", sitem.ID, szDate.c_str());
+			if (!result2.empty())
+			{
+				total_min = std::stoull(result2[0][0]);
+				total_real = total_max - total_min;
+
+				sValue = std::to_string(total_real);
 			}
+		}
 
-			sitem.nValue = atoi(sd[3].c_str());
-			sitem.sValue = l_sValue.assign(sd[4]);
-
-			sitem.switchtype = atoi(sd[7].c_str());
-			_eSwitchType switchtype = (_eSwitchType)sitem.switchtype;
-			std::map<std::string, std::string> options = m_sql.BuildDeviceOptions(sd[10]);
-			sitem.nValueWording = l_nValueWording.assign(nValueToWording(sitem.devType, sitem.subType, switchtype, sitem.nValue, sitem.sValue, options));
-			sitem.lastUpdate = l_lastUpdate.assign(sd[8]);
-			sitem.lastLevel = atoi(sd[9].c_str());
-			sitem.description = l_description.assign(sd[11]);
-			sitem.batteryLevel = atoi(sd[12].c_str());
-			sitem.signalLevel = atoi(sd[13].c_str());
-			sitem.unit = atoi(sd[14].c_str());
-			sitem.deviceID = l_deviceID.assign(sd[15]);
-			sitem.protection = atoi(sd[16].c_str());
-			sitem.AddjValue = std::stof(sd[17]);
-			sitem.AddjMulti = std::stof(sd[18]);
-			sitem.AddjValue2 = std::stof(sd[19]);
-			sitem.AddjMulti2 = std::stof(sd[20]);
+		sitem.nValue = state->nValue;
+		sitem.sValue = l_sValue.assign(sValue);
+
+		sitem.switchtype = (uint8_t)state->SwitchType;
+		_eSwitchType switchtype = (_eSwitchType)sitem.switchtype;
+		std::map<std::string, std::string> options = m_sql.BuildDeviceOptions(state->Options);
+		sitem.nValueWording = l_nValueWording.assign(nValueToWording(sitem.devType, sitem.subType, switchtype, sitem.nValue, sitem.sValue, options));
+		sitem.lastUpdate = l_lastUpdate.assign(state->LastUpdate);
+		sitem.lastLevel = (uint8_t)state->LastLevel;
+		sitem.description = l_description.assign(state->Description);
+		sitem.batteryLevel = state->BatteryLevel;
+		sitem.signalLevel = state->SignalLevel;
+		sitem.unit = state->Unit;
+		sitem.deviceID = l_deviceID.assign(state->DeviceID);
+		sitem.protection = state->bProtected ? 1 : 0;
+		sitem.AddjValue = state->AddjValue;
+		sitem.AddjMulti = state->AddjMulti;
+		sitem.AddjValue2 = state->AddjValue2;
+		sitem.AddjMulti2 = state->AddjMulti2;
 
-			if (!m_sql.m_bDisableDzVentsSystem)
-			{
-				UpdateJsonMap(sitem, sitem.ID);
-			}
-			m_devicestates_temp[sitem.ID] = sitem;
+		if (!m_sql.m_bDisableDzVentsSystem)
+		{
+			UpdateJsonMap(sitem, sitem.ID);
 		}
-		m_devicestates = m_devicestates_temp;
+		m_devicestates_temp[sitem.ID] = sitem;
 	}
+	m_devicestates = m_devicestates_temp;
 	m_mainworker.m_notificationsystem.Notify(Notification::DZ_ALLDEVICESTATUSRESET, Notification::STATUS_INFO);
 }
 
@@ -524,7 +530,7 @@ void CEventSystem::GetCurrentUserVariables()
 	m_uservariables.clear();
 
 	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT ID,Name,Value, ValueType, LastUpdate FROM UserVariables");
+	result = m_sql.safe_query_read("SELECT ID,Name,Value, ValueType, LastUpdate FROM UserVariables");
 	if (!result.empty())
 	{
 		for (const auto &sd : result)
@@ -547,7 +553,7 @@ void CEventSystem::GetCurrentScenesGroups()
 	m_scenesgroups.clear();
 
 	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT ID, Name, nValue, SceneType, LastUpdate, Protected, Description FROM Scenes");
+	result = m_sql.safe_query_read("SELECT ID, Name, nValue, SceneType, LastUpdate, Protected, Description FROM Scenes");
 	if (!result.empty())
 	{
 		for (const auto &sd : result)
@@ -569,7 +575,7 @@ void CEventSystem::GetCurrentScenesGroups()
 			sgitem.lastUpdate = sd[4];
 			sgitem.protection = atoi(sd[5].c_str());
 			sgitem.description = sd[6];
-			result2 = m_sql.safe_query("SELECT DISTINCT A.DeviceRowID FROM SceneDevices AS A, DeviceStatus AS B WHERE (A.SceneRowID == %" PRIu64 ") AND (A.DeviceRowID == B.ID)", sgitem.ID);
+			result2 = m_sql.safe_query_read("SELECT DISTINCT A.DeviceRowID FROM SceneDevices AS A, DeviceStatus AS B WHERE (A.SceneRowID == %" PRIu64 ") AND (A.DeviceRowID == B.ID)", sgitem.ID);
 			if (!result2.empty())
 			{
 				for (const auto &sd2 : result2)
@@ -582,500 +588,476 @@ void CEventSystem::GetCurrentScenesGroups()
 	}
 }
 
-void CEventSystem::GetCurrentMeasurementStates()
+void CEventSystem::GetCurrentMeasurementStates(_tMeasurementStates &mstates)
 {
-	m_tempValuesByName.clear();
-	m_dewValuesByName.clear();
-	m_humValuesByName.clear();
-	m_baroValuesByName.clear();
-	m_utilityValuesByName.clear();
-	m_rainValuesByName.clear();
-	m_rainLastHourValuesByName.clear();
-	m_uvValuesByName.clear();
-	m_weatherValuesByName.clear();
-	m_winddirValuesByName.clear();
-	m_windspeedValuesByName.clear();
-	m_windgustValuesByName.clear();
-	m_zwaveAlarmValuesByName.clear();
-
-	m_tempValuesByID.clear();
-	m_dewValuesByID.clear();
-	m_humValuesByID.clear();
-	m_baroValuesByID.clear();
-	m_utilityValuesByID.clear();
-	m_rainValuesByID.clear();
-	m_rainLastHourValuesByID.clear();
-	m_uvValuesByID.clear();
-	m_weatherValuesByID.clear();
-	m_winddirValuesByID.clear();
-	m_windspeedValuesByID.clear();
-	m_windgustValuesByID.clear();
-	m_zwaveAlarmValuesByID.clear();
-
-	boost::shared_lock<boost::shared_mutex> devicestatesMutexLock(m_devicestatesMutex);
-
-	//char szTmp[300];
+	std::vector<CDeviceStateStore::_tDeviceStatePtr> states;
+	m_mainworker.m_devicestore.GetSnapshot(states);
 
-	for (const auto &state : m_devicestates)
+	for (const auto &state : states)
 	{
-		_tDeviceStatus sitem = state.second;
-		std::vector<std::string> splitresults;
-		StringSplit(sitem.sValue, ";", splitresults);
-
-		if ((state.second.devType == pTypeGeneral) && (state.second.subType == sTypeCounterIncremental))
-			splitresults.clear();
-
-		float temp = 0;
-		int humidity = 0;
-		float barometer = 0;
-		float rainmm = 0;
-		float rainmmlasthour = 0;
-		float uv = 0;
-		float dewpoint = 0;
-		float utilityval = 0;
-		float weatherval = 0;
-		float winddir = 0;
-		float windspeed = 0;
-		float windgust = 0;
-		int alarmval = 0;
-
-		bool isTemp = false;
-		bool isDew = false;
-		bool isHum = false;
-		bool isBaro = false;
-		bool isUtility = false;
-		bool isWeather = false;
-		bool isRain = false;
-		bool isUV = false;
-		bool isWindDir = false;
-		bool isWindSpeed = false;
-		bool isWindGust = false;
-		bool isZWaveAlarm = false;
-
-		switch (sitem.devType)
-		{
-		case pTypeRego6XXTemp:
-		case pTypeTEMP:
+		if ((!state->bUsed) || (!state->bHardwareEnabled))
+			continue;
+		AddMeasurementState(mstates, *state);
+	}
+}
+
+void CEventSystem::AddMeasurementState(_tMeasurementStates &mstates, const CDeviceStateStore::_tDeviceState &sitem)
+{
+	std::vector<std::string> splitresults;
+	StringSplit(sitem.sValue, ";", splitresults);
+
+	if ((sitem.devType == pTypeGeneral) && (sitem.subType == sTypeCounterIncremental))
+		splitresults.clear();
+
+	float temp = 0;
+	int humidity = 0;
+	float barometer = 0;
+	float rainmm = 0;
+	float rainmmlasthour = 0;
+	float uv = 0;
+	float dewpoint = 0;
+	float utilityval = 0;
+	float weatherval = 0;
+	float winddir = 0;
+	float windspeed = 0;
+	float windgust = 0;
+	int alarmval = 0;
+
+	bool isTemp = false;
+	bool isDew = false;
+	bool isHum = false;
+	bool isBaro = false;
+	bool isUtility = false;
+	bool isWeather = false;
+	bool isRain = false;
+	bool isUV = false;
+	bool isWindDir = false;
+	bool isWindSpeed = false;
+	bool isWindGust = false;
+	bool isZWaveAlarm = false;
+
+	switch (sitem.devType)
+	{
+	case pTypeRego6XXTemp:
+	case pTypeTEMP:
+		if (!splitresults.empty())
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			isTemp = true;
+		}
+		break;
+	case pTypeThermostat:
+		if (sitem.subType == sTypeThermTemperature)
+		{
 			if (!splitresults.empty())
 			{
 				temp = static_cast<float>(atof(splitresults[0].c_str()));
 				isTemp = true;
 			}
-			break;
-		case pTypeThermostat:
-			if (sitem.subType == sTypeThermTemperature)
-			{
-				if (!splitresults.empty())
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					isTemp = true;
-				}
-			}
-			else
-			{
-				if (!splitresults.empty())
-				{
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
-					isUtility = true;
-				}
-			}
-			break;
-		case pTypeThermostat1:
+		}
+		else
+		{
 			if (!splitresults.empty())
 			{
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				isTemp = true;
-			}
-			break;
-		case pTypeHUM:
-			humidity = sitem.nValue;
-			isHum = true;
-			break;
-		case pTypeTEMP_HUM:
-			if (splitresults.size() > 1)
-			{
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				humidity = atoi(splitresults[1].c_str());
-				dewpoint = (float)CalculateDewPoint(temp, humidity);
-				isTemp = true;
-				isHum = true;
-				isDew = true;
-			}
-			break;
-		case pTypeTEMP_HUM_BARO:
-			if (splitresults.size() < 5) {
-				_log.Log(LOG_ERROR, "EventSystem: TEMP_HUM_BARO missing values : ID=%" PRIu64 ", sValue=%s", sitem.ID, sitem.sValue.c_str());
-				continue;
+				utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+				isUtility = true;
 			}
+		}
+		break;
+	case pTypeThermostat1:
+		if (!splitresults.empty())
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			isTemp = true;
+		}
+		break;
+	case pTypeHUM:
+		humidity = sitem.nValue;
+		isHum = true;
+		break;
+	case pTypeTEMP_HUM:
+		if (splitresults.size() > 1)
+		{
 			temp = static_cast<float>(atof(splitresults[0].c_str()));
 			humidity = atoi(splitresults[1].c_str());
-			barometer = static_cast<float>(atof(splitresults[3].c_str()));
 			dewpoint = (float)CalculateDewPoint(temp, humidity);
 			isTemp = true;
 			isHum = true;
-			isBaro = true;
 			isDew = true;
-			break;
-		case pTypeTEMP_BARO:
-			if (splitresults.size() > 1)
+		}
+		break;
+	case pTypeTEMP_HUM_BARO:
+		if (splitresults.size() < 5) {
+			_log.Log(LOG_ERROR, "EventSystem: TEMP_HUM_BARO missing values : ID=%" PRIu64 ", sValue=%s", sitem.ID, sitem.sValue.c_str());
+			return;
+		}
+		temp = static_cast<float>(atof(splitresults[0].c_str()));
+		humidity = atoi(splitresults[1].c_str());
+		barometer = static_cast<float>(atof(splitresults[3].c_str()));
+		dewpoint = (float)CalculateDewPoint(temp, humidity);
+		isTemp = true;
+		isHum = true;
+		isBaro = true;
+		isDew = true;
+		break;
+	case pTypeTEMP_BARO:
+		if (splitresults.size() > 1)
+		{
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			barometer = static_cast<float>(atof(splitresults[1].c_str()));
+			isTemp = true;
+			isBaro = true;
+		}
+		break;
+	case pTypeBARO:
+		barometer = static_cast<float>(atof(splitresults[0].c_str()));
+		isBaro = true;
+		break;
+	case pTypeRadiator1:
+		if (sitem.subType == sTypeSmartwares)
+		{
+			utilityval = static_cast<float>(atof(sitem.sValue.c_str()));
+			isUtility = true;
+		}
+		break;
+	case pTypeUV:
+		if (splitresults.size() == 2)
+		{
+			uv = static_cast<float>(atof(splitresults[0].c_str()));
+			isUV = true;
+			weatherval = uv;
+			isWeather = true;
+
+			if (sitem.subType == sTypeUV3)
 			{
-				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				barometer = static_cast<float>(atof(splitresults[1].c_str()));
+				temp = static_cast<float>(atof(splitresults[1].c_str()));
 				isTemp = true;
-				isBaro = true;
 			}
-			break;
-		case pTypeBARO:
-			barometer = static_cast<float>(atof(splitresults[0].c_str()));
-			isBaro = true;
-			break;
-		case pTypeRadiator1:
-			if (sitem.subType == sTypeSmartwares)
+		}
+		break;
+	case pTypeWIND:
+		if (splitresults.size() == 6)
+		{
+			winddir = static_cast<float>(atof(splitresults[0].c_str()));
+			isWindDir = true;
+
+			if (sitem.subType != sTypeWIND5)
 			{
-				utilityval = static_cast<float>(atof(sitem.sValue.c_str()));
-				isUtility = true;
+				int intSpeed = atoi(splitresults[2].c_str());
+				windspeed = float(intSpeed) * 0.1F; // m/s
+				isWindSpeed = true;
 			}
-			break;
-		case pTypeUV:
-			if (splitresults.size() == 2)
-			{
-				uv = static_cast<float>(atof(splitresults[0].c_str()));
-				isUV = true;
-				weatherval = uv;
-				isWeather = true;
 
-				if (sitem.subType == sTypeUV3)
-				{
-					temp = static_cast<float>(atof(splitresults[1].c_str()));
-					isTemp = true;
-				}
-			}
-			break;
-		case pTypeWIND:
-			if (splitresults.size() == 6)
+			int intGust = atoi(splitresults[3].c_str());
+			windgust = float(intGust) * 0.1F; // m/s
+			isWindGust = true;
+			if ((windgust == 0) && (windspeed != 0))
 			{
-				winddir = static_cast<float>(atof(splitresults[0].c_str()));
-				isWindDir = true;
-
-				if (sitem.subType != sTypeWIND5)
-				{
-					int intSpeed = atoi(splitresults[2].c_str());
-					windspeed = float(intSpeed) * 0.1F; // m/s
-					isWindSpeed = true;
-				}
-
-				int intGust = atoi(splitresults[3].c_str());
-				windgust = float(intGust) * 0.1F; // m/s
-				isWindGust = true;
-				if ((windgust == 0) && (windspeed != 0))
-				{
-					weatherval = windspeed;
-					isWeather = true;
-				}
-				else
-				{
-					weatherval = windgust;
-					isWeather = true;
-				}
-				if ((sitem.subType == sTypeWIND4) || (sitem.subType == sTypeWINDNoTemp))
-				{
-					temp = static_cast<float>(atof(splitresults[4].c_str()));
-					//chill = static_cast<float>(atof(splitresults[5].c_str()));
-					isTemp = true;
-				}
+				weatherval = windspeed;
+				isWeather = true;
 			}
-			break;
-		case pTypeRFXSensor:
-			if (sitem.subType == sTypeRFXSensorTemp)
+			else
 			{
-				if (!splitresults.empty())
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					isTemp = true;
-				}
+				weatherval = windgust;
+				isWeather = true;
 			}
-			else if ((sitem.subType == sTypeRFXSensorVolt) || (sitem.subType == sTypeRFXSensorAD))
+			if ((sitem.subType == sTypeWIND4) || (sitem.subType == sTypeWINDNoTemp))
 			{
-				utilityval = static_cast<float>(atof(sitem.sValue.c_str()));
-				isUtility = true;
+				temp = static_cast<float>(atof(splitresults[4].c_str()));
+				//chill = static_cast<float>(atof(splitresults[5].c_str()));
+				isTemp = true;
 			}
-			break;
-		case pTypeAirQuality:
-			utilityval = (float)(sitem.nValue);
-			isUtility = true;
-			break;
-		case pTypeENERGY:
+		}
+		break;
+	case pTypeRFXSensor:
+		if (sitem.subType == sTypeRFXSensorTemp)
+		{
 			if (!splitresults.empty())
 			{
-				if (splitresults.size() == 2)
-					utilityval = static_cast<float>(atof(splitresults[1].c_str()));
-				else
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
-				isUtility = true;
+				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				isTemp = true;
 			}
-			break;
-		case pTypePOWER:
-			if (!splitresults.empty())
-			{
+		}
+		else if ((sitem.subType == sTypeRFXSensorVolt) || (sitem.subType == sTypeRFXSensorAD))
+		{
+			utilityval = static_cast<float>(atof(sitem.sValue.c_str()));
+			isUtility = true;
+		}
+		break;
+	case pTypeAirQuality:
+		utilityval = (float)(sitem.nValue);
+		isUtility = true;
+		break;
+	case pTypeENERGY:
+		if (!splitresults.empty())
+		{
+			if (splitresults.size() == 2)
+				utilityval = static_cast<float>(atof(splitresults[1].c_str()));
+			else
 				utilityval = static_cast<float>(atof(splitresults[0].c_str()));
-				isUtility = true;
-			}
-			break;
-		case pTypeUsage:
-			if (!splitresults.empty())
+			isUtility = true;
+		}
+		break;
+	case pTypePOWER:
+		if (!splitresults.empty())
+		{
+			utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+			isUtility = true;
+		}
+		break;
+	case pTypeUsage:
+		if (!splitresults.empty())
+		{
+			utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+			isUtility = true;
+		}
+		break;
+	case pTypeP1Power:
+		if (splitresults.size() == 6)
+		{
+			utilityval = static_cast<float>(atof(splitresults[4].c_str()));
+			isUtility = true;
+		}
+		break;
+	case pTypeLux:
+		if (!splitresults.empty())
+		{
+			utilityval = static_cast<float>(atof(splitresults[0].c_str()));
+			isUtility = true;
+		}
+		break;
+	case pTypeGeneral:
+	{
+		if (!splitresults.empty())
+		{
+			if ((sitem.subType == sTypeVisibility) || (sitem.subType == sTypeSolarRadiation))
 			{
 				utilityval = static_cast<float>(atof(splitresults[0].c_str()));
 				isUtility = true;
+				weatherval = utilityval;
+				isWeather = true;
 			}
-			break;
-		case pTypeP1Power:
-			if (splitresults.size() == 6)
+			else if (sitem.subType == sTypeBaro)
 			{
-				utilityval = static_cast<float>(atof(splitresults[4].c_str()));
-				isUtility = true;
+				barometer = static_cast<float>(atof(splitresults[0].c_str()));
+				isBaro = true;
 			}
-			break;
-		case pTypeLux:
-			if (!splitresults.empty())
+			else if ((sitem.subType == sTypeAlert)
+				|| (sitem.subType == sTypeDistance)
+				|| (sitem.subType == sTypePercentage)
+				|| (sitem.subType == sTypeWaterflow)
+				|| (sitem.subType == sTypeCustom)
+				|| (sitem.subType == sTypeVoltage)
+				|| (sitem.subType == sTypeCurrent)
+				|| (sitem.subType == sTypeSetPoint)
+				|| (sitem.subType == sTypeKwh)
+				|| (sitem.subType == sTypeSoundLevel)
+				)
 			{
 				utilityval = static_cast<float>(atof(splitresults[0].c_str()));
 				isUtility = true;
 			}
-			break;
-		case pTypeGeneral:
+		}
+		else
 		{
-			if (!splitresults.empty())
+			if (sitem.subType == sTypeZWaveAlarm)
 			{
-				if ((sitem.subType == sTypeVisibility) || (sitem.subType == sTypeSolarRadiation))
-				{
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
-					isUtility = true;
-					weatherval = utilityval;
-					isWeather = true;
-				}
-				else if (sitem.subType == sTypeBaro)
-				{
-					barometer = static_cast<float>(atof(splitresults[0].c_str()));
-					isBaro = true;
-				}
-				else if ((sitem.subType == sTypeAlert)
-					|| (sitem.subType == sTypeDistance)
-					|| (sitem.subType == sTypePercentage)
-					|| (sitem.subType == sTypeWaterflow)
-					|| (sitem.subType == sTypeCustom)
-					|| (sitem.subType == sTypeVoltage)
-					|| (sitem.subType == sTypeCurrent)
-					|| (sitem.subType == sTypeSetPoint)
-					|| (sitem.subType == sTypeKwh)
-					|| (sitem.subType == sTypeSoundLevel)
-					)
-				{
-					utilityval = static_cast<float>(atof(splitresults[0].c_str()));
-					isUtility = true;
-				}
+				alarmval = sitem.nValue;
+				isZWaveAlarm = true;
 			}
-			else
+			else if (sitem.subType == sTypeCounterIncremental)
 			{
-				if (sitem.subType == sTypeZWaveAlarm)
-				{
-					alarmval = sitem.nValue;
-					isZWaveAlarm = true;
-				}
-				else if (sitem.subType == sTypeCounterIncremental)
-				{
-					const _eMeterType metertype = (const _eMeterType)sitem.switchtype;
+				const _eMeterType metertype = (const _eMeterType)sitem.SwitchType;
 
-					float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
-
-					uint64_t total_min, total_max, total_real;
-					std::vector<std::vector<std::string> > result2;
+				float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
 
-					result2 = m_sql.safe_query("SELECT sValue FROM DeviceStatus WHERE (ID=%" PRIu64 ")", sitem.ID);
-					total_max = std::stoull(result2[0][0]);
+				uint64_t total_min, total_max, total_real;
+				std::vector<std::vector<std::string> > result2;
 
-					//get value of today
-					std::string szDate = TimeToString(nullptr, TF_Date);
-					result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-						sitem.ID, szDate.c_str());
-					if (!result2.empty())
-					{
-						total_min = std::stoull(result2[0][0]);
-						total_real = total_max - total_min;
+				total_max = std::stoull(sitem.sValue);
 
-						utilityval = float(total_real) / divider;
-						isUtility = true;
-					}
-				}
-				else if (sitem.subType == sTypeManagedCounter)
+				//get value of today
+				std::string szDate = TimeToString(nullptr, TF_Date);
+				result2 = m_sql.safe_query_read("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
+					sitem.ID, szDate.c_str());
+				if (!result2.empty())
 				{
-					const _eMeterType metertype = (const _eMeterType)sitem.switchtype;
+					total_min = std::stoull(result2[0][0]);
+					total_real = total_max - total_min;
 
-					float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
+					utilityval = float(total_real) / divider;
+					isUtility = true;
+				}
+			}
+			else if (sitem.subType == sTypeManagedCounter)
+			{
+				const _eMeterType metertype = (const _eMeterType)sitem.SwitchType;
 
-					if (splitresults.size() > 1) {
-						float usage = std::stof(splitresults[1]);
-						if (usage < 0.0) {
-							usage = 0.0;
-						}
+				float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
 
-						utilityval = usage / divider;
-						isUtility = true;
+				if (splitresults.size() > 1) {
+					float usage = std::stof(splitresults[1]);
+					if (usage < 0.0) {
+						usage = 0.0;
 					}
+
+					utilityval = usage / divider;
+					isUtility = true;
 				}
 			}
 		}
-		break;
-		case pTypeRAIN:
-			if (splitresults.size() == 2)
-			{
-				rainmm = 0;
-				rainmmlasthour = static_cast<float>(atof(splitresults[0].c_str())) / 100.0F;
-				isRain = true;
-				weatherval = rainmmlasthour;
-				isWeather = true;
+	}
+	break;
+	case pTypeRAIN:
+		if (splitresults.size() == 2)
+		{
+			rainmm = 0;
+			rainmmlasthour = static_cast<float>(atof(splitresults[0].c_str())) / 100.0F;
+			isRain = true;
+			weatherval = rainmmlasthour;
+			isWeather = true;
 
-				//Calculate the total rainfall of today
+			//Calculate the total rainfall of today
 
-				std::string szDate = TimeToString(nullptr, TF_Date);
-				std::vector<std::vector<std::string> > result2;
+			std::string szDate = TimeToString(nullptr, TF_Date);
+			std::vector<std::vector<std::string> > result2;
 
+			if (sitem.subType == sTypeRAINWU || sitem.subType == sTypeRAINByRate)
+			{
+				result2 = m_sql.safe_query_read(
+					"SELECT Total, Total FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
+					sitem.ID, szDate.c_str());
+			}
+			else
+			{
+				result2 = m_sql.safe_query_read(
+					"SELECT MIN(Total), MAX(Total) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
+					sitem.ID, szDate.c_str());
+			}
+			if (!result2.empty())
+			{
+				double total_real = 0;
+				std::vector<std::string> sd2 = result2[0];
 				if (sitem.subType == sTypeRAINWU || sitem.subType == sTypeRAINByRate)
 				{
-					result2 = m_sql.safe_query(
-						"SELECT Total, Total FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
-						sitem.ID, szDate.c_str());
+					total_real = atof(sd2[1].c_str());
 				}
 				else
 				{
-					result2 = m_sql.safe_query(
-						"SELECT MIN(Total), MAX(Total) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-						sitem.ID, szDate.c_str());
-				}
-				if (!result2.empty())
-				{
-					double total_real = 0;
-					std::vector<std::string> sd2 = result2[0];
-					if (sitem.subType == sTypeRAINWU || sitem.subType == sTypeRAINByRate)
-					{
-						total_real = atof(sd2[1].c_str());
-					}
-					else
-					{
-						float total_min = static_cast<float>(atof(sd2[0].c_str()));
-						float total_max = static_cast<float>(atof(splitresults[1].c_str()));
-						total_real = total_max - total_min;
-					}
-					rainmm = float(total_real);
+					float total_min = static_cast<float>(atof(sd2[0].c_str()));
+					float total_max = static_cast<float>(atof(splitresults[1].c_str()));
+					total_real = total_max - total_min;
 				}
+				rainmm = float(total_real);
 			}
-			break;
-		case pTypeP1Gas:
+		}
+		break;
+	case pTypeP1Gas:
+	{
+		float GasDivider = 1000.0F;
+		//get lowest value of today
+		std::string szDate = TimeToString(nullptr, TF_Date);
+		std::vector<std::vector<std::string> > result2;
+		result2 = m_sql.safe_query_read("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
+			sitem.ID, szDate.c_str());
+		if (!result2.empty())
 		{
-			float GasDivider = 1000.0F;
-			//get lowest value of today
+			std::vector<std::string> sd2 = result2[0];
+
+			uint64_t total_min_gas, total_real_gas;
+			uint64_t gasactual;
+
+			total_min_gas = std::stoull(sd2[0]);
+			gasactual = std::stoull(sitem.sValue);
+			total_real_gas = gasactual - total_min_gas;
+			utilityval = float(total_real_gas) / GasDivider;
+			isUtility = true;
+		}
+	}
+	break;
+	case pTypeRFXMeter:
+		if (sitem.subType == sTypeRFXMeterCount)
+		{
+			const _eMeterType metertype = (const _eMeterType)sitem.SwitchType;
+			float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
+
+			//get value of today
 			std::string szDate = TimeToString(nullptr, TF_Date);
 			std::vector<std::vector<std::string> > result2;
-			result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
+			result2 = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
 				sitem.ID, szDate.c_str());
 			if (!result2.empty())
 			{
 				std::vector<std::string> sd2 = result2[0];
 
-				uint64_t total_min_gas, total_real_gas;
-				uint64_t gasactual;
+				uint64_t total_min, total_max, total_real;
 
-				total_min_gas = std::stoull(sd2[0]);
-				gasactual = std::stoull(sitem.sValue);
-				total_real_gas = gasactual - total_min_gas;
-				utilityval = float(total_real_gas) / GasDivider;
+				total_min = std::stoull(sd2[0]);
+				total_max = std::stoull(sd2[1]);
+				total_real = total_max - total_min;
+
+				utilityval = float(total_real) / divider;
 				isUtility = true;
 			}
 		}
 		break;
-		case pTypeRFXMeter:
-			if (sitem.subType == sTypeRFXMeterCount)
-			{
-				const _eMeterType metertype = (const _eMeterType)sitem.switchtype;
-				float divider = m_sql.GetCounterDivider(int(metertype), int(sitem.devType), float(sitem.AddjValue2));
-
-				//get value of today
-				std::string szDate = TimeToString(nullptr, TF_Date);
-				std::vector<std::vector<std::string> > result2;
-				result2 = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-					sitem.ID, szDate.c_str());
-				if (!result2.empty())
-				{
-					std::vector<std::string> sd2 = result2[0];
-
-					uint64_t total_min, total_max, total_real;
-
-					total_min = std::stoull(sd2[0]);
-					total_max = std::stoull(sd2[1]);
-					total_real = total_max - total_min;
-
-					utilityval = float(total_real) / divider;
-					isUtility = true;
-				}
-			}
-			break;
-		default:
-			//Unknown device
-			continue;
-		}
+	default:
+		//Unknown device
+		return;
+	}
 
-		if (isTemp) {
-			m_tempValuesByName[sitem.deviceName] = temp;
-			m_tempValuesByID[sitem.ID] = temp;
-		}
-		if (isDew) {
-			m_dewValuesByName[sitem.deviceName] = dewpoint;
-			m_dewValuesByID[sitem.ID] = dewpoint;
-		}
-		if (isHum) {
-			m_humValuesByName[sitem.deviceName] = humidity;
-			m_humValuesByID[sitem.ID] = humidity;
-		}
-		if (isBaro) {
-			m_baroValuesByName[sitem.deviceName] = barometer;
-			m_baroValuesByID[sitem.ID] = barometer;
-		}
-		if (isUtility)
-		{
-			m_utilityValuesByName[sitem.deviceName] = utilityval;
-			m_utilityValuesByID[sitem.ID] = utilityval;
-		}
-		if (isRain) {
-			m_rainValuesByName[sitem.deviceName] = rainmm;
-			m_rainValuesByID[sitem.ID] = rainmm;
-			m_rainLastHourValuesByName[sitem.deviceName] = rainmmlasthour;
-			m_rainLastHourValuesByID[sitem.ID] = rainmmlasthour;
-		}
-		if (isWeather)
-		{
-			m_weatherValuesByName[sitem.deviceName] = weatherval;
-			m_weatherValuesByID[sitem.ID] = weatherval;
-		}
-		if (isUV) {
-			m_uvValuesByName[sitem.deviceName] = uv;
-			m_uvValuesByID[sitem.ID] = uv;
-		}
-		if (isWindDir) {
-			m_winddirValuesByName[sitem.deviceName] = winddir;
-			m_winddirValuesByID[sitem.ID] = winddir;
-		}
-		if (isWindSpeed) {
-			m_windspeedValuesByName[sitem.deviceName] = windspeed;
-			m_windspeedValuesByID[sitem.ID] = windspeed;
-		}
-		if (isWindGust) {
-			m_windgustValuesByName[sitem.deviceName] = windgust;
-			m_windgustValuesByID[sitem.ID] = windgust;
-		}
-		if (isZWaveAlarm)
-		{
-			m_zwaveAlarmValuesByName[sitem.deviceName] = alarmval;
-			m_zwaveAlarmValuesByID[sitem.ID] = alarmval;
-		}
+	if (isTemp) {
+		mstates.tempValuesByName[sitem.Name] = temp;
+		mstates.tempValuesByID[sitem.ID] = temp;
+	}
+	if (isDew) {
+		mstates.dewValuesByName[sitem.Name] = dewpoint;
+		mstates.dewValuesByID[sitem.ID] = dewpoint;
+	}
+	if (isHum) {
+		mstates.humValuesByName[sitem.Name] = humidity;
+		mstates.humValuesByID[sitem.ID] = humidity;
+	}
+	if (isBaro) {
+		mstates.baroValuesByName[sitem.Name] = barometer;
+		mstates.baroValuesByID[sitem.ID] = barometer;
+	}
+	if (isUtility)
+	{
+		mstates.utilityValuesByName[sitem.Name] = utilityval;
+		mstates.utilityValuesByID[sitem.ID] = utilityval;
+	}
+	if (isRain) {
+		mstates.rainValuesByName[sitem.Name] = rainmm;
+		mstates.rainValuesByID[sitem.ID] = rainmm;
+		mstates.rainLastHourValuesByName[sitem.Name] = rainmmlasthour;
+		mstates.rainLastHourValuesByID[sitem.ID] = rainmmlasthour;
+	}
+	if (isWeather)
+	{
+		mstates.weatherValuesByName[sitem.Name] = weatherval;
+		mstates.weatherValuesByID[sitem.ID] = weatherval;
+	}
+	if (isUV) {
+		mstates.uvValuesByName[sitem.Name] = uv;
+		mstates.uvValuesByID[sitem.ID] = uv;
+	}
+	if (isWindDir) {
+		mstates.winddirValuesByName[sitem.Name] = winddir;
+		mstates.winddirValuesByID[sitem.ID] = winddir;
+	}
+	if (isWindSpeed) {
+		mstates.windspeedValuesByName[sitem.Name] = windspeed;
+		mstates.windspeedValuesByID[sitem.ID] = windspeed;
+	}
+	if (isWindGust) {
+		mstates.windgustValuesByName[sitem.Name] = windgust;
+		mstates.windgustValuesByID[sitem.ID] = windgust;
+	}
+	if (isZWaveAlarm)
+	{
+		mstates.zwaveAlarmValuesByName[sitem.Name] = alarmval;
+		mstates.zwaveAlarmValuesByID[sitem.ID] = alarmval;
 	}
 }
 
@@ -1529,6 +1511,58 @@ void CEventSystem::ProcessMinute()
 	m_eventqueue.push(item);
 }
 
+//Cached directory listing, only read again when the directory itself has changed
+void CEventSystem::GetScriptFiles(std::vector<std::string> &entries, const std::string &dir)
+{
+	struct stat st;
+	if (stat(dir.c_str(), &st) != 0)
+		return;
+
+	std::vector<std::string> removedScripts;
+	{
+		std::lock_guard<std::mutex> l(m_scriptCatalogMutex);
+		_tScriptCatalog &catalog = m_scriptCatalog[dir];
+		//a change in the same second as the previous listing does not show in the modification time
+		if ((catalog.Listed == 0) || (st.st_mtime != catalog.DirModified) || (st.st_mtime >= catalog.Listed))
+		{
+			std::vector<std::string> previousFiles;
+			previousFiles.swap(catalog.Files);
+			DirectoryListing(catalog.Files, dir, false, true);
+			catalog.DirModified = st.st_mtime;
+			catalog.Listed = mytime(nullptr);
+
+			//dzVents scripts that are gone (deleted or renamed) leave their stored data behind
+			if ((dir == m_dzv_Dir) || (dir == CdzVents::GetInstance()->m_scriptsDir))
+			{
+				for (const auto &filename : previousFiles)
+				{
+					if ((filename.size() > 4) && (filename.compare(filename.size() - 4, 4, ".lua") == 0)
+						&& (std::find(catalog.Files.begin(), catalog.Files.end(), filename) == catalog.Files.end()))
+						removedScripts.push_back(filename.substr(0, filename.size() - 4));
+				}
+			}
+		}
+		entries.insert(entries.end(), catalog.Files.begin(), catalog.Files.end());
+	}
+	for (const auto &scriptName : removedScripts)
+		RemoveDzVentsScriptData(scriptName);
+}
+
+void CEventSystem::RemoveDzVentsScriptData(const std::string &scriptName)
+{
+	//internal scripts are only written to disk while active, and the other folder may have a script with the same name
+	if (
+		file_exist((m_dzv_Dir + scriptName + ".lua").c_str())
+		|| file_exist((CdzVents::GetInstance()->m_scriptsDir + scriptName + ".lua").c_str())
+		)
+		return;
+	auto result = m_sql.safe_query("SELECT ID FROM EventMaster WHERE (Interpreter=='dzVents') AND (Name=='%q')", scriptName.c_str());
+	if (!result.empty())
+		return;
+	_log.Log(LOG_STATUS, "dzVents: Removing stored data of script %s", scriptName.c_str());
+	m_sql.DeleteDzVentsData("__data_" + scriptName);
+}
+
 void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 {
 	if (!m_bEnabled)
@@ -1538,32 +1572,37 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 	std::string filename;
 #ifdef ENABLE_PYTHON
 	std::vector<std::string> FileEntriesPython;
-	DirectoryListing(FileEntriesPython, m_python_Dir, false, true);
+	GetScriptFiles(FileEntriesPython, m_python_Dir);
 #endif
 
 	if (!m_sql.m_bDisableDzVentsSystem)
 	{
 		CdzVents* dzvents = CdzVents::GetInstance();
-		if (dzvents->m_bdzVentsExist)
-			EvaluateLua(items, dzvents->m_runtimeDir + "dzVents.lua", "");
-		else
+		bool bRunDzVents = dzvents->m_bdzVentsExist;
+		if (!bRunDzVents)
 		{
-			DirectoryListing(FileEntries, dzvents->m_scriptsDir, false, true);
+			GetScriptFiles(FileEntries, dzvents->m_scriptsDir);
 			for (const auto &filename : FileEntries)
 			{
 				if (filename.length() > 4 &&
 					filename.compare(filename.length() - 4, 4, ".lua") == 0)
 				{
-					EvaluateLua(items, dzvents->m_runtimeDir + "dzVents.lua", "");
+					bRunDzVents = true;
 					break;
 				}
 			}
 			FileEntries.clear();
 		}
+		if (bRunDzVents)
+		{
+			auto tstart = std::chrono::steady_clock::now();
+			EvaluateLua(items, dzvents->m_runtimeDir + "dzVents.lua", "");
+			m_mainworker.m_metrics.AddScriptRun(CMetrics::SCRIPT_DZVENTS, ElapsedMicroseconds(tstart));
+		}
 	}
 
 	bool bDeviceFileFound = false;
-	DirectoryListing(FileEntries, m_lua_Dir, false, true);
+	GetScriptFiles(FileEntries, m_lua_Dir);
 	for (const auto &item : items)
 	{
 		for (const auto &filename : FileEntries)
@@ -1585,7 +1624,7 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 							if (deviceName == SpaceToUnderscore(LowerCase(item.devname)))
 							{
 								devicestatesMutexLock.unlock();
-								EvaluateLua(item, m_lua_Dir + filename, "");
+								TimedEvaluateLua(item, m_lua_Dir + filename, "");
 								break;
 							}
 						}
@@ -1593,7 +1632,7 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 					if (!bDeviceFileFound)
 					{
 						devicestatesMutexLock.unlock();
-						EvaluateLua(item, m_lua_Dir + filename, "");
+						TimedEvaluateLua(item, m_lua_Dir + filename, "");
 					}
 				}
 				else if ((item.reason == REASON_TIME && filename.find("_time_") != std::string::npos)
@@ -1601,7 +1640,7 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 					 || (item.reason == REASON_NOTIFICATION && filename.find("_notification_") != std::string::npos)
 					 || (item.reason == REASON_USERVARIABLE && filename.find("_variable_") != std::string::npos))
 				{
-					EvaluateLua(item, m_lua_Dir + filename, "");
+					TimedEvaluateLua(item, m_lua_Dir + filename, "");
 				}
 			}
 			// else _log.Log(LOG_STATUS,"EventSystem: ignore file not .lua or is demo file: %s", filename.c_str());
@@ -1622,7 +1661,7 @@ void CEventSystem::EvaluateEvent(const std::vector<_tEventQueue> &items)
 					    || (item.reason == REASON_SECURITY && filename.find("_security_") != std::string::npos)
 					    || (item.reason == REASON_USERVARIABLE && filename.find("_variable_") != std::string::npos))
 					{
-						EvaluatePython(item, m_python_Dir + filename, "");
+						TimedEvaluatePython(item, m_python_Dir + filename, "");
 					}
 				}
 				// else _log.Log(LOG_STATUS,"EventSystem: ignore file not .py or is demo file: %s", filename.c_str());
@@ -1715,119 +1754,119 @@ lua_State *CEventSystem::CreateBlocklyLuaState()
 	luaTable.Publish();
 	uservariablesMutexLock.unlock();
 
-	std::lock_guard<std::mutex> measurementStatesMutexLock(m_measurementStatesMutex);
-	GetCurrentMeasurementStates();
+	_tMeasurementStates mstates;
+	GetCurrentMeasurementStates(mstates);
 
-	if (!m_tempValuesByID.empty())
+	if (!mstates.tempValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "temperaturedevice", (int)m_tempValuesByID.size(), 0);
-		for (const auto &temp : m_tempValuesByID)
+		luaTable.InitTable(lua_state, "temperaturedevice", (int)mstates.tempValuesByID.size(), 0);
+		for (const auto &temp : mstates.tempValuesByID)
 			luaTable.AddNumber(temp.first, temp.second);
 		luaTable.Publish();
 	}
-	if (!m_dewValuesByID.empty())
+	if (!mstates.dewValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "dewpointdevice", (int)m_dewValuesByID.size(), 0);
-		for (const auto &dew : m_dewValuesByID)
+		luaTable.InitTable(lua_state, "dewpointdevice", (int)mstates.dewValuesByID.size(), 0);
+		for (const auto &dew : mstates.dewValuesByID)
 		{
 			luaTable.AddNumber(dew.first, dew.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_humValuesByID.empty())
+	if (!mstates.humValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "humiditydevice", (int)m_humValuesByID.size(), 0);
-		for (const auto &hum : m_humValuesByID)
+		luaTable.InitTable(lua_state, "humiditydevice", (int)mstates.humValuesByID.size(), 0);
+		for (const auto &hum : mstates.humValuesByID)
 		{
 			luaTable.AddNumber(hum.first, hum.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_baroValuesByID.empty())
+	if (!mstates.baroValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "barometerdevice", (int)m_baroValuesByID.size(), 0);
-		for (const auto &baro : m_baroValuesByID)
+		luaTable.InitTable(lua_state, "barometerdevice", (int)mstates.baroValuesByID.size(), 0);
+		for (const auto &baro : mstates.baroValuesByID)
 		{
 			luaTable.AddNumber(baro.first, baro.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_utilityValuesByID.empty())
+	if (!mstates.utilityValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "utilitydevice", (int)m_utilityValuesByID.size(), 0);
-		for (const auto &utility : m_utilityValuesByID)
+		luaTable.InitTable(lua_state, "utilitydevice", (int)mstates.utilityValuesByID.size(), 0);
+		for (const auto &utility : mstates.utilityValuesByID)
 		{
 			luaTable.AddNumber(utility.first, utility.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_weatherValuesByID.empty())
+	if (!mstates.weatherValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "weatherdevice", (int)m_weatherValuesByID.size(), 0);
-		for (const auto &weather : m_weatherValuesByID)
+		luaTable.InitTable(lua_state, "weatherdevice", (int)mstates.weatherValuesByID.size(), 0);
+		for (const auto &weather : mstates.weatherValuesByID)
 		{
 			luaTable.AddNumber(weather.first, weather.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_rainValuesByID.empty())
+	if (!mstates.rainValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "raindevice", (int)m_rainValuesByID.size(), 0);
-		for (const auto &rain : m_rainValuesByID)
+		luaTable.InitTable(lua_state, "raindevice", (int)mstates.rainValuesByID.size(), 0);
+		for (const auto &rain : mstates.rainValuesByID)
 		{
 			luaTable.AddNumber(rain.first, rain.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_rainLastHourValuesByID.empty())
+	if (!mstates.rainLastHourValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "rainlasthourdevice", (int)m_rainLastHourValuesByID.size(), 0);
-		for (const auto &rainlh : m_rainLastHourValuesByID)
+		luaTable.InitTable(lua_state, "rainlasthourdevice", (int)mstates.rainLastHourValuesByID.size(), 0);
+		for (const auto &rainlh : mstates.rainLastHourValuesByID)
 		{
 			luaTable.AddNumber(rainlh.first, rainlh.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_uvValuesByID.empty())
+	if (!mstates.uvValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "uvdevice", (int)m_uvValuesByID.size(), 0);
-		for (const auto &uv : m_uvValuesByID)
+		luaTable.InitTable(lua_state, "uvdevice", (int)mstates.uvValuesByID.size(), 0);
+		for (const auto &uv : mstates.uvValuesByID)
 		{
 			luaTable.AddNumber(uv.first, uv.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_winddirValuesByID.empty())
+	if (!mstates.winddirValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "winddirdevice", (int)m_winddirValuesByID.size(), 0);
-		for (const auto &winddir : m_winddirValuesByID)
+		luaTable.InitTable(lua_state, "winddirdevice", (int)mstates.winddirValuesByID.size(), 0);
+		for (const auto &winddir : mstates.winddirValuesByID)
 		{
 			luaTable.AddNumber(winddir.first, winddir.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_windspeedValuesByID.empty())
+	if (!mstates.windspeedValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "windspeeddevice", (int)m_windspeedValuesByID.size(), 0);
-		for (const auto &windspeed : m_windspeedValuesByID)
+		luaTable.InitTable(lua_state, "windspeeddevice", (int)mstates.windspeedValuesByID.size(), 0);
+		for (const auto &windspeed : mstates.windspeedValuesByID)
 		{
 			luaTable.AddNumber(windspeed.first, windspeed.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_windgustValuesByID.empty())
+	if (!mstates.windgustValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "windgustdevice", (int)m_windgustValuesByID.size(), 0);
-		for (const auto &windgust : m_windgustValuesByID)
+		luaTable.InitTable(lua_state, "windgustdevice", (int)mstates.windgustValuesByID.size(), 0);
+		for (const auto &windgust : mstates.windgustValuesByID)
 		{
 			luaTable.AddNumber(windgust.first, windgust.second);
 		}
 		luaTable.Publish();
 	}
-	if (!m_zwaveAlarmValuesByID.empty())
+	if (!mstates.zwaveAlarmValuesByID.empty())
 	{
-		luaTable.InitTable(lua_state, "zwavealarms", (int)m_zwaveAlarmValuesByID.size(), 0);
-		for (const auto &alarm : m_zwaveAlarmValuesByID)
+		luaTable.InitTable(lua_state, "zwavealarms", (int)mstates.zwaveAlarmValuesByID.size(), 0);
+		for (const auto &alarm : mstates.zwaveAlarmValuesByID)
 		{
 			luaTable.AddNumber(alarm.first, alarm.second);
 		}
@@ -1880,6 +1919,22 @@ lua_State *CEventSystem::ParseBlocklyLua(lua_State *lua_state, const _tEventItem
 	return lua_state;
 }
 
+void CEventSystem::TimedEvaluateLua(const _tEventQueue &item, const std::string &filename, const std::string &LuaString)
+{
+	auto tstart = std::chrono::steady_clock::now();
+	EvaluateLua(item, filename, LuaString);
+	m_mainworker.m_metrics.AddScriptRun(CMetrics::SCRIPT_LUA, ElapsedMicroseconds(tstart));
+}
+
+#ifdef ENABLE_PYTHON
+void CEventSystem::TimedEvaluatePython(const _tEventQueue &item, const std::string &filename, const std::string &PyString)
+{
+	auto tstart = std::chrono::steady_clock::now();
+	EvaluatePython(item, filename, PyString);
+	m_mainworker.m_metrics.AddScriptRun(CMetrics::SCRIPT_PYTHON, ElapsedMicroseconds(tstart));
+}
+#endif
+
 void CEventSystem::EvaluateDatabaseEvents(const _tEventQueue &item)
 {
 	lua_State *lua_state = nullptr;
@@ -1925,16 +1980,20 @@ void CEventSystem::EvaluateDatabaseEvents(const _tEventQueue &item)
 					}
 
 					if (found != std::string::npos)
+					{
+						auto tstart = std::chrono::steady_clock::now();
 						lua_state = ParseBlocklyLua(lua_state, event);
+						m_mainworker.m_metrics.AddScriptRun(CMetrics::SCRIPT_BLOCKLY, ElapsedMicroseconds(tstart));
+					}
 				}
 				else if (event.Interpreter == "Lua")
-					EvaluateLua(item, event.Name, event.Actions);
+					TimedEvaluateLua(item, event.Name, event.Actions);
 
 				else if (event.Interpreter == "Python")
 				{
 #ifdef ENABLE_PYTHON
 					boost::unique_lock<boost::shared_mutex> uservariablesMutexLock(m_uservariablesMutex);
-					EvaluatePython(item, event.Name, event.Actions);
+					TimedEvaluatePython(item, event.Name, event.Actions);
 #else
 					_log.Log(LOG_ERROR, "EventSystem: Error processing database scripts, Python not enabled");
 #endif
@@ -1971,10 +2030,19 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	if (dindex == -1)
 		return ret;
 
+	//parse only the referenced device, straight from the device state store
+	_tMeasurementStates mstates;
+	if (Argument.find("variable") != 0)
+	{
+		CDeviceStateStore::_tDeviceStatePtr state = m_mainworker.m_devicestore.Get(dindex);
+		if (state)
+			AddMeasurementState(mstates, *state);
+	}
+
 	if (Argument.find("temperaturedevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_tempValuesByID.find(dindex);
-		if (itt != m_tempValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.tempValuesByID.find(dindex);
+		if (itt != mstates.tempValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -1983,8 +2051,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("dewpointdevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_dewValuesByID.find(dindex);
-		if (itt != m_dewValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.dewValuesByID.find(dindex);
+		if (itt != mstates.dewValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -1993,8 +2061,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("humiditydevice") == 0)
 	{
-		std::map<uint64_t, int>::const_iterator itt = m_humValuesByID.find(dindex);
-		if (itt != m_humValuesByID.end())
+		std::map<uint64_t, int>::const_iterator itt = mstates.humValuesByID.find(dindex);
+		if (itt != mstates.humValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2003,8 +2071,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("barometerdevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_baroValuesByID.find(dindex);
-		if (itt != m_baroValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.baroValuesByID.find(dindex);
+		if (itt != mstates.baroValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2013,8 +2081,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("utilitydevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_utilityValuesByID.find(dindex);
-		if (itt != m_utilityValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.utilityValuesByID.find(dindex);
+		if (itt != mstates.utilityValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2023,8 +2091,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("weatherdevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_weatherValuesByID.find(dindex);
-		if (itt != m_weatherValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.weatherValuesByID.find(dindex);
+		if (itt != mstates.weatherValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2033,8 +2101,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("raindevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_rainValuesByID.find(dindex);
-		if (itt != m_rainValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.rainValuesByID.find(dindex);
+		if (itt != mstates.rainValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2043,8 +2111,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("rainlasthourdevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_rainLastHourValuesByID.find(dindex);
-		if (itt != m_rainLastHourValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.rainLastHourValuesByID.find(dindex);
+		if (itt != mstates.rainLastHourValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2053,8 +2121,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("uvdevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_uvValuesByID.find(dindex);
-		if (itt != m_uvValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.uvValuesByID.find(dindex);
+		if (itt != mstates.uvValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2063,8 +2131,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("winddirdevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_winddirValuesByID.find(dindex);
-		if (itt != m_winddirValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.winddirValuesByID.find(dindex);
+		if (itt != mstates.winddirValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2073,8 +2141,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("windspeeddevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_windspeedValuesByID.find(dindex);
-		if (itt != m_windspeedValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.windspeedValuesByID.find(dindex);
+		if (itt != mstates.windspeedValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2083,8 +2151,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("windgustdevice") == 0)
 	{
-		std::map<uint64_t, float>::const_iterator itt = m_windgustValuesByID.find(dindex);
-		if (itt != m_windgustValuesByID.end())
+		std::map<uint64_t, float>::const_iterator itt = mstates.windgustValuesByID.find(dindex);
+		if (itt != mstates.windgustValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << itt->second;
@@ -2101,8 +2169,8 @@ std::string CEventSystem::ProcessVariableArgument(const std::string &Argument)
 	}
 	else if (Argument.find("zwavealarms") == 0)
 	{
-		std::map<uint64_t, int>::const_iterator itt = m_zwaveAlarmValuesByID.find(dindex);
-		if (itt != m_zwaveAlarmValuesByID.end())
+		std::map<uint64_t, int>::const_iterator itt = mstates.zwaveAlarmValuesByID.find(dindex);
+		if (itt != mstates.zwaveAlarmValuesByID.end())
 		{
 			std::stringstream sstr;
 			sstr << (int)itt->second;
@@ -2676,8 +2744,8 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 	lua_setglobal(lua_state, "print");
 
 	{
-		std::lock_guard<std::mutex> measurementStatesMutexLock(m_measurementStatesMutex);
-		GetCurrentMeasurementStates();
+		_tMeasurementStates mstates;
+		GetCurrentMeasurementStates(mstates);
 
 		float thisDeviceTemp = 0;
 		float thisDeviceDew = 0;
@@ -2693,10 +2761,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 		float thisDeviceWeather = 0;
 		int thisZwaveAlarm = 0;
 
-		if (!m_tempValuesByName.empty())
+		if (!mstates.tempValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_temperature", (int)m_tempValuesByName.size(), 0);
-			for (const auto &temp : m_tempValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_temperature", (int)mstates.tempValuesByName.size(), 0);
+			for (const auto &temp : mstates.tempValuesByName)
 			{
 				luaTable.AddNumber(temp.first, temp.second);
 				if (temp.first == item.devname)
@@ -2706,10 +2774,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_dewValuesByName.empty())
+		if (!mstates.dewValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_dewpoint", (int)m_dewValuesByName.size(), 0);
-			for (const auto &dew : m_dewValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_dewpoint", (int)mstates.dewValuesByName.size(), 0);
+			for (const auto &dew : mstates.dewValuesByName)
 			{
 				luaTable.AddNumber(dew.first, dew.second);
 				if (dew.first == item.devname)
@@ -2719,10 +2787,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_humValuesByName.empty())
+		if (!mstates.humValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_humidity", (int)m_humValuesByName.size(), 0);
-			for (const auto &hum : m_humValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_humidity", (int)mstates.humValuesByName.size(), 0);
+			for (const auto &hum : mstates.humValuesByName)
 			{
 				luaTable.AddNumber(hum.first, hum.second);
 				if (hum.first == item.devname)
@@ -2732,10 +2800,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_baroValuesByName.empty())
+		if (!mstates.baroValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_barometer", (int)m_baroValuesByName.size(), 0);
-			for (const auto &baro : m_baroValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_barometer", (int)mstates.baroValuesByName.size(), 0);
+			for (const auto &baro : mstates.baroValuesByName)
 			{
 				luaTable.AddNumber(baro.first, baro.second);
 				if (baro.first == item.devname)
@@ -2745,10 +2813,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_utilityValuesByName.empty())
+		if (!mstates.utilityValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_utility", (int)m_utilityValuesByName.size(), 0);
-			for (const auto &utility : m_utilityValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_utility", (int)mstates.utilityValuesByName.size(), 0);
+			for (const auto &utility : mstates.utilityValuesByName)
 			{
 				luaTable.AddNumber(utility.first, utility.second);
 				if (utility.first == item.devname)
@@ -2758,10 +2826,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_rainValuesByName.empty())
+		if (!mstates.rainValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_rain", (int)m_rainValuesByName.size(), 0);
-			for (const auto &rain : m_rainValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_rain", (int)mstates.rainValuesByName.size(), 0);
+			for (const auto &rain : mstates.rainValuesByName)
 			{
 				luaTable.AddNumber(rain.first, rain.second);
 				if (rain.first == item.devname)
@@ -2771,10 +2839,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_rainLastHourValuesByName.empty())
+		if (!mstates.rainLastHourValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_rain_lasthour", (int)m_rainLastHourValuesByName.size(), 0);
-			for (const auto &rainlh : m_rainLastHourValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_rain_lasthour", (int)mstates.rainLastHourValuesByName.size(), 0);
+			for (const auto &rainlh : mstates.rainLastHourValuesByName)
 			{
 				luaTable.AddNumber(rainlh.first, rainlh.second);
 				if (rainlh.first == item.devname)
@@ -2784,10 +2852,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_uvValuesByName.empty())
+		if (!mstates.uvValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_uv", (int)m_uvValuesByName.size(), 0);
-			for (const auto &uv : m_uvValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_uv", (int)mstates.uvValuesByName.size(), 0);
+			for (const auto &uv : mstates.uvValuesByName)
 			{
 				luaTable.AddNumber(uv.first, uv.second);
 				if (uv.first == item.devname)
@@ -2797,10 +2865,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_winddirValuesByName.empty())
+		if (!mstates.winddirValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_winddir", (int)m_winddirValuesByName.size(), 0);
-			for (const auto &winddir : m_winddirValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_winddir", (int)mstates.winddirValuesByName.size(), 0);
+			for (const auto &winddir : mstates.winddirValuesByName)
 			{
 				luaTable.AddNumber(winddir.first, winddir.second);
 				// if (winddir.first == item.devname) {
@@ -2809,10 +2877,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_windspeedValuesByName.empty())
+		if (!mstates.windspeedValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_windspeed", (int)m_windspeedValuesByName.size(), 0);
-			for (const auto &windspeed : m_windspeedValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_windspeed", (int)mstates.windspeedValuesByName.size(), 0);
+			for (const auto &windspeed : mstates.windspeedValuesByName)
 			{
 				luaTable.AddNumber(windspeed.first, windspeed.second);
 				// if (windspeed.first == item.devname) {
@@ -2821,10 +2889,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_windgustValuesByName.empty())
+		if (!mstates.windgustValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_windgust", (int)m_windgustValuesByName.size(), 0);
-			for (const auto &windgust : m_windgustValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_windgust", (int)mstates.windgustValuesByName.size(), 0);
+			for (const auto &windgust : mstates.windgustValuesByName)
 			{
 				luaTable.AddNumber(windgust.first, windgust.second);
 				// if (windgust.first == item.devname) {
@@ -2833,10 +2901,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_weatherValuesByName.empty())
+		if (!mstates.weatherValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_weather", (int)m_weatherValuesByName.size(), 0);
-			for (const auto &weather : m_weatherValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_weather", (int)mstates.weatherValuesByName.size(), 0);
+			for (const auto &weather : mstates.weatherValuesByName)
 			{
 				luaTable.AddNumber(weather.first, weather.second);
 				if (weather.first == item.devname)
@@ -2846,10 +2914,10 @@ void CEventSystem::EvaluateLuaClassic(lua_State *lua_state, const _tEventQueue &
 			}
 			luaTable.Publish();
 		}
-		if (!m_zwaveAlarmValuesByName.empty())
+		if (!mstates.zwaveAlarmValuesByName.empty())
 		{
-			CLuaTable luaTable(lua_state, "otherdevices_zwavealarms", (int)m_zwaveAlarmValuesByName.size(), 0);
-			for (const auto &alarm : m_zwaveAlarmValuesByName)
+			CLuaTable luaTable(lua_state, "otherdevices_zwavealarms", (int)mstates.zwaveAlarmValuesByName.size(), 0);
+			for (const auto &alarm : mstates.zwaveAlarmValuesByName)
 			{
 				luaTable.AddNumber(alarm.first, alarm.second);
 				if (alarm.first == item.devname)
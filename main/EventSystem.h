@@ -9,6 +9,7 @@
 #include "concurrent_queue.h"
 #include "StoppableTask.h"
 #include "NotificationObserver.h"
+#include "DeviceStateStore.h"
 
 class CEventSystem : public CLuaCommon, StoppableTask, CNotificationObserver
 {
@@ -157,6 +158,38 @@ private:
 		_eJsonType eType;
 	};
 
+	//measurement values parsed from the device state store, built per script run
+	struct _tMeasurementStates
+	{
+		std::map<std::string, float> tempValuesByName;
+		std::map<std::string, float> dewValuesByName;
+		std::map<std::string, float> rainValuesByName;
+		std::map<std::string, float> rainLastHourValuesByName;
+		std::map<std::string, float> uvValuesByName;
+		std::map<std::string, float> weatherValuesByName;
+		std::map<std::string, int> humValuesByName;
+		std::map<std::string, float> baroValuesByName;
+		std::map<std::string, float> utilityValuesByName;
+		std::map<std::string, float> winddirValuesByName;
+		std::map<std::string, float> windspeedValuesByName;
+		std::map<std::string, float> windgustValuesByName;
+		std::map<std::string, int> zwaveAlarmValuesByName;
+
+		std::map<uint64_t, float> tempValuesByID;
+		std::map<uint64_t, float> dewValuesByID;
+		std::map<uint64_t, float> rainValuesByID;
+		std::map<uint64_t, float> rainLastHourValuesByID;
+		std::map<uint64_t, float> uvValuesByID;
+		std::map<uint64_t, float> weatherValuesByID;
+		std::map<uint64_t, int> humValuesByID;
+		std::map<uint64_t, float> baroValuesByID;
+		std::map<uint64_t, float> utilityValuesByID;
+		std::map<uint64_t, float> winddirValuesByID;
+		std::map<uint64_t, float> windspeedValuesByID;
+		std::map<uint64_t, float> windgustValuesByID;
+		std::map<uint64_t, int> zwaveAlarmValuesByID;
+	};
+
 	struct _tEventTrigger
 	{
 		uint64_t ID;
@@ -192,25 +225,37 @@ private:
 	boost::shared_mutex m_uservariablesMutex;
 	boost::shared_mutex m_scenesgroupsMutex;
 	boost::shared_mutex m_eventtriggerMutex;
-	std::mutex m_measurementStatesMutex;
 	std::mutex luaMutex;
 	std::shared_ptr<std::thread> m_thread;
 	std::shared_ptr<std::thread> m_eventqueuethread;
 	StoppableTask m_TaskQueue;
 	int m_SecStatus;
 	std::string m_lua_Dir;
+	std::string m_dzv_Dir;
 	std::string m_szStartTime;
 
+	struct _tScriptCatalog
+	{
+		time_t DirModified = 0;
+		time_t Listed = 0;
+		std::vector<std::string> Files;
+	};
+	std::map<std::string, _tScriptCatalog> m_scriptCatalog;
+	std::mutex m_scriptCatalogMutex;
+
 	static const std::string m_szReason[], m_szSecStatus[];
 	static const _tJsonMap JsonMap[];
 
 	//our thread
 	void Do_Work();
 	void ProcessMinute();
-	void GetCurrentMeasurementStates();
+	void GetCurrentMeasurementStates(_tMeasurementStates &mstates);
+	void AddMeasurementState(_tMeasurementStates &mstates, const CDeviceStateStore::_tDeviceState &sitem);
 	std::string UpdateSingleState(uint64_t ulDevID, const std::string &devname, int nValue, const std::string &sValue, unsigned char devType, unsigned char subType, _eSwitchType switchType,
 				      const std::string &lastUpdate, unsigned char lastLevel, unsigned char batteryLevel, const std::map<std::string, std::string> &options);
 	void EvaluateEvent(const std::vector<_tEventQueue> &items);
+	void GetScriptFiles(std::vector<std::string> &entries, const std::string &dir);
+	void RemoveDzVentsScriptData(const std::string &scriptName);
 	void EvaluateDatabaseEvents(const _tEventQueue &item);
 	lua_State *ParseBlocklyLua(lua_State *lua_state, const _tEventItem &item);
 	bool parseBlocklyActions(const _tEventItem &item);
@@ -218,8 +263,10 @@ private:
 #ifdef ENABLE_PYTHON
 	std::string m_python_Dir;
 	void EvaluatePython(const _tEventQueue &item, const std::string &filename, const std::string &PyString);
+	void TimedEvaluatePython(const _tEventQueue &item, const std::string &filename, const std::string &PyString);
 #endif
 	void EvaluateLua(const _tEventQueue &item, const std::string &filename, const std::string &LuaString);
+	void TimedEvaluateLua(const _tEventQueue &item, const std::string &filename, const std::string &LuaString);
 	void EvaluateLua(const std::vector<_tEventQueue> &items, const std::string &filename, const std::string &LuaString);
 	void luaThread(lua_State *lua_state, const std::string &filename);
 	static void luaStop(lua_State *L, lua_Debug *ar);
@@ -246,33 +293,6 @@ private:
 	std::map<uint64_t, _tDeviceStatus> m_devicestates;
 	std::map<uint64_t, _tUserVariable> m_uservariables;
 	std::map<uint64_t, _tScenesGroups> m_scenesgroups;
-	std::map<std::string, float> m_tempValuesByName;
-	std::map<std::string, float> m_dewValuesByName;
-	std::map<std::string, float> m_rainValuesByName;
-	std::map<std::string, float> m_rainLastHourValuesByName;
-	std::map<std::string, float> m_uvValuesByName;
-	std::map<std::string, float> m_weatherValuesByName;
-	std::map<std::string, int>	 m_humValuesByName;
-	std::map<std::string, float> m_baroValuesByName;
-	std::map<std::string, float> m_utilityValuesByName;
-	std::map<std::string, float> m_winddirValuesByName;
-	std::map<std::string, float> m_windspeedValuesByName;
-	std::map<std::string, float> m_windgustValuesByName;
-	std::map<std::string, int>	 m_zwaveAlarmValuesByName;
-
-	std::map<uint64_t, float> m_tempValuesByID;
-	std::map<uint64_t, float> m_dewValuesByID;
-	std::map<uint64_t, float> m_rainValuesByID;
-	std::map<uint64_t, float> m_rainLastHourValuesByID;
-	std::map<uint64_t, float> m_uvValuesByID;
-	std::map<uint64_t, float> m_weatherValuesByID;
-	std::map<uint64_t, int>	m_humValuesByID;
-	std::map<uint64_t, float> m_baroValuesByID;
-	std::map<uint64_t, float> m_utilityValuesByID;
-	std::map<uint64_t, float> m_winddirValuesByID;
-	std::map<uint64_t, float> m_windspeedValuesByID;
-	std::map<uint64_t, float> m_windgustValuesByID;
-	std::map<uint64_t, int> m_zwaveAlarmValuesByID;
 
 	void reportMissingDevice(int deviceID, const _tEventItem &item);
 	int getSunRiseSunSetMinutes(const std::string &what);
@@ -0,0 +1,339 @@
+#include "stdafx.h"
+#include "Metrics.h"
+#include "Helper.h"
+#include "Logger.h"
+#include "RFXtrx.h"
+#include "SQLHelper.h"
+#include "mainworker.h"
+#include "../hardware/hardwaretypes.h"
+#include "../webserver/GZipHelper.h"
+#include <inttypes.h>
+
+//Seconds a rendered scrape is served again before it is rebuilt
+#define METRICS_CACHE_SECONDS 5
+
+const CMetrics::_tMetricsValueDesc CMetrics::ValueDesc[MVALUE_END] = {
+	{ "domoticz_temperature_celsius", "Temperature", "gauge" },
+	{ "domoticz_humidity_percent", "Relative humidity", "gauge" },
+	{ "domoticz_barometer_hpa", "Barometric pressure", "gauge" },
+	{ "domoticz_power_watts", "Actual power usage", "gauge" },
+	{ "domoticz_energy_wh_total", "Energy meter total", "counter" },
+	{ "domoticz_voltage_volts", "Voltage", "gauge" },
+	{ "domoticz_current_amperes", "Current, summed over all channels", "gauge" },
+	{ "domoticz_illuminance_lux", "Illuminance", "gauge" },
+	{ "domoticz_percentage", "Percentage sensor value", "gauge" },
+	{ "domoticz_setpoint_celsius", "Thermostat setpoint", "gauge" },
+	{ "domoticz_switch_state", "Switch state (nValue)", "gauge" },
+};
+
+static const char *szScriptEngines[CMetrics::SCRIPT_END] = { "dzvents", "lua", "python", "blockly" };
+
+CMetrics::CMetrics()
+{
+	m_sqlQueries = 0;
+	m_sqlMicroseconds = 0;
+	for (int ii = 0; ii < SCRIPT_END; ii++)
+	{
+		m_scriptRuns[ii] = 0;
+		m_scriptMicroseconds[ii] = 0;
+	}
+	m_cacheTime = 0;
+}
+
+void CMetrics::AddSQLQuery(const uint64_t usec)
+{
+	m_sqlQueries++;
+	m_sqlMicroseconds += usec;
+}
+
+void CMetrics::AddScriptRun(const _eScriptEngine engine, const uint64_t usec)
+{
+	m_scriptRuns[engine]++;
+	m_scriptMicroseconds[engine] += usec;
+}
+
+void CMetrics::ParseValues(_tMetricsDevice &device, const uint8_t devType, const uint8_t subType, const int nValue, const std::string &sValue)
+{
+	std::vector<std::string> strarray;
+	StringSplit(sValue, ";", strarray);
+	size_t nsize = strarray.size();
+	double fValue = atof(sValue.c_str());
+
+	device.ValidMask = 0;
+	auto setValue = [&device](const _eMetricValue metric, const double value) {
+		device.Values[metric] = value;
+		device.ValidMask |= (1 << metric);
+	};
+
+	if (IsLightOrSwitch(devType, subType))
+	{
+		setValue(MVALUE_SWITCH, nValue);
+		return;
+	}
+
+	switch (devType)
+	{
+	case pTypeTEMP:
+	case pTypeRego6XXTemp:
+		setValue(MVALUE_TEMPERATURE, fValue);
+		break;
+	case pTypeHUM:
+		setValue(MVALUE_HUMIDITY, nValue);
+		break;
+	case pTypeTEMP_HUM:
+		if (nsize >= 2)
+		{
+			setValue(MVALUE_TEMPERATURE, atof(strarray[0].c_str()));
+			setValue(MVALUE_HUMIDITY, atof(strarray[1].c_str()));
+		}
+		break;
+	case pTypeTEMP_HUM_BARO:
+		if (nsize >= 4)
+		{
+			setValue(MVALUE_TEMPERATURE, atof(strarray[0].c_str()));
+			setValue(MVALUE_HUMIDITY, atof(strarray[1].c_str()));
+			setValue(MVALUE_BAROMETER, atof(strarray[3].c_str()));
+		}
+		break;
+	case pTypeTEMP_BARO:
+		if (nsize >= 2)
+		{
+			setValue(MVALUE_TEMPERATURE, atof(strarray[0].c_str()));
+			setValue(MVALUE_BAROMETER, atof(strarray[1].c_str()));
+		}
+		break;
+	case pTypeRFXSensor:
+		if (subType == sTypeRFXSensorTemp)
+			setValue(MVALUE_TEMPERATURE, fValue);
+		break;
+	case pTypeThermostat:
+		if (subType == sTypeThermSetpoint)
+			setValue(MVALUE_SETPOINT, fValue);
+		break;
+	case pTypeUsage:
+		setValue(MVALUE_POWER, fValue);
+		break;
+	case pTypeYouLess:
+		if (nsize >= 2)
+			setValue(MVALUE_POWER, atof(strarray[1].c_str()));
+		break;
+	case pTypeP1Power:
+		if (nsize >= 5)
+		{
+			setValue(MVALUE_ENERGY, atof(strarray[0].c_str()) + atof(strarray[1].c_str()));
+			setValue(MVALUE_POWER, atof(strarray[4].c_str()));
+		}
+		break;
+	case pTypeCURRENT:
+	case pTypeCURRENTENERGY:
+		if (nsize >= 3)
+			setValue(MVALUE_CURRENT, atof(strarray[0].c_str()) + atof(strarray[1].c_str()) + atof(strarray[2].c_str()));
+		break;
+	case pTypeLux:
+		setValue(MVALUE_ILLUMINANCE, fValue);
+		break;
+	case pTypeGeneral:
+		switch (subType)
+		{
+		case sTypeKwh:
+			if (nsize >= 2)
+			{
+				setValue(MVALUE_POWER, atof(strarray[0].c_str()));
+				setValue(MVALUE_ENERGY, atof(strarray[1].c_str()));
+			}
+			break;
+		case sTypeVoltage:
+			setValue(MVALUE_VOLTAGE, fValue);
+			break;
+		case sTypeCurrent:
+			setValue(MVALUE_CURRENT, fValue);
+			break;
+		case sTypePercentage:
+			setValue(MVALUE_PERCENTAGE, fValue);
+			break;
+		case sTypeBaro:
+			setValue(MVALUE_BAROMETER, fValue);
+			break;
+		default:
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void AppendLabel(std::string &szOut, const char *szName, const std::string &szValue)
+{
+	szOut += szName;
+	szOut += "=\"";
+	for (const char c : szValue)
+	{
+		if (c == '\\')
+			szOut += "\\\\";
+		else if (c == '"')
+			szOut += "\\\"";
+		else if (c == '\n')
+			szOut += "\\n";
+		else
+			szOut += c;
+	}
+	szOut += '"';
+}
+
+static void AppendValue(std::string &szOut, const double value)
+{
+	char szTmp[40];
+	snprintf(szTmp, sizeof(szTmp), " %.10g\n", value);
+	szOut += szTmp;
+}
+
+static void AppendHeader(std::string &szOut, const char *szName, const char *szHelp, const char *szType)
+{
+	szOut += std_format("# HELP %s %s\n# TYPE %s %s\n", szName, szHelp, szName, szType);
+}
+
+std::string CMetrics::Render()
+{
+	std::string szOut;
+
+	{
+		//Values are parsed from a snapshot of the device state store, nothing is locked while rendering
+		std::vector<CDeviceStateStore::_tDeviceStatePtr> states;
+		m_mainworker.m_devicestore.GetSnapshot(states);
+		szOut.reserve(states.size() * 160 + 4096);
+
+		//Device labels are the same for every family, build them once
+		std::vector<_tMetricsDevice> devices;
+		std::vector<std::pair<const _tMetricsDevice *, std::string>> labels;
+		devices.reserve(states.size()); //no reallocation, labels keep pointers into it
+		labels.reserve(states.size());
+		for (const auto &state : states)
+		{
+			if (!state->bUsed)
+				continue;
+			devices.emplace_back();
+			_tMetricsDevice &device = devices.back();
+			device.BatteryLevel = state->BatteryLevel;
+			device.SignalLevel = state->SignalLevel;
+			ParseValues(device, state->devType, state->subType, state->nValue, state->sValue);
+
+			std::string szLabels = std_format("{idx=\"%" PRIu64 "\",hardware=\"%d\",", state->ID, state->HardwareID);
+			AppendLabel(szLabels, "name", state->Name);
+			szLabels += '}';
+			labels.emplace_back(&device, szLabels);
+		}
+		for (int ii = 0; ii < MVALUE_END; ii++)
+		{
+			bool bHeader = false;
+			for (const auto &label : labels)
+			{
+				if (!(label.first->ValidMask & (1 << ii)))
+					continue;
+				if (!bHeader)
+				{
+					AppendHeader(szOut, ValueDesc[ii].szName, ValueDesc[ii].szHelp, ValueDesc[ii].szType);
+					bHeader = true;
+				}
+				szOut += ValueDesc[ii].szName;
+				szOut += label.second;
+				AppendValue(szOut, label.first->Values[ii]);
+			}
+		}
+
+		AppendHeader(szOut, "domoticz_battery_percent", "Battery level", "gauge");
+		for (const auto &label : labels)
+		{
+			if ((label.first->BatteryLevel < 0) || (label.first->BatteryLevel > 100))
+				continue; //255 = no battery
+			szOut += "domoticz_battery_percent";
+			szOut += label.second;
+			AppendValue(szOut, label.first->BatteryLevel);
+		}
+
+		AppendHeader(szOut, "domoticz_signal_level", "Radio signal level (0-11)", "gauge");
+		for (const auto &label : labels)
+		{
+			if ((label.first->SignalLevel < 0) || (label.first->SignalLevel > 11))
+				continue; //12 = not available
+			szOut += "domoticz_signal_level";
+			szOut += label.second;
+			AppendValue(szOut, label.first->SignalLevel);
+		}
+	}
+
+	time_t now = mytime(nullptr);
+
+	std::vector<_tHardwareStatus> hardware;
+	m_mainworker.GetHardwareStatus(hardware);
+	AppendHeader(szOut, "domoticz_hardware_started", "Hardware is started", "gauge");
+	for (const auto &hw : hardware)
+	{
+		szOut += std_format("domoticz_hardware_started{hardware=\"%d\",", hw.ID);
+		AppendLabel(szOut, "name", hw.Name);
+		szOut += '}';
+		AppendValue(szOut, hw.bStarted ? 1 : 0);
+	}
+	AppendHeader(szOut, "domoticz_hardware_heartbeat_age_seconds", "Seconds since the hardware worker last reported a heartbeat", "gauge");
+	for (const auto &hw : hardware)
+	{
+		if (hw.LastHeartbeat == 0)
+			continue;
+		szOut += std_format("domoticz_hardware_heartbeat_age_seconds{hardware=\"%d\",", hw.ID);
+		AppendLabel(szOut, "name", hw.Name);
+		szOut += '}';
+		AppendValue(szOut, difftime(now, hw.LastHeartbeat));
+	}
+	AppendHeader(szOut, "domoticz_hardware_receive_age_seconds", "Seconds since data was last received from the hardware", "gauge");
+	for (const auto &hw : hardware)
+	{
+		if (hw.LastReceive == 0)
+			continue;
+		szOut += std_format("domoticz_hardware_receive_age_seconds{hardware=\"%d\",", hw.ID);
+		AppendLabel(szOut, "name", hw.Name);
+		szOut += '}';
+		AppendValue(szOut, difftime(now, hw.LastReceive));
+	}
+
+	AppendHeader(szOut, "domoticz_rx_queue_length", "Received messages waiting to be decoded", "gauge");
+	szOut += "domoticz_rx_queue_length";
+	AppendValue(szOut, (double)m_mainworker.GetRxQueueSize());
+
+	AppendHeader(szOut, "domoticz_sql_query_seconds", "Time spent in SQL queries", "summary");
+	szOut += "domoticz_sql_query_seconds_sum";
+	AppendValue(szOut, m_sqlMicroseconds / 1000000.0);
+	szOut += "domoticz_sql_query_seconds_count";
+	AppendValue(szOut, (double)m_sqlQueries);
+
+	AppendHeader(szOut, "domoticz_event_script_seconds", "Time spent evaluating event scripts", "summary");
+	for (int ii = 0; ii < SCRIPT_END; ii++)
+	{
+		szOut += std_format("domoticz_event_script_seconds_sum{engine=\"%s\"}", szScriptEngines[ii]);
+		AppendValue(szOut, m_scriptMicroseconds[ii] / 1000000.0);
+		szOut += std_format("domoticz_event_script_seconds_count{engine=\"%s\"}", szScriptEngines[ii]);
+		AppendValue(szOut, (double)m_scriptRuns[ii]);
+	}
+	return szOut;
+}
+
+std::string CMetrics::GetMetrics(const bool bGZip)
+{
+	std::lock_guard<std::mutex> l(m_cacheMutex);
+	time_t now = mytime(nullptr);
+	if ((m_cache.empty()) || (now - m_cacheTime >= METRICS_CACHE_SECONDS) || (now < m_cacheTime))
+	{
+		m_cache = Render();
+		m_cacheGZip.clear();
+		m_cacheTime = now;
+	}
+	if (!bGZip)
+		return m_cache;
+	if (m_cacheGZip.empty())
+	{
+		CA2GZIP gzip((char *)m_cache.c_str(), (int)m_cache.size());
+		if (gzip.Length <= 0)
+			return std::string();
+		m_cacheGZip.assign((char *)gzip.pgzip, gzip.Length);
+	}
+	return m_cacheGZip;
+}
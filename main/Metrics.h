@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Prometheus text exposition of device values and internal health, rendered from memory
+class CMetrics
+{
+public:
+	enum _eScriptEngine
+	{
+		SCRIPT_DZVENTS = 0,
+		SCRIPT_LUA,
+		SCRIPT_PYTHON,
+		SCRIPT_BLOCKLY,
+		SCRIPT_END
+	};
+
+	struct _tHardwareStatus
+	{
+		int ID;
+		std::string Name;
+		bool bStarted;
+		time_t LastHeartbeat;
+		time_t LastReceive;
+	};
+
+	CMetrics();
+	~CMetrics() = default;
+
+	void AddSQLQuery(uint64_t usec);
+	void AddScriptRun(_eScriptEngine engine, uint64_t usec);
+
+	std::string GetMetrics(bool bGZip);
+
+private:
+	enum _eMetricValue
+	{
+		MVALUE_TEMPERATURE = 0,
+		MVALUE_HUMIDITY,
+		MVALUE_BAROMETER,
+		MVALUE_POWER,
+		MVALUE_ENERGY,
+		MVALUE_VOLTAGE,
+		MVALUE_CURRENT,
+		MVALUE_ILLUMINANCE,
+		MVALUE_PERCENTAGE,
+		MVALUE_SETPOINT,
+		MVALUE_SWITCH,
+		MVALUE_END
+	};
+
+	struct _tMetricsDevice
+	{
+		int BatteryLevel = 255;
+		int SignalLevel = 12;
+		uint32_t ValidMask = 0;
+		double Values[MVALUE_END];
+	};
+
+	struct _tMetricsValueDesc
+	{
+		const char *szName;
+		const char *szHelp;
+		const char *szType;
+	};
+	static const _tMetricsValueDesc ValueDesc[MVALUE_END];
+
+	static void ParseValues(_tMetricsDevice &device, uint8_t devType, uint8_t subType, int nValue, const std::string &sValue);
+	std::string Render();
+
+	std::atomic<uint64_t> m_sqlQueries;
+	std::atomic<uint64_t> m_sqlMicroseconds;
+	std::atomic<uint64_t> m_scriptRuns[SCRIPT_END];
+	std::atomic<uint64_t> m_scriptMicroseconds[SCRIPT_END];
+
+	std::mutex m_cacheMutex;
+	time_t m_cacheTime;
+	std::string m_cache;
+	std::string m_cacheGZip;
+};
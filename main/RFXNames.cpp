@@ -5,6 +5,7 @@
 #include "../hardware/hardwaretypes.h"
 #include "Helper.h"
 #include "Logger.h"
+#include <array>
 
 typedef struct _STR_TABLE_SINGLE {
 	unsigned long    id;
@@ -48,6 +49,95 @@ const char* findTableID1ID2(const _STR_TABLE_ID1_ID2* t, const unsigned long id1
 	return "Unknown";
 }
 
+//Compile time checks, the linear scans returned the first match so a duplicate id would never be found
+template <size_t N> constexpr bool HasDuplicateIDs(const STR_TABLE_SINGLE (&t)[N])
+{
+	for (size_t ii = 0; ii + 1 < N; ii++)
+		for (size_t jj = ii + 1; jj + 1 < N; jj++)
+			if (t[ii].id == t[jj].id)
+				return true;
+	return false;
+}
+
+template <size_t N> constexpr bool HasDuplicateIDs(const STR_TABLE_ID1_ID2 (&t)[N])
+{
+	for (size_t ii = 0; ii + 1 < N; ii++)
+		for (size_t jj = ii + 1; jj + 1 < N; jj++)
+			if ((t[ii].id1 == t[jj].id1) && (t[ii].id2 == t[jj].id2))
+				return true;
+	return false;
+}
+
+//Dense index for the tables that are used per device, ids above 255 use the linear scan
+class CSingleTableIndex
+{
+public:
+	explicit CSingleTableIndex(const STR_TABLE_SINGLE *t)
+		: m_table(t)
+	{
+		m_str1.fill(nullptr);
+		m_str2.fill(nullptr);
+		for (const STR_TABLE_SINGLE *pEntry = t; pEntry->str1; pEntry++)
+			if (pEntry->id < m_str1.size())
+				m_str1[pEntry->id] = pEntry->str1;
+		for (const STR_TABLE_SINGLE *pEntry = t; pEntry->str2; pEntry++)
+			if (pEntry->id < m_str2.size())
+				m_str2[pEntry->id] = pEntry->str2;
+	}
+	const char *Str1(const unsigned long id) const
+	{
+		if (id >= m_str1.size())
+			return findTableIDSingle1(m_table, id);
+		return (m_str1[id]) ? m_str1[id] : "Unknown";
+	}
+	const char *Str2(const unsigned long id) const
+	{
+		if (id >= m_str2.size())
+			return findTableIDSingle2(m_table, id);
+		return (m_str2[id]) ? m_str2[id] : "Unknown";
+	}
+private:
+	const STR_TABLE_SINGLE *m_table;
+	std::array<const char *, 256> m_str1;
+	std::array<const char *, 256> m_str2;
+};
+
+//Dense index on (id1, id2), with one page of 256 entries for each id1 that is used
+class CPairTableIndex
+{
+public:
+	explicit CPairTableIndex(const STR_TABLE_ID1_ID2 *t)
+		: m_table(t)
+	{
+		m_page.fill(0);
+		m_pages.resize(1); //page 0 is empty and used for unknown types
+		m_pages[0].fill(nullptr);
+		for (const STR_TABLE_ID1_ID2 *pEntry = t; pEntry->str1; pEntry++)
+		{
+			if ((pEntry->id1 >= m_page.size()) || (pEntry->id2 >= 256))
+				continue;
+			if (m_page[pEntry->id1] == 0)
+			{
+				m_page[pEntry->id1] = (uint16_t)m_pages.size();
+				m_pages.emplace_back();
+				m_pages.back().fill(nullptr);
+			}
+			m_pages[m_page[pEntry->id1]][pEntry->id2] = pEntry->str1;
+		}
+	}
+	const char *Str1(const unsigned long id1, const unsigned long id2) const
+	{
+		if ((id1 >= m_page.size()) || (id2 >= 256))
+			return findTableID1ID2(m_table, id1, id2);
+		const char *szDesc = m_pages[m_page[id1]][id2];
+		return (szDesc) ? szDesc : "Unknown";
+	}
+private:
+	const STR_TABLE_ID1_ID2 *m_table;
+	std::array<uint16_t, 256> m_page;
+	std::vector<std::array<const char *, 256>> m_pages;
+};
+
 const char* RFX_Humidity_Status_Desc(const unsigned char status)
 {
 	static const STR_TABLE_SINGLE Table[] = {
@@ -150,7 +240,7 @@ const char* Timer_Cmd_Desc(const int tType)
 }
 
 //ID, Long description, short description
-static const STR_TABLE_SINGLE HardwareTypeTable[] = {
+static constexpr STR_TABLE_SINGLE HardwareTypeTable[] = {
 	{ HTYPE_RFXtrx315, "RFXCOM - RFXtrx315 USB 315MHz Transceiver", "RFXCOM" },
 	{ HTYPE_RFXtrx433, "RFXCOM - RFXtrx433 USB 433.92MHz Transceiver", "RFXCOM" },
 	{ HTYPE_RFXLAN, "RFXCOM - RFXtrx shared over LAN interface", "RFXCOM" },
@@ -279,19 +369,27 @@ static const STR_TABLE_SINGLE HardwareTypeTable[] = {
 	{ 0, nullptr, nullptr },
 };
 
+static_assert(!HasDuplicateIDs(HardwareTypeTable), "duplicate hardware type");
+
+static const CSingleTableIndex &HardwareTypeIndex()
+{
+	static const CSingleTableIndex Index(HardwareTypeTable);
+	return Index;
+}
+
 const char* Hardware_Type_Desc(int hType)
 {
-	return findTableIDSingle1(HardwareTypeTable, hType);
+	return HardwareTypeIndex().Str1(hType);
 }
 
 const char* Hardware_Short_Desc(int hType)
 {
-	return findTableIDSingle2(HardwareTypeTable, hType);
+	return HardwareTypeIndex().Str2(hType);
 }
 
 const char* Switch_Type_Desc(const _eSwitchType sType)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ STYPE_OnOff, "On/Off" },
 		{ STYPE_Doorbell, "Doorbell" },
 		{ STYPE_Contact, "Contact" },
@@ -315,12 +413,14 @@ const char* Switch_Type_Desc(const _eSwitchType sType)
 		{ STYPE_DoorLockInverted, "Door Lock Inverted" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, sType);
+	static_assert(!HasDuplicateIDs(Table), "duplicate switch type");
+	static const CSingleTableIndex Index(Table);
+	return Index.Str1(sType);
 }
 
 const char* Meter_Type_Desc(const _eMeterType sType)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ MTYPE_ENERGY, "Energy" },
 		{ MTYPE_GAS, "Gas" },
 		{ MTYPE_WATER, "Water" },
@@ -329,7 +429,9 @@ const char* Meter_Type_Desc(const _eMeterType sType)
 		{ MTYPE_TIME, "Time" },
 		{ 0, nullptr, nullptr },
 	};
-	return findTableIDSingle1(Table, sType);
+	static_assert(!HasDuplicateIDs(Table), "duplicate meter type");
+	static const CSingleTableIndex Index(Table);
+	return Index.Str1(sType);
 }
 
 const char* Notification_Type_Desc(const int nType, const unsigned char snum)
@@ -450,7 +552,7 @@ const char* BMP_Forecast_Desc(const unsigned char Forecast)
 
 const char* RFX_Type_Desc(const unsigned char i, const unsigned char snum)
 {
-	static const STR_TABLE_SINGLE Table[] = {
+	static constexpr STR_TABLE_SINGLE Table[] = {
 		{ pTypeInterfaceControl, "Interface Control", "unknown" },
 		{ pTypeInterfaceMessage, "Interface Message", "unknown" },
 		{ pTypeRecXmitMessage, "Receiver/Transmitter Message", "unknown" },
@@ -543,15 +645,17 @@ const char* RFX_Type_Desc(const unsigned char i, const unsigned char snum)
 		{ pTypeHunter, "Hunter", "Hunter" },
 		{ 0, nullptr, nullptr },
 	};
+	static_assert(!HasDuplicateIDs(Table), "duplicate device type");
+	static const CSingleTableIndex Index(Table);
 	if (snum == 1)
-		return findTableIDSingle1(Table, i);
+		return Index.Str1(i);
 
-	return findTableIDSingle2(Table, i);
+	return Index.Str2(i);
 }
 
 const char* RFX_Type_SubType_Desc(const unsigned char dType, const unsigned char sType)
 {
-	static const STR_TABLE_ID1_ID2 Table[] = {
+	static constexpr STR_TABLE_ID1_ID2 Table[] = {
 		{ pTypeTEMP, sTypeTEMP1, "THR128/138, THC138" },
 		{ pTypeTEMP, sTypeTEMP2, "THC238/268, THN132, THWR288, THRN122, THN122, AW129/131" },
 		{ pTypeTEMP, sTypeTEMP3, "THWR800" },
@@ -845,11 +949,6 @@ const char* RFX_Type_SubType_Desc(const unsigned char dType, const unsigned char
 		{ pTypeFS20, sTypeFHT8V, "FHT 8V valve" },
 		{ pTypeFS20, sTypeFHT80, "FHT80 door/window sensor" },
 
-		{ pTypeWEATHER, sTypeWEATHER1, "Alecto ACH2010" },
-		{ pTypeWEATHER, sTypeWEATHER2, "Alecto WS5500" },
-
-		{ pTypeSOLAR, sTypeSOLAR1, "Davis" },
-
 		{ pTypeGeneralSwitch, sSwitchTypeX10, "X10" },
 		{ pTypeGeneralSwitch, sSwitchTypeARC, "ARC" },
 		{ pTypeGeneralSwitch, sSwitchTypeAB400D, "ELRO AB400" },
@@ -967,7 +1066,9 @@ const char* RFX_Type_SubType_Desc(const unsigned char dType, const unsigned char
 		{ pTypeGeneralSwitch, sSwitchTypeV2Phoenix, "V2Phoenix" },
 		{ 0, 0, nullptr },
 	};
-	return findTableID1ID2(Table, dType, sType);
+	static_assert(!HasDuplicateIDs(Table), "duplicate device type/subtype");
+	static const CPairTableIndex Index(Table);
+	return Index.Str1(dType, sType);
 }
 
 const char* Media_Player_States(const _eMediaStatus Status)
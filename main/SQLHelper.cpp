@@ -38,7 +38,9 @@
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
 
-#define DB_VERSION 148
+#define DB_VERSION 149
+
+#define SHORTLOG_CLEANUP_BATCH_SIZE 5000
 
 extern http::server::CWebServerHelper m_webservers;
 extern std::string szWWWFolder;
@@ -106,7 +108,8 @@ constexpr auto sqlCreateRain =
 "[DeviceRowID] BIGINT(10) NOT NULL, "
 "[Total] FLOAT NOT NULL, "
 "[Rate] INTEGER DEFAULT 0, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreateRain_Calendar =
 "CREATE TABLE IF NOT EXISTS [Rain_Calendar] ("
@@ -124,7 +127,8 @@ constexpr auto sqlCreateTemperature =
 "[Barometer] INTEGER DEFAULT 0, "
 "[DewPoint] FLOAT DEFAULT 0, "
 "[SetPoint] FLOAT DEFAULT 0, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreateTemperature_Calendar =
 "CREATE TABLE IF NOT EXISTS [Temperature_Calendar] ("
@@ -164,7 +168,8 @@ constexpr auto sqlCreateUV =
 "CREATE TABLE IF NOT EXISTS [UV] ("
 "[DeviceRowID] BIGINT(10) NOT NULL, "
 "[Level] FLOAT NOT NULL, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreateUV_Calendar =
 "CREATE TABLE IF NOT EXISTS [UV_Calendar] ("
@@ -178,7 +183,8 @@ constexpr auto sqlCreateWind =
 "[Direction] FLOAT NOT NULL, "
 "[Speed] INTEGER NOT NULL, "
 "[Gust] INTEGER NOT NULL, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreateWind_Calendar =
 "CREATE TABLE IF NOT EXISTS [Wind_Calendar] ("
@@ -199,7 +205,8 @@ constexpr auto sqlCreateMultiMeter =
 "[Value4] BIGINT DEFAULT 0, "
 "[Value5] BIGINT DEFAULT 0, "
 "[Value6] BIGINT DEFAULT 0, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreateMultiMeter_Calendar =
 "CREATE TABLE IF NOT EXISTS [MultiMeter_Calendar] ("
@@ -264,7 +271,8 @@ constexpr auto sqlCreateMeter =
 "[DeviceRowID] BIGINT NOT NULL, "
 "[Value] BIGINT NOT NULL, "
 "[Usage] INTEGER DEFAULT 0, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreateMeter_Calendar =
 "CREATE TABLE IF NOT EXISTS [Meter_Calendar] ("
@@ -453,7 +461,8 @@ constexpr auto sqlCreatePercentage =
 "CREATE TABLE IF NOT EXISTS [Percentage] ("
 "[DeviceRowID] BIGINT(10) NOT NULL, "
 "[Percentage] FLOAT NOT NULL, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreatePercentage_Calendar =
 "CREATE TABLE IF NOT EXISTS [Percentage_Calendar] ("
@@ -467,7 +476,8 @@ constexpr auto sqlCreateFan =
 "CREATE TABLE IF NOT EXISTS [Fan] ("
 "[DeviceRowID] BIGINT(10) NOT NULL, "
 "[Speed] INTEGER NOT NULL, "
-"[Date] DATETIME DEFAULT (datetime('now','localtime')));";
+"[Date] DATETIME DEFAULT (datetime('now','localtime')), "
+"[ts] INTEGER DEFAULT (strftime('%s','now')));";
 
 constexpr auto sqlCreateFan_Calendar =
 "CREATE TABLE IF NOT EXISTS [Fan_Calendar] ("
@@ -588,6 +598,21 @@ constexpr auto sqlCreateMobileDevices =
 "[LastUpdate] DATETIME DEFAULT(datetime('now', 'localtime'))"
 ");";
 
+constexpr auto sqlCreateDzVentsData =
+"CREATE TABLE IF NOT EXISTS [DzVentsData]("
+" [Module] VARCHAR(200) NOT NULL,"
+" [Name] VARCHAR(200) NOT NULL,"
+" [Value] TEXT NOT NULL,"
+" PRIMARY KEY([Module], [Name]));";
+
+constexpr auto sqlCreateDzVentsHistory =
+"CREATE TABLE IF NOT EXISTS [DzVentsHistory]("
+" [Module] VARCHAR(200) NOT NULL,"
+" [Name] VARCHAR(200) NOT NULL,"
+" [Seq] BIGINT NOT NULL,"
+" [Value] TEXT NOT NULL,"
+" PRIMARY KEY([Module], [Name], [Seq]));";
+
 extern std::string szUserDataFolder;
 
 CSQLHelper::CSQLHelper()
@@ -713,6 +738,8 @@ bool CSQLHelper::OpenDatabase()
 	query(sqlCreateToonDevices);
 	query(sqlCreateUserSessions);
 	query(sqlCreateMobileDevices);
+	query(sqlCreateDzVentsData);
+	query(sqlCreateDzVentsHistory);
 	//Add indexes to log tables
 	query("create index if not exists ds_hduts_idx	on DeviceStatus(HardwareID, DeviceID, Unit, Type, SubType);");
 	query("create index if not exists f_id_idx		on Fan(DeviceRowID);");
@@ -2773,6 +2800,55 @@ bool CSQLHelper::OpenDatabase()
 		{
 			query("ALTER TABLE Hardware ADD COLUMN [LogLevel] INTEGER DEFAULT 7"); // LOG_NORM + LOG_STATUS + LOG_ERROR
 		}
+		if (dbversion < 149)
+		{
+			//Short log tables get an UTC epoch timestamp next to the local Date string
+			struct _tShortLogTable
+			{
+				const char *szTable;
+				const char *szPrefix;
+				const char *szCreate;
+				const char *szColumns;
+			};
+			static const _tShortLogTable ShortLogTables[] = {
+				{ "Temperature", "t", sqlCreateTemperature, "DeviceRowID, Temperature, Chill, Humidity, Barometer, DewPoint, SetPoint, Date" },
+				{ "Rain", "r", sqlCreateRain, "DeviceRowID, Total, Rate, Date" },
+				{ "Wind", "w", sqlCreateWind, "DeviceRowID, Direction, Speed, Gust, Date" },
+				{ "UV", "u", sqlCreateUV, "DeviceRowID, Level, Date" },
+				{ "Meter", "m", sqlCreateMeter, "DeviceRowID, Value, [Usage], Date" },
+				{ "MultiMeter", "mm", sqlCreateMultiMeter, "DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6, Date" },
+				{ "Percentage", "p", sqlCreatePercentage, "DeviceRowID, Percentage, Date" },
+				{ "Fan", "f", sqlCreateFan, "DeviceRowID, Speed, Date" },
+			};
+			for (const auto &table : ShortLogTables)
+			{
+				_log.Log(LOG_STATUS, "Adding timestamps to %s log...", table.szTable);
+				//The old table is only dropped once its rows are copied, any failure rolls the table back
+				const std::string szSteps[] = {
+					"BEGIN TRANSACTION",
+					std_format("ALTER TABLE %s RENAME TO %s_old", table.szTable, table.szTable),
+					table.szCreate,
+					std_format("INSERT INTO %s (%s, ts) SELECT %s, strftime('%%s', Date, 'utc') FROM %s_old", table.szTable, table.szColumns, table.szColumns, table.szTable),
+					std_format("DROP TABLE %s_old", table.szTable),
+					std_format("CREATE INDEX IF NOT EXISTS %s_id_idx ON %s(DeviceRowID)", table.szPrefix, table.szTable),
+					std_format("CREATE INDEX IF NOT EXISTS %s_id_date_idx ON %s(DeviceRowID, Date)", table.szPrefix, table.szTable),
+					"COMMIT TRANSACTION",
+				};
+				for (const auto &szStep : szSteps)
+				{
+					char *errorMessage = nullptr;
+					if (sqlite3_exec(m_dbase, szStep.c_str(), nullptr, nullptr, &errorMessage) != SQLITE_OK)
+					{
+						_log.Log(LOG_ERROR, "Database upgrade of %s log failed: %s (%s)", table.szTable, (errorMessage != nullptr) ? errorMessage : sqlite3_errmsg(m_dbase), szStep.c_str());
+						sqlite3_free(errorMessage);
+						sqlite3_exec(m_dbase, "ROLLBACK TRANSACTION", nullptr, nullptr, nullptr);
+						sqlite3_close(m_dbase);
+						m_dbase = nullptr;
+						return false;
+					}
+				}
+			}
+		}
 	}
 	else if (bNewInstall)
 	{
@@ -2781,6 +2857,15 @@ bool CSQLHelper::OpenDatabase()
 		// Add hardware for internal use
 		m_sql.safe_query("INSERT INTO Hardware (Name, Enabled, Type, Address, Port, Username, Password, Mode1, Mode2, Mode3, Mode4, Mode5, Mode6) VALUES ('Domoticz Internal',1, %d,'',1,'','',0,0,0,0,0,0)", HTYPE_DomoticzInternal);
 	}
+	//Range scans and cleanup of the short logs use the epoch timestamp (added in DB version 149)
+	query("create index if not exists f_id_ts_idx	on Fan(DeviceRowID, ts);");
+	query("create index if not exists m_id_ts_idx	on Meter(DeviceRowID, ts);");
+	query("create index if not exists mm_id_ts_idx	on MultiMeter(DeviceRowID, ts);");
+	query("create index if not exists p_id_ts_idx	on Percentage(DeviceRowID, ts);");
+	query("create index if not exists r_id_ts_idx	on Rain(DeviceRowID, ts);");
+	query("create index if not exists t_id_ts_idx	on Temperature(DeviceRowID, ts);");
+	query("create index if not exists u_id_ts_idx	on UV(DeviceRowID, ts);");
+	query("create index if not exists w_id_ts_idx	on Wind(DeviceRowID, ts);");
 	UpdatePreferencesVar("DB_Version", DB_VERSION);
 
 	//Check preferences table for extreme sized sValues
@@ -3058,6 +3143,10 @@ bool CSQLHelper::OpenDatabase()
 	{
 		UpdatePreferencesVar("UVCParams", "-S80 -B128 -C128 -G80 -x800 -y600 -q100"); //fix a bug
 	}
+	if (!GetPreferencesVar("CameraSnapshotMaxAge", nValue))
+	{
+		UpdatePreferencesVar("CameraSnapshotMaxAge", 2); //seconds a cached camera frame is reused
+	}
 
 	nValue = 1;
 	if (!GetPreferencesVar("AcceptNewHardware", nValue))
@@ -3257,6 +3346,8 @@ bool CSQLHelper::OpenDatabase()
 		nValue = 6000;
 	m_max_kwh_usage = nValue;
 
+	OpenReaderPool();
+
 	//Start background thread
 	if (!StartThread())
 		return false;
@@ -3265,6 +3356,7 @@ bool CSQLHelper::OpenDatabase()
 
 void CSQLHelper::CloseDatabase()
 {
+	CloseReaderPool();
 	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
 	if (m_dbase != nullptr)
 	{
@@ -4021,11 +4113,110 @@ std::vector<std::vector<std::string> > CSQLHelper::query(const std::string& szQu
 		return results;
 	}
 	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	return query(m_dbase, szQuery);
+}
+
+std::vector<std::vector<std::string> > CSQLHelper::safe_query_read(const char* fmt, ...)
+{
+	va_list args;
+	va_start(args, fmt);
+	char* zQuery = sqlite3_vmprintf(fmt, args);
+	va_end(args);
+	if (!zQuery)
+	{
+		_log.Log(LOG_ERROR, "SQL: Out of memory, or invalid printf!....");
+		std::vector<std::vector<std::string> > results;
+		return results;
+	}
+	std::vector<std::vector<std::string> > results = query_read(zQuery);
+	sqlite3_free(zQuery);
+	return results;
+}
+
+//Read only query, runs on a pooled WAL reader connection when available
+std::vector<std::vector<std::string> > CSQLHelper::query_read(const std::string& szQuery)
+{
+	sqlite3* pReader = AcquireReader();
+	if (pReader == nullptr)
+		return query(szQuery);
+	std::vector<std::vector<std::string> > results = query(pReader, szQuery);
+	ReleaseReader(pReader);
+	return results;
+}
+
+void CSQLHelper::OpenReaderPool()
+{
+	if (m_journal_mode != "WAL")
+		return; //readers would block the writer
+
+	int nReaders = std::min<int>(std::max<int>(std::thread::hardware_concurrency(), 1), 4);
+	if (!GetPreferencesVar("DatabaseReaders", nReaders))
+		UpdatePreferencesVar("DatabaseReaders", nReaders);
+	if (nReaders > 16)
+		nReaders = 16;
+
+	std::unique_lock<std::mutex> l(m_readerMutex);
+	for (int ii = 0; ii < nReaders; ii++)
+	{
+		sqlite3* pReader = nullptr;
+		if (sqlite3_open_v2(m_dbase_name.c_str(), &pReader, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK)
+		{
+			_log.Log(LOG_ERROR, "SQLHelper: Unable to open database reader: %s", sqlite3_errmsg(pReader));
+			sqlite3_close(pReader);
+			break;
+		}
+		sqlite3_exec(pReader, "PRAGMA busy_timeout = 1000", nullptr, nullptr, nullptr);
+		m_readers.push_back(pReader);
+		m_idleReaders.push_back(pReader);
+	}
+	if (!m_readers.empty())
+		_log.Log(LOG_STATUS, "SQLHelper: Using %d database reader connection(s)", (int)m_readers.size());
+	l.unlock();
+	m_readerCondition.notify_all();
+}
+
+void CSQLHelper::CloseReaderPool()
+{
+	std::unique_lock<std::mutex> l(m_readerMutex);
+	//Empty the pool first so new queries fall back to the writer, then wait for the busy readers to come back
+	std::vector<sqlite3*> readers;
+	readers.swap(m_readers);
+	m_readerCondition.notify_all();
+	m_readerCondition.wait(l, [&readers, this] { return m_idleReaders.size() == readers.size(); });
+	for (auto pReader : readers)
+		sqlite3_close(pReader);
+	m_idleReaders.clear();
+	l.unlock();
+	m_readerCondition.notify_all();
+}
+
+sqlite3* CSQLHelper::AcquireReader()
+{
+	std::unique_lock<std::mutex> l(m_readerMutex);
+	m_readerCondition.wait(l, [this] { return m_readers.empty() || !m_idleReaders.empty(); });
+	if (m_readers.empty())
+		return nullptr;
+	sqlite3* pReader = m_idleReaders.back();
+	m_idleReaders.pop_back();
+	return pReader;
+}
+
+void CSQLHelper::ReleaseReader(sqlite3* pReader)
+{
+	{
+		std::lock_guard<std::mutex> l(m_readerMutex);
+		m_idleReaders.push_back(pReader);
+	}
+	m_readerCondition.notify_all();
+}
 
+std::vector<std::vector<std::string> > CSQLHelper::query(sqlite3* dbase, const std::string& szQuery)
+{
 	sqlite3_stmt* statement;
 	std::vector<std::vector<std::string> > results;
     _log.Debug(DEBUG_SQL, "Query:%s", szQuery.c_str());
-	if (sqlite3_prepare_v2(m_dbase, szQuery.c_str(), -1, &statement, nullptr) == SQLITE_OK)
+	auto tstart = std::chrono::steady_clock::now();
+	if (sqlite3_prepare_v2(dbase, szQuery.c_str(), -1, &statement, nullptr) == SQLITE_OK)
 	{
 		int cols = sqlite3_column_count(statement);
 		while (true)
@@ -4054,8 +4245,9 @@ std::vector<std::vector<std::string> > CSQLHelper::query(const std::string& szQu
 		}
 		sqlite3_finalize(statement);
 	}
+	m_mainworker.m_metrics.AddSQLQuery(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tstart).count());
 
-	std::string error = sqlite3_errmsg(m_dbase);
+	std::string error = sqlite3_errmsg(dbase);
 	if (error != "not an error")
 		_log.Log(LOG_ERROR, "SQL Query(\"%s\") : %s", szQuery.c_str(), error.c_str());
 	return results;
@@ -4398,6 +4590,7 @@ uint64_t CSQLHelper::CreateDevice(const int HardwareID, const int SensorType, co
 	if (DeviceRowIdx != (uint64_t)-1)
 	{
 		m_sql.safe_query("UPDATE DeviceStatus SET Used=1 WHERE (ID==%" PRIu64 ")", DeviceRowIdx);
+		m_mainworker.m_devicestore.Refresh(DeviceRowIdx);
 		m_mainworker.m_eventsystem.GetCurrentStates();
 	}
 
@@ -4453,6 +4646,7 @@ uint64_t CSQLHelper::UpdateValue(const int HardwareID, const char* ID, const uns
 				ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec,
 				sd[0].c_str()
 			);
+			m_mainworker.m_devicestore.Refresh(std::stoull(sd[0]));
 
 			//Call the EventSystem for the main switch
 			uint64_t ParentID = (uint64_t)atoll(sd[0].c_str());
@@ -4547,6 +4741,7 @@ uint64_t CSQLHelper::UpdateValue(const int HardwareID, const char* ID, const uns
 						ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec,
 						sd[0].c_str()
 					);
+					m_mainworker.m_devicestore.Refresh(std::stoull(sd[0]));
 					m_mainworker.sOnDeviceUpdate(std::stoi(sd[2]), std::stoll(sd[0]));
 				}
 			}
@@ -4636,6 +4831,7 @@ uint64_t CSQLHelper::UpdateValue(const int HardwareID, const char* ID, const uns
 				ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec,
 				sd[0].c_str()
 			);
+			m_mainworker.m_devicestore.Refresh(std::stoull(sd[0]));
 			m_mainworker.sOnDeviceUpdate(std::stoi(sd[2]), std::stoll(sd[0]));
 		}
 		// TODO: Should plugin be notified?
@@ -4681,6 +4877,7 @@ uint64_t CSQLHelper::InsertDevice(const int HardwareID, const char* ID, const un
 		return -1;
 	}
 	ulID = std::stoull(result[0][0]);
+	m_mainworker.m_devicestore.Refresh(ulID);
 
 	return ulID;
 }
@@ -4886,6 +5083,22 @@ uint64_t CSQLHelper::UpdateValueInt(const int HardwareID, const char* ID, const
 		}
 	}
 
+	//keep the in-memory device state in line with the row just written
+	if (devType == pTypeGeneral && subType == sTypeCounterIncremental)
+		m_mainworker.m_devicestore.Refresh(ulID);
+	else
+	{
+		std::string sLastUpdate = TimeToString(nullptr, TF_DateTime);
+		m_mainworker.m_devicestore.Modify(ulID, [&](CDeviceStateStore::_tDeviceState &state) {
+			state.Name = devname;
+			state.SignalLevel = signallevel;
+			state.BatteryLevel = batterylevel;
+			state.nValue = nValue;
+			state.sValue = sValue;
+			state.LastUpdate = sLastUpdate;
+		});
+	}
+
 	if (bSameDeviceStatusValue)
 		return ulID; //status has not changed, no need to process further
 
@@ -4989,6 +5202,7 @@ uint64_t CSQLHelper::UpdateValueInt(const int HardwareID, const char* ID, const
 					"UPDATE DeviceStatus SET LastLevel='%d' WHERE (ID = %" PRIu64 ")",
 					llevel,
 					ulID);
+				m_mainworker.m_devicestore.Modify(ulID, [llevel](CDeviceStateStore::_tDeviceState &state) { state.LastLevel = llevel; });
 				if (bUseOnOffAction)
 					slevel = std::to_string(llevel);
 			}
@@ -5202,7 +5416,9 @@ uint64_t CSQLHelper::UpdateValueInt(const int HardwareID, const char* ID, const
 	_log.Debug(DEBUG_NORM, "SQLH UpdateValueInt %s HwID:%d  DevID:%s Type:%d  sType:%d nValue:%d sValue:%s ", devname.c_str(), HardwareID, ID, devType, subType, nValue, sValue);
 
 	if (bDeviceUsed)
+	{
 		m_mainworker.m_eventsystem.ProcessDevice(HardwareID, ulID, unit, devType, subType, signallevel, batterylevel, nValue, sValue);
+	}
 	return ulID;
 }
 
@@ -5275,6 +5491,41 @@ void CSQLHelper::GetAddjustment2(const int HardwareID, const char* ID, const uns
 	}
 }
 
+uint64_t CSQLHelper::GetHistoryGeneration(const uint64_t DeviceRowID)
+{
+	//both counters only go up, so their sum changes whenever one of them does
+	std::lock_guard<std::mutex> l(m_historyMutex);
+	auto itt = m_deviceHistoryGeneration.find(DeviceRowID);
+	return m_historyGeneration + ((itt != m_deviceHistoryGeneration.end()) ? itt->second : 0);
+}
+
+void CSQLHelper::HistoryChanged()
+{
+	m_historyGeneration++;
+}
+
+void CSQLHelper::HistoryChanged(const uint64_t DeviceRowID)
+{
+	std::lock_guard<std::mutex> l(m_historyMutex);
+	m_deviceHistoryGeneration[DeviceRowID]++;
+}
+
+//Preferences used while building graph data (units and meter dividers/types)
+static bool IsGraphPreference(const std::string& Key)
+{
+	static const char* szKeys[] = {
+		"TempUnit", "WindUnit", "WeightUnit",
+		"MeterDividerEnergy", "MeterDividerGas", "MeterDividerWater",
+		"CM113DisplayType", "ElectricVoltage", "SmartMeterType"
+	};
+	for (const auto szKey : szKeys)
+	{
+		if (Key == szKey)
+			return true;
+	}
+	return false;
+}
+
 void CSQLHelper::UpdatePreferencesVar(const std::string& Key, const std::string& sValue)
 {
 	UpdatePreferencesVar(Key, 0, sValue);
@@ -5310,6 +5561,8 @@ void CSQLHelper::UpdatePreferencesVar(const std::string& Key, const int nValue,
 		result = safe_query("UPDATE Preferences SET Key='%q', nValue=%d, sValue='%q' WHERE (ROWID = '%q')",
 			Key.c_str(), nValue, sValue.c_str(), result[0][0].c_str());
 	}
+	if (IsGraphPreference(Key))
+		HistoryChanged();
 }
 
 bool CSQLHelper::GetPreferencesVar(const std::string& Key, std::string& sValue)
@@ -5488,14 +5741,46 @@ void CSQLHelper::ScheduleShortlog()
 		//Force WAL flush
 		sqlite3_wal_checkpoint(m_dbase, nullptr);
 
-		UpdateTemperatureLog();
-		UpdateRainLog();
-		UpdateWindLog();
-		UpdateUVLog();
-		UpdateMeter();
-		UpdateMultiMeter();
-		UpdatePercentageLog();
-		UpdateFanLog();
+		time_t now = mytime(nullptr);
+		if (now != 0)
+		{
+			int SensorTimeOut = 60;
+			GetPreferencesVar("SensorTimeout", SensorTimeOut);
+
+			//One pass over DeviceStatus, shared by all samplers
+			std::vector<_tShortLogDevice> devices;
+			GetShortLogDevices(devices);
+
+			TSqlQueryResult rowsTemperature, rowsRain, rowsWind, rowsUV, rowsMeter, rowsMultiMeter, rowsPercentage, rowsFan;
+			UpdateTemperatureLog(devices, now, SensorTimeOut, rowsTemperature);
+			UpdateRainLog(devices, now, SensorTimeOut, rowsRain);
+			UpdateWindLog(devices, now, SensorTimeOut, rowsWind);
+			UpdateUVLog(devices, now, SensorTimeOut, rowsUV);
+			UpdateMeter(devices, now, SensorTimeOut, rowsMeter);
+			UpdateMultiMeter(devices, now, SensorTimeOut, rowsMultiMeter);
+			UpdatePercentageLog(devices, now, SensorTimeOut, rowsPercentage);
+			UpdateFanLog(devices, now, SensorTimeOut, rowsFan);
+
+			std::lock_guard<std::mutex> t(m_transactionMutex);
+			std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+			sqlite3_exec(m_dbase, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+			InsertShortLogRows("Temperature", "DeviceRowID, Temperature, Chill, Humidity, Barometer, DewPoint, SetPoint", rowsTemperature);
+			InsertShortLogRows("Rain", "DeviceRowID, Total, Rate", rowsRain);
+			InsertShortLogRows("Wind", "DeviceRowID, Direction, Speed, Gust", rowsWind);
+			InsertShortLogRows("UV", "DeviceRowID, Level", rowsUV);
+			InsertShortLogRows("Meter", "DeviceRowID, Value, [Usage]", rowsMeter);
+			InsertShortLogRows("MultiMeter", "DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6", rowsMultiMeter);
+			InsertShortLogRows("Percentage", "DeviceRowID, Percentage", rowsPercentage);
+			InsertShortLogRows("Fan", "DeviceRowID, Speed", rowsFan);
+			sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, nullptr);
+
+			//only the devices that got a new sample invalidate their cached graphs
+			for (const auto *rows : { &rowsTemperature, &rowsRain, &rowsWind, &rowsUV, &rowsMeter, &rowsMultiMeter, &rowsPercentage, &rowsFan })
+			{
+				for (const auto &row : *rows)
+					HistoryChanged(std::strtoull(row[0].c_str(), nullptr, 10));
+			}
+		}
 		//Removing the line below could cause a very large database,
 		//and slow(large) data transfer (specially when working remote!!)
 		CleanupShortLog();
@@ -5531,6 +5816,7 @@ void CSQLHelper::ScheduleDay()
 		AddCalendarUpdatePercentage();
 		AddCalendarUpdateFan();
 		CleanupLightSceneLog();
+		HistoryChanged();
 	}
 	catch (boost::exception& e)
 	{
@@ -5544,359 +5830,321 @@ void CSQLHelper::ScheduleDay()
 	}
 }
 
-void CSQLHelper::UpdateTemperatureLog()
+void CSQLHelper::GetShortLogDevices(std::vector<_tShortLogDevice> &devices)
 {
+	static const int shortLogTypes[] = {
+		pTypeTEMP, pTypeHUM, pTypeTEMP_HUM, pTypeTEMP_HUM_BARO, pTypeTEMP_BARO, pTypeUV, pTypeWIND, pTypeThermostat1,
+		pTypeRFXSensor, pTypeRego6XXTemp, pTypeEvohomeZone, pTypeEvohomeWater, pTypeRadiator1, pTypeGeneral, pTypeThermostat,
+		pTypeRAIN, pTypeRFXMeter, pTypeP1Gas, pTypeYouLess, pTypeENERGY, pTypePOWER, pTypeAirQuality, pTypeUsage, pTypeLux,
+		pTypeWEIGHT, pTypeRego6XXValue, pTypeP1Power, pTypeCURRENT, pTypeCURRENTENERGY
+	};
+	std::string szTypes;
+	for (const int iType : shortLogTypes)
+	{
+		if (!szTypes.empty())
+			szTypes += ",";
+		szTypes += std::to_string(iType);
+	}
+
 	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
 	struct tm tm1;
 	localtime_r(&now, &tm1);
 
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+	auto result = safe_query("SELECT ID, Name, HardwareID, DeviceID, Unit, Type, SubType, nValue, sValue, LastUpdate, Options FROM DeviceStatus WHERE (Type IN (%s))", szTypes.c_str());
+	devices.reserve(result.size());
+	for (const auto &sd : result)
+	{
+		_tShortLogDevice device;
+		device.ID = std::stoull(sd[0]);
+		device.Name = sd[1];
+		device.HardwareID = atoi(sd[2].c_str());
+		device.DeviceID = sd[3];
+		device.Unit = (unsigned char)atoi(sd[4].c_str());
+		device.Type = (unsigned char)atoi(sd[5].c_str());
+		device.SubType = (unsigned char)atoi(sd[6].c_str());
+		device.nValue = atoi(sd[7].c_str());
+		device.sValue = sd[8];
+		StringSplit(device.sValue, ";", device.Values);
+		struct tm ntime;
+		ParseSQLdatetime(device.LastUpdate, ntime, sd[9], tm1.tm_isdst);
+		device.Options = sd[10];
+		devices.push_back(std::move(device));
+	}
+}
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR Type=%d OR (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d))",
-		pTypeTEMP,
-		pTypeHUM,
-		pTypeTEMP_HUM,
-		pTypeTEMP_HUM_BARO,
-		pTypeTEMP_BARO,
-		pTypeUV,
-		pTypeWIND,
-		pTypeThermostat1,
-		pTypeRFXSensor,
-		pTypeRego6XXTemp,
-		pTypeEvohomeZone,
-		pTypeEvohomeWater,
-		pTypeRadiator1,
-		pTypeGeneral, sTypeSystemTemp,
-		pTypeThermostat, sTypeThermSetpoint,
-		pTypeGeneral, sTypeBaro
-	);
-	if (!result.empty())
+//Caller holds m_sqlQueryMutex and the surrounding transaction
+void CSQLHelper::InsertShortLogRows(const char *szTable, const char *szColumns, const TSqlQueryResult &rows)
+{
+	if (rows.empty())
+		return;
+
+	std::string szQuery = std_format("INSERT INTO %s (%s) VALUES (", szTable, szColumns);
+	for (size_t ii = 0; ii < rows[0].size(); ii++)
+		szQuery += (ii == 0) ? "?" : ",?";
+	szQuery += ")";
+
+	sqlite3_stmt *stmt = nullptr;
+	if (sqlite3_prepare_v2(m_dbase, szQuery.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
 	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-			unsigned char dType = atoi(sd[1].c_str());
-			unsigned char dSubType = atoi(sd[2].c_str());
-			int nValue = atoi(sd[3].c_str());
-			std::string sValue = sd[4];
+		_log.Log(LOG_ERROR, "SQL: Unable to prepare short log insert for %s (%s)", szTable, sqlite3_errmsg(m_dbase));
+		return;
+	}
+	for (const auto &row : rows)
+	{
+		int iColumn = 1;
+		for (const auto &value : row)
+			sqlite3_bind_text(stmt, iColumn++, value.c_str(), (int)value.size(), SQLITE_TRANSIENT);
+		if (sqlite3_step(stmt) != SQLITE_DONE)
+			_log.Log(LOG_ERROR, "SQL: Short log insert into %s failed (%s)", szTable, sqlite3_errmsg(m_dbase));
+		sqlite3_reset(stmt);
+	}
+	sqlite3_finalize(stmt);
+}
 
-			if (dType != pTypeRadiator1)
-			{
-				//do not include sensors that have no reading within an hour (except for devices that do not provide feedback, like the smartware radiator)
-				std::string sLastUpdate = sd[5];
-				struct tm ntime;
-				time_t checktime;
-				ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+void CSQLHelper::UpdateTemperatureLog(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
+{
+	for (const auto &sd : devices)
+	{
+		unsigned char dType = sd.Type;
+		unsigned char dSubType = sd.SubType;
+
+		switch (dType)
+		{
+		case pTypeTEMP:
+		case pTypeHUM:
+		case pTypeTEMP_HUM:
+		case pTypeTEMP_HUM_BARO:
+		case pTypeTEMP_BARO:
+		case pTypeUV:
+		case pTypeWIND:
+		case pTypeThermostat1:
+		case pTypeRFXSensor:
+		case pTypeRego6XXTemp:
+		case pTypeEvohomeZone:
+		case pTypeEvohomeWater:
+		case pTypeRadiator1:
+			break;
+		case pTypeGeneral:
+			if ((dSubType != sTypeSystemTemp) && (dSubType != sTypeBaro))
+				continue;
+			break;
+		case pTypeThermostat:
+			if (dSubType != sTypeThermSetpoint)
+				continue;
+			break;
+		default:
+			continue;
+		}
 
-				if (difftime(now, checktime) >= SensorTimeOut * 60)
-					continue;
-			}
+		if (dType != pTypeRadiator1)
+		{
+			//do not include sensors that have no reading within an hour (except for devices that do not provide feedback, like the smartware radiator)
+			if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+				continue;
+		}
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
+		const std::vector<std::string> &splitresults = sd.Values;
+		if (splitresults.empty())
+			continue; //impossible
 
-			float temp = 0;
-			float chill = 0;
-			unsigned char humidity = 0;
-			int barometer = 0;
-			float dewpoint = 0;
-			float setpoint = 0;
+		float temp = 0;
+		float chill = 0;
+		unsigned char humidity = 0;
+		int barometer = 0;
+		float dewpoint = 0;
+		float setpoint = 0;
 
-			switch (dType)
+		switch (dType)
+		{
+		case pTypeRego6XXTemp:
+		case pTypeTEMP:
+		case pTypeThermostat:
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			break;
+		case pTypeThermostat1:
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			break;
+		case pTypeRadiator1:
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			break;
+		case pTypeEvohomeWater:
+			if (splitresults.size() >= 2)
 			{
-			case pTypeRego6XXTemp:
-			case pTypeTEMP:
-			case pTypeThermostat:
 				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeThermostat1:
+				if (splitresults[1] == "On")
+					setpoint = 60;
+				else if (splitresults[1] == "Off")
+					setpoint = 0;
+				else
+					setpoint = static_cast<float>(atof(splitresults[1].c_str()));
+			}
+			break;
+		case pTypeEvohomeZone:
+			if (splitresults.size() >= 2)
+			{
 				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeRadiator1:
+				setpoint = static_cast<float>(atof(splitresults[1].c_str()));
+			}
+			break;
+		case pTypeHUM:
+			humidity = sd.nValue;
+			break;
+		case pTypeTEMP_HUM:
+			if (splitresults.size() >= 2)
+			{
 				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeEvohomeWater:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					if (splitresults[1] == "On")
-						setpoint = 60;
-					else if (splitresults[1] == "Off")
-						setpoint = 0;
-					else
-						setpoint = static_cast<float>(atof(splitresults[1].c_str()));
-				}
-				break;
-			case pTypeEvohomeZone:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					setpoint = static_cast<float>(atof(splitresults[1].c_str()));
-				}
-				break;
-			case pTypeHUM:
-				humidity = nValue;
-				break;
-			case pTypeTEMP_HUM:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					humidity = atoi(splitresults[1].c_str());
-					dewpoint = (float)CalculateDewPoint(temp, humidity);
-				}
-				break;
-			case pTypeTEMP_HUM_BARO:
-				if (splitresults.size() == 5)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					humidity = atoi(splitresults[1].c_str());
-					if (dSubType == sTypeTHBFloat)
-						barometer = int(atof(splitresults[3].c_str()) * 10.0F);
-					else
-						barometer = atoi(splitresults[3].c_str());
-					dewpoint = (float)CalculateDewPoint(temp, humidity);
-				}
-				break;
-			case pTypeTEMP_BARO:
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-					barometer = int(atof(splitresults[1].c_str()) * 10.0F);
-				}
-				break;
-			case pTypeUV:
-				if (dSubType != sTypeUV3)
-					continue;
-				if (splitresults.size() >= 2)
-				{
-					temp = static_cast<float>(atof(splitresults[1].c_str()));
-				}
-				break;
-			case pTypeWIND:
-				if (dSubType == sTypeWINDNoTempNoChill)
-					continue;
-				if (splitresults.size() >= 6)
-				{
-					if (dSubType != sTypeWINDNoTemp)
-					{
-						temp = static_cast<float>(atof(splitresults[4].c_str()));
-					}
-					chill = static_cast<float>(atof(splitresults[5].c_str()));
-				}
-				break;
-			case pTypeRFXSensor:
-				if (dSubType != sTypeRFXSensorTemp)
-					continue;
+				humidity = atoi(splitresults[1].c_str());
+				dewpoint = (float)CalculateDewPoint(temp, humidity);
+			}
+			break;
+		case pTypeTEMP_HUM_BARO:
+			if (splitresults.size() == 5)
+			{
 				temp = static_cast<float>(atof(splitresults[0].c_str()));
-				break;
-			case pTypeGeneral:
-				if (dSubType == sTypeSystemTemp)
-				{
-					temp = static_cast<float>(atof(splitresults[0].c_str()));
-				}
-				else if (dSubType == sTypeBaro)
+				humidity = atoi(splitresults[1].c_str());
+				if (dSubType == sTypeTHBFloat)
+					barometer = int(atof(splitresults[3].c_str()) * 10.0F);
+				else
+					barometer = atoi(splitresults[3].c_str());
+				dewpoint = (float)CalculateDewPoint(temp, humidity);
+			}
+			break;
+		case pTypeTEMP_BARO:
+			if (splitresults.size() >= 2)
+			{
+				temp = static_cast<float>(atof(splitresults[0].c_str()));
+				barometer = int(atof(splitresults[1].c_str()) * 10.0F);
+			}
+			break;
+		case pTypeUV:
+			if (dSubType != sTypeUV3)
+				continue;
+			if (splitresults.size() >= 2)
+			{
+				temp = static_cast<float>(atof(splitresults[1].c_str()));
+			}
+			break;
+		case pTypeWIND:
+			if (dSubType == sTypeWINDNoTempNoChill)
+				continue;
+			if (splitresults.size() >= 6)
+			{
+				if (dSubType != sTypeWINDNoTemp)
 				{
-					if (splitresults.size() != 2)
-						continue;
-					barometer = int(atof(splitresults[0].c_str()) * 10.0F);
+					temp = static_cast<float>(atof(splitresults[4].c_str()));
 				}
-				break;
+				chill = static_cast<float>(atof(splitresults[5].c_str()));
 			}
-			//insert record
-			safe_query(
-				"INSERT INTO Temperature (DeviceRowID, Temperature, Chill, Humidity, Barometer, DewPoint, SetPoint) "
-				"VALUES ('%" PRIu64 "', '%.2f', '%.2f', '%d', '%d', '%.2f', '%.2f')",
-				ID,
-				temp,
-				chill,
-				humidity,
-				barometer,
-				dewpoint,
-				setpoint
-			);
+			break;
+		case pTypeRFXSensor:
+			if (dSubType != sTypeRFXSensorTemp)
+				continue;
+			temp = static_cast<float>(atof(splitresults[0].c_str()));
+			break;
+		case pTypeGeneral:
+			if (dSubType == sTypeSystemTemp)
+			{
+				temp = static_cast<float>(atof(splitresults[0].c_str()));
+			}
+			else if (dSubType == sTypeBaro)
+			{
+				if (splitresults.size() != 2)
+					continue;
+				barometer = int(atof(splitresults[0].c_str()) * 10.0F);
+			}
+			break;
 		}
+		rows.push_back({
+			std::to_string(sd.ID),
+			std_format("%.2f", temp),
+			std_format("%.2f", chill),
+			std::to_string(humidity),
+			std::to_string(barometer),
+			std_format("%.2f", dewpoint),
+			std_format("%.2f", setpoint)
+		});
 	}
 }
 
-void CSQLHelper::UpdateRainLog()
+void CSQLHelper::UpdateRainLog(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
+	for (const auto &sd : devices)
+	{
+		if (sd.Type != pTypeRAIN)
+			continue;
 
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
+		//do not include sensors that have no reading within an hour
+		if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+			continue;
 
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d)", pTypeRAIN);
-	if (!result.empty())
+		const std::vector<std::string> &splitresults = sd.Values;
+		if (splitresults.size() < 2)
+			continue; //impossible
+
+		int rate = atoi(splitresults[0].c_str());
+		float total = static_cast<float>(atof(splitresults[1].c_str()));
+
+		rows.push_back({ std::to_string(sd.ID), std_format("%.2f", total), std::to_string(rate) });
+	}
+}
+
+void CSQLHelper::UpdateWindLog(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
+{
+	for (const auto &sd : devices)
 	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
+		if (sd.Type != pTypeWIND)
+			continue;
 
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+		unsigned short DeviceID;
+		std::stringstream s_str2(sd.DeviceID);
+		s_str2 >> DeviceID;
 
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
+		//do not include sensors that have no reading within an hour
+		if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+			continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.size() < 2)
-				continue; //impossible
+		const std::vector<std::string> &splitresults = sd.Values;
+		if (splitresults.size() < 4)
+			continue; //impossible
 
-			int rate = atoi(splitresults[0].c_str());
-			float total = static_cast<float>(atof(splitresults[1].c_str()));
+		float direction = static_cast<float>(atof(splitresults[0].c_str()));
 
-			//insert record
-			safe_query(
-				"INSERT INTO Rain (DeviceRowID, Total, Rate) "
-				"VALUES ('%" PRIu64 "', '%.2f', '%d')",
-				ID,
-				total,
-				rate
-			);
+		int speed = atoi(splitresults[2].c_str());
+		int gust = atoi(splitresults[3].c_str());
+
+		auto ittWC = m_mainworker.m_wind_calculator.find(DeviceID);
+		if (ittWC != m_mainworker.m_wind_calculator.end())
+		{
+			int speed_max, gust_max, speed_min, gust_min;
+			ittWC->second.GetMMSpeedGust(speed_min, speed_max, gust_min, gust_max);
+			if (speed_max != -1)
+				speed = speed_max;
+			if (gust_max != -1)
+				gust = gust_max;
 		}
+
+		rows.push_back({ std::to_string(sd.ID), std_format("%.2f", direction), std::to_string(speed), std::to_string(gust) });
 	}
 }
 
-void CSQLHelper::UpdateWindLog()
+void CSQLHelper::UpdateUVLog(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,DeviceID, Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d)", pTypeWIND);
-	if (!result.empty())
+	for (const auto &sd : devices)
 	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-
-			unsigned short DeviceID;
-			std::stringstream s_str2(sd[1]);
-			s_str2 >> DeviceID;
-
-			//unsigned char dType=atoi(sd[2].c_str());
-			//unsigned char dSubType=atoi(sd[3].c_str());
-			//int nValue=atoi(sd[4].c_str());
-			std::string sValue = sd[5];
-
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[6];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
-
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
+		if ((sd.Type != pTypeUV) && !((sd.Type == pTypeGeneral) && (sd.SubType == sTypeUV)))
+			continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.size() < 4)
-				continue; //impossible
+		//do not include sensors that have no reading within an hour
+		if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+			continue;
 
-			float direction = static_cast<float>(atof(splitresults[0].c_str()));
+		const std::vector<std::string> &splitresults = sd.Values;
+		if (splitresults.empty())
+			continue; //impossible
 
-			int speed = atoi(splitresults[2].c_str());
-			int gust = atoi(splitresults[3].c_str());
+		float level = static_cast<float>(atof(splitresults[0].c_str()));
 
-			auto ittWC = m_mainworker.m_wind_calculator.find(DeviceID);
-			if (ittWC != m_mainworker.m_wind_calculator.end())
-			{
-				int speed_max, gust_max, speed_min, gust_min;
-				ittWC->second.GetMMSpeedGust(speed_min, speed_max, gust_min, gust_max);
-				if (speed_max != -1)
-					speed = speed_max;
-				if (gust_max != -1)
-					gust = gust_max;
-			}
-
-			//insert record
-			safe_query(
-				"INSERT INTO Wind (DeviceRowID, Direction, Speed, Gust) "
-				"VALUES ('%" PRIu64 "', '%.2f', '%d', '%d')",
-				ID,
-				direction,
-				speed,
-				gust
-			);
-		}
-	}
-}
-
-void CSQLHelper::UpdateUVLog()
-{
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d) OR (Type=%d AND SubType=%d)",
-		pTypeUV,
-		pTypeGeneral, sTypeUV
-	);
-	if (!result.empty())
-	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
-
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
-
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-
-			float level = static_cast<float>(atof(splitresults[0].c_str()));
-
-			//insert record
-			safe_query(
-				"INSERT INTO UV (DeviceRowID, Level) "
-				"VALUES ('%" PRIu64 "', '%g')",
-				ID,
-				level
-			);
-		}
+		rows.push_back({ std::to_string(sd.ID), std_format("%g", level) });
 	}
 }
 
@@ -5949,8 +6197,8 @@ bool CSQLHelper::UpdateCalendarMeter(
 			if (result.empty())
 			{
 				safe_query(
-					"INSERT INTO MultiMeter (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6, Date) "
-					"VALUES ('%" PRIu64 "', '%lld', '%lld', '%lld', '%lld', '%lld', '%lld', '%q')",
+					"INSERT INTO MultiMeter (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6, Date, ts) "
+					"VALUES ('%" PRIu64 "', '%lld', '%lld', '%lld', '%lld', '%lld', '%lld', '%q', strftime('%%s', '%q', 'utc'))",
 					DeviceRowID,
 					(value1 < 0) ? 0 : value1,
 					(value2 < 0) ? 0 : value2,
@@ -5958,7 +6206,7 @@ bool CSQLHelper::UpdateCalendarMeter(
 					(value4 < 0) ? 0 : value4,
 					(value5 < 0) ? 0 : value5,
 					(value6 < 0) ? 0 : value6,
-					date
+					date, date
 				);
 			}
 			else
@@ -5986,9 +6234,9 @@ bool CSQLHelper::UpdateCalendarMeter(
 			if (result.empty())
 			{
 				safe_query(
-					"INSERT INTO Meter (DeviceRowID, Value, Usage, Date) "
-					"VALUES ('%" PRIu64 "','%lld','%lld','%q')",
-					DeviceRowID, (value1 < 0) ? 0 : value1, (value2 < 0) ? 0 : value2, date
+					"INSERT INTO Meter (DeviceRowID, Value, Usage, Date, ts) "
+					"VALUES ('%" PRIu64 "','%lld','%lld','%q', strftime('%%s', '%q', 'utc'))",
+					DeviceRowID, (value1 < 0) ? 0 : value1, (value2 < 0) ? 0 : value2, date, date
 				);
 			}
 			else
@@ -6078,503 +6326,360 @@ bool CSQLHelper::UpdateCalendarMeter(
 			}
 		}
 	}
+	HistoryChanged(DeviceRowID);
 	return true;
 }
 
-void CSQLHelper::UpdateMeter()
+void CSQLHelper::UpdateMeter(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	std::vector<std::vector<std::string> > result2;
-
-	result = safe_query(
-		"SELECT ID,Name,HardwareID,DeviceID,Unit,Type,SubType,nValue,sValue,LastUpdate,Options FROM DeviceStatus WHERE ("
-		"Type=%d OR " //pTypeRFXMeter
-		"Type=%d OR " //pTypeP1Gas
-		"Type=%d OR " //pTypeYouLess
-		"Type=%d OR " //pTypeENERGY
-		"Type=%d OR " //pTypePOWER
-		"Type=%d OR " //pTypeAirQuality
-		"Type=%d OR " //pTypeUsage
-		"Type=%d OR " //pTypeLux
-		"Type=%d OR " //pTypeWEIGHT
-		"(Type=%d AND SubType=%d) OR " //pTypeRego6XXValue,sTypeRego6XXCounter
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeVisibility
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeSolarRadiation
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeSoilMoisture
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeLeafWetness
-		"(Type=%d AND SubType=%d) OR " //pTypeRFXSensor,sTypeRFXSensorAD
-		"(Type=%d AND SubType=%d) OR" //pTypeRFXSensor,sTypeRFXSensorVolt
-		"(Type=%d AND SubType=%d) OR"  //pTypeGeneral,sTypeVoltage
-		"(Type=%d AND SubType=%d) OR"  //pTypeGeneral,sTypeCurrent
-		"(Type=%d AND SubType=%d) OR"  //pTypeGeneral,sTypeSoundLevel
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeDistance
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypePressure
-		"(Type=%d AND SubType=%d) OR " //pTypeGeneral,sTypeCounterIncremental
-		"(Type=%d AND SubType=%d)"	 //pTypeGeneral,sTypeKwh
-		")",
-		pTypeRFXMeter,
-		pTypeP1Gas,
-		pTypeYouLess,
-		pTypeENERGY,
-		pTypePOWER,
-		pTypeAirQuality,
-		pTypeUsage,
-		pTypeLux,
-		pTypeWEIGHT,
-		pTypeRego6XXValue, sTypeRego6XXCounter,
-		pTypeGeneral, sTypeVisibility,
-		pTypeGeneral, sTypeSolarRadiation,
-		pTypeGeneral, sTypeSoilMoisture,
-		pTypeGeneral, sTypeLeafWetness,
-		pTypeRFXSensor, sTypeRFXSensorAD,
-		pTypeRFXSensor, sTypeRFXSensorVolt,
-		pTypeGeneral, sTypeVoltage,
-		pTypeGeneral, sTypeCurrent,
-		pTypeGeneral, sTypeSoundLevel,
-		pTypeGeneral, sTypeDistance,
-		pTypeGeneral, sTypePressure,
-		pTypeGeneral, sTypeCounterIncremental,
-		pTypeGeneral, sTypeKwh
-	);
-	if (!result.empty())
-	{
-		for (const auto &sd : result)
-		{
-			char szTmp[200];
-
-			std::string sOptions = sd[10];
-			std::map<std::string, std::string> options = BuildDeviceOptions(sOptions);
-			// We don't want to update meter if externally managed
-			if (options["DisableLogAutoUpdate"] == "true")
-			{
+	for (const auto &sd : devices)
+	{
+		unsigned char dType = sd.Type;
+		unsigned char dSubType = sd.SubType;
+
+		switch (dType)
+		{
+		case pTypeRFXMeter:
+		case pTypeP1Gas:
+		case pTypeYouLess:
+		case pTypeENERGY:
+		case pTypePOWER:
+		case pTypeAirQuality:
+		case pTypeUsage:
+		case pTypeLux:
+		case pTypeWEIGHT:
+			break;
+		case pTypeRego6XXValue:
+			if (dSubType != sTypeRego6XXCounter)
+				continue;
+			break;
+		case pTypeRFXSensor:
+			if ((dSubType != sTypeRFXSensorAD) && (dSubType != sTypeRFXSensorVolt))
+				continue;
+			break;
+		case pTypeGeneral:
+			switch (dSubType)
+			{
+			case sTypeVisibility:
+			case sTypeSolarRadiation:
+			case sTypeSoilMoisture:
+			case sTypeLeafWetness:
+			case sTypeVoltage:
+			case sTypeCurrent:
+			case sTypeSoundLevel:
+			case sTypeDistance:
+			case sTypePressure:
+			case sTypeCounterIncremental:
+			case sTypeKwh:
+				break;
+			default:
 				continue;
 			}
+			break;
+		default:
+			continue;
+		}
 
-			uint64_t ID = std::stoull(sd[0]);
-			std::string devname = sd[1];
-			int hardwareID = atoi(sd[2].c_str());
-			std::string DeviceID = sd[3];
-			unsigned char Unit = atoi(sd[4].c_str());
-
-			unsigned char dType = atoi(sd[5].c_str());
-			unsigned char dSubType = atoi(sd[6].c_str());
-			int nValue = atoi(sd[7].c_str());
-			std::string sValue = sd[8];
-			std::string sLastUpdate = sd[9];
-
-			std::string sUsage = "0";
+		char szTmp[200];
 
-			//do not include sensors that have no reading within an hour
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+		std::map<std::string, std::string> options = BuildDeviceOptions(sd.Options);
+		// We don't want to update meter if externally managed
+		if (options["DisableLogAutoUpdate"] == "true")
+		{
+			continue;
+		}
 
-			//Check for timeout, if timeout then dont add value
-			if (dType != pTypeP1Gas)
-			{
-				if (difftime(now, checktime) >= SensorTimeOut * 60)
-					continue;
-			}
-			else
-			{
-				//P1 Gas meter transmits results every 1 a 2 hours
-				if (difftime(now, checktime) >= 3 * 3600)
-					continue;
-			}
+		int nValue = sd.nValue;
+		std::string sValue = sd.sValue;
+		std::string sUsage = "0";
 
-			if (dType == pTypeYouLess)
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
-				sValue = splitresults[0];
-				sUsage = splitresults[1];
-			}
-			else if (dType == pTypeENERGY)
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
-				sUsage = splitresults[0];
-				double fValue = atof(splitresults[1].c_str()) * 100;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypePOWER)
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
-				sUsage = splitresults[0];
-				double fValue = atof(splitresults[1].c_str()) * 100;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeAirQuality)
-			{
-				sprintf(szTmp, "%d", nValue);
-				sValue = szTmp;
-				m_notifications.CheckAndHandleNotification(ID, hardwareID, DeviceID, devname, Unit, dType, dSubType, (int)nValue);
-			}
-			else if ((dType == pTypeGeneral) && ((dSubType == sTypeSoilMoisture) || (dSubType == sTypeLeafWetness)))
-			{
-				sprintf(szTmp, "%d", nValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeVisibility))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeDistance))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeSolarRadiation))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeSoundLevel))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeKwh))
-			{
-				std::vector<std::string> splitresults;
-				StringSplit(sValue, ";", splitresults);
-				if (splitresults.size() < 2)
-					continue;
+		//Check for timeout, if timeout then dont add value
+		if (dType != pTypeP1Gas)
+		{
+			if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+				continue;
+		}
+		else
+		{
+			//P1 Gas meter transmits results every 1 a 2 hours
+			if (difftime(now, sd.LastUpdate) >= 3 * 3600)
+				continue;
+		}
 
-				double fValue = atof(splitresults[0].c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sUsage = szTmp;
+		const std::vector<std::string> &splitresults = sd.Values;
+		if (dType == pTypeYouLess)
+		{
+			if (splitresults.size() < 2)
+				continue;
+			sValue = splitresults[0];
+			sUsage = splitresults[1];
+		}
+		else if (dType == pTypeENERGY)
+		{
+			if (splitresults.size() < 2)
+				continue;
+			sUsage = splitresults[0];
+			double fValue = atof(splitresults[1].c_str()) * 100;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if (dType == pTypePOWER)
+		{
+			if (splitresults.size() < 2)
+				continue;
+			sUsage = splitresults[0];
+			double fValue = atof(splitresults[1].c_str()) * 100;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if (dType == pTypeAirQuality)
+		{
+			sprintf(szTmp, "%d", nValue);
+			sValue = szTmp;
+			m_notifications.CheckAndHandleNotification(sd.ID, sd.HardwareID, sd.DeviceID, sd.Name, sd.Unit, dType, dSubType, (int)nValue);
+		}
+		else if ((dType == pTypeGeneral) && ((dSubType == sTypeSoilMoisture) || (dSubType == sTypeLeafWetness)))
+		{
+			sprintf(szTmp, "%d", nValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeVisibility))
+		{
+			double fValue = atof(sValue.c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeDistance))
+		{
+			double fValue = atof(sValue.c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeSolarRadiation))
+		{
+			double fValue = atof(sValue.c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeSoundLevel))
+		{
+			double fValue = atof(sValue.c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeKwh))
+		{
+			if (splitresults.size() < 2)
+				continue;
 
-				fValue = atof(splitresults[1].c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeLux)
-			{
-				double fValue = atof(sValue.c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeWEIGHT)
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeRFXSensor)
-			{
-				double fValue = atof(sValue.c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeCounterIncremental))
-			{
-				double fValue = atof(sValue.c_str());
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeVoltage))
-			{
-				double fValue = atof(sValue.c_str()) * 1000.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypeCurrent))
-			{
-				double fValue = atof(sValue.c_str()) * 1000.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if ((dType == pTypeGeneral) && (dSubType == sTypePressure))
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
-			else if (dType == pTypeUsage)
-			{
-				double fValue = atof(sValue.c_str()) * 10.0F;
-				sprintf(szTmp, "%.0f", fValue);
-				sValue = szTmp;
-			}
+			double fValue = atof(splitresults[0].c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sUsage = szTmp;
 
-			long long MeterValue = 0;
-			long long MeterUsage = 0;
+			fValue = atof(splitresults[1].c_str());
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if (dType == pTypeLux)
+		{
+			double fValue = atof(sValue.c_str());
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if (dType == pTypeWEIGHT)
+		{
+			double fValue = atof(sValue.c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if (dType == pTypeRFXSensor)
+		{
+			double fValue = atof(sValue.c_str());
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeCounterIncremental))
+		{
+			double fValue = atof(sValue.c_str());
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeVoltage))
+		{
+			double fValue = atof(sValue.c_str()) * 1000.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypeCurrent))
+		{
+			double fValue = atof(sValue.c_str()) * 1000.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if ((dType == pTypeGeneral) && (dSubType == sTypePressure))
+		{
+			double fValue = atof(sValue.c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
+		else if (dType == pTypeUsage)
+		{
+			double fValue = atof(sValue.c_str()) * 10.0F;
+			sprintf(szTmp, "%.0f", fValue);
+			sValue = szTmp;
+		}
 
-			try
-			{
-				MeterUsage = std::stoll(sUsage);
-				MeterValue = std::stoll(sValue);
-			}
-			catch (const std::exception&)
-			{
-				_log.Log(LOG_ERROR, "UpdateMeter: Error converting sValue/sUsage! (IDX: %s, sValue: '%s', sUsage: '%s', dType: %d, sType: %d)", sd[0].c_str(), sValue.c_str(), sUsage.c_str(), dType, dSubType);
-			}
+		long long MeterValue = 0;
+		long long MeterUsage = 0;
 
-			//insert record
-			safe_query(
-				"INSERT INTO Meter (DeviceRowID, Value, [Usage]) "
-				"VALUES ('%" PRIu64 "', '%lld', '%lld')",
-				ID,
-				MeterValue,
-				MeterUsage
-			);
+		try
+		{
+			MeterUsage = std::stoll(sUsage);
+			MeterValue = std::stoll(sValue);
 		}
+		catch (const std::exception&)
+		{
+			_log.Log(LOG_ERROR, "UpdateMeter: Error converting sValue/sUsage! (IDX: %" PRIu64 ", sValue: '%s', sUsage: '%s', dType: %d, sType: %d)", sd.ID, sValue.c_str(), sUsage.c_str(), dType, dSubType);
+		}
+
+		rows.push_back({ std::to_string(sd.ID), std::to_string(MeterValue), std::to_string(MeterUsage) });
 	}
 }
 
-void CSQLHelper::UpdateMultiMeter()
+void CSQLHelper::UpdateMultiMeter(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate,Options FROM DeviceStatus WHERE (Type=%d OR Type=%d OR Type=%d)",
-		pTypeP1Power,
-		pTypeCURRENT,
-		pTypeCURRENTENERGY
-	);
-	if (!result.empty())
+	for (const auto &sd : devices)
 	{
-		for (const auto &sd : result)
-		{
-			std::string sOptions = sd[6];
-			std::map<std::string, std::string> options = BuildDeviceOptions(sOptions);
-			// We don't want to update meter if externally managed
-			if (options["DisableLogAutoUpdate"] == "true")
-			{
-				continue;
-			}
+		unsigned char dType = sd.Type;
+		unsigned char dSubType = sd.SubType;
 
-			uint64_t ID = std::stoull(sd[0]);
-			unsigned char dType = atoi(sd[1].c_str());
-			unsigned char dSubType = atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
+		if ((dType != pTypeP1Power) && (dType != pTypeCURRENT) && (dType != pTypeCURRENTENERGY))
+			continue;
 
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+		std::map<std::string, std::string> options = BuildDeviceOptions(sd.Options);
+		// We don't want to update meter if externally managed
+		if (options["DisableLogAutoUpdate"] == "true")
+		{
+			continue;
+		}
 
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
+		//do not include sensors that have no reading within an hour
+		if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+			continue;
 
-			unsigned long long value1 = 0;
-			unsigned long long value2 = 0;
-			unsigned long long value3 = 0;
-			unsigned long long value4 = 0;
-			unsigned long long value5 = 0;
-			unsigned long long value6 = 0;
+		const std::vector<std::string> &splitresults = sd.Values;
 
-			if (dType == pTypeP1Power)
-			{
-				if (splitresults.size() != 6)
-					continue; //impossible
+		unsigned long long value1 = 0;
+		unsigned long long value2 = 0;
+		unsigned long long value3 = 0;
+		unsigned long long value4 = 0;
+		unsigned long long value5 = 0;
+		unsigned long long value6 = 0;
 
-				unsigned long long powerusage1 = 0;
-				unsigned long long powerusage2 = 0;
-				unsigned long long powerdeliv1 = 0;
-				unsigned long long powerdeliv2 = 0;
-				unsigned long long usagecurrent = 0;
-				unsigned long long delivcurrent = 0;
+		if (dType == pTypeP1Power)
+		{
+			if (splitresults.size() != 6)
+				continue; //impossible
 
-				try
-				{
-					powerusage1 = std::stoull(splitresults[0]);
-					powerusage2 = std::stoull(splitresults[1]);
-					powerdeliv1 = std::stoull(splitresults[2]);
-					powerdeliv2 = std::stoull(splitresults[3]);
-					usagecurrent = std::stoull(splitresults[4]);
-					delivcurrent = std::stoull(splitresults[5]);
-				}
-				catch (const std::exception &)
-				{
-					_log.Log(LOG_ERROR, "UpdateMultiMeter: Error converting sValue values! (IDX: %s, sValue: '%s', dType: %d, sType: %d)", sd[0].c_str(), sValue.c_str(), dType, dSubType);
-				}
+			unsigned long long powerusage1 = 0;
+			unsigned long long powerusage2 = 0;
+			unsigned long long powerdeliv1 = 0;
+			unsigned long long powerdeliv2 = 0;
+			unsigned long long usagecurrent = 0;
+			unsigned long long delivcurrent = 0;
 
-				value1 = powerusage1;
-				value2 = powerdeliv1;
-				value5 = powerusage2;
-				value6 = powerdeliv2;
-				value3 = usagecurrent;
-				value4 = delivcurrent;
-			}
-			else if ((dType == pTypeCURRENT) && (dSubType == sTypeELEC1))
+			try
 			{
-				if (splitresults.size() != 3)
-					continue; //impossible
-
-				value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
-				value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
-				value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
+				powerusage1 = std::stoull(splitresults[0]);
+				powerusage2 = std::stoull(splitresults[1]);
+				powerdeliv1 = std::stoull(splitresults[2]);
+				powerdeliv2 = std::stoull(splitresults[3]);
+				usagecurrent = std::stoull(splitresults[4]);
+				delivcurrent = std::stoull(splitresults[5]);
 			}
-			else if ((dType == pTypeCURRENTENERGY) && (dSubType == sTypeELEC4))
+			catch (const std::exception &)
 			{
-				if (splitresults.size() != 4)
-					continue; //impossible
-
-				value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
-				value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
-				value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
-				value4 = (unsigned long long)(atof(splitresults[3].c_str()) * 1000.0F);
+				_log.Log(LOG_ERROR, "UpdateMultiMeter: Error converting sValue values! (IDX: %" PRIu64 ", sValue: '%s', dType: %d, sType: %d)", sd.ID, sd.sValue.c_str(), dType, dSubType);
 			}
-			else
-				continue;//don't know you (yet)
 
-			//insert record
-			safe_query(
-				"INSERT INTO MultiMeter (DeviceRowID, Value1, Value2, Value3, Value4, Value5, Value6) "
-				"VALUES ('%" PRIu64 "', '%llu', '%llu', '%llu', '%llu', '%llu', '%llu')",
-				ID,
-				value1,
-				value2,
-				value3,
-				value4,
-				value5,
-				value6
-			);
+			value1 = powerusage1;
+			value2 = powerdeliv1;
+			value5 = powerusage2;
+			value6 = powerdeliv2;
+			value3 = usagecurrent;
+			value4 = delivcurrent;
+		}
+		else if ((dType == pTypeCURRENT) && (dSubType == sTypeELEC1))
+		{
+			if (splitresults.size() != 3)
+				continue; //impossible
+
+			value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
+			value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
+			value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
 		}
+		else if ((dType == pTypeCURRENTENERGY) && (dSubType == sTypeELEC4))
+		{
+			if (splitresults.size() != 4)
+				continue; //impossible
+
+			value1 = (unsigned long)(atof(splitresults[0].c_str()) * 10.0F);
+			value2 = (unsigned long)(atof(splitresults[1].c_str()) * 10.0F);
+			value3 = (unsigned long)(atof(splitresults[2].c_str()) * 10.0F);
+			value4 = (unsigned long long)(atof(splitresults[3].c_str()) * 1000.0F);
+		}
+		else
+			continue;//don't know you (yet)
+
+		rows.push_back({
+			std::to_string(sd.ID),
+			std::to_string(value1),
+			std::to_string(value2),
+			std::to_string(value3),
+			std::to_string(value4),
+			std::to_string(value5),
+			std::to_string(value6)
+		});
 	}
 }
 
-void CSQLHelper::UpdatePercentageLog()
+void CSQLHelper::UpdatePercentageLog(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d) OR (Type=%d AND SubType=%d)",
-		pTypeGeneral, sTypePercentage,
-		pTypeGeneral, sTypeWaterflow,
-		pTypeGeneral, sTypeCustom
-	);
-	if (!result.empty())
+	for (const auto &sd : devices)
 	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
-
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+		if ((sd.Type != pTypeGeneral) || ((sd.SubType != sTypePercentage) && (sd.SubType != sTypeWaterflow) && (sd.SubType != sTypeCustom)))
+			continue;
 
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
+		//do not include sensors that have no reading within an hour
+		if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+			continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
+		if (sd.Values.empty())
+			continue; //impossible
 
-			float percentage = static_cast<float>(atof(sValue.c_str()));
+		float percentage = static_cast<float>(atof(sd.sValue.c_str()));
 
-			//insert record
-			safe_query(
-				"INSERT INTO Percentage (DeviceRowID, Percentage) "
-				"VALUES ('%" PRIu64 "', '%g')",
-				ID,
-				percentage
-			);
-		}
+		rows.push_back({ std::to_string(sd.ID), std_format("%g", percentage) });
 	}
 }
 
-void CSQLHelper::UpdateFanLog()
+void CSQLHelper::UpdateFanLog(const std::vector<_tShortLogDevice> &devices, const time_t now, const int SensorTimeOut, TSqlQueryResult &rows)
 {
-	time_t now = mytime(nullptr);
-	if (now == 0)
-		return;
-	struct tm tm1;
-	localtime_r(&now, &tm1);
-
-	int SensorTimeOut = 60;
-	GetPreferencesVar("SensorTimeout", SensorTimeOut);
-
-	std::vector<std::vector<std::string> > result;
-	result = safe_query("SELECT ID,Type,SubType,nValue,sValue,LastUpdate FROM DeviceStatus WHERE (Type=%d AND SubType=%d)",
-		pTypeGeneral, sTypeFan
-	);
-	if (!result.empty())
+	for (const auto &sd : devices)
 	{
-		for (const auto &sd : result)
-		{
-			uint64_t ID = std::stoull(sd[0]);
-
-			//unsigned char dType=atoi(sd[1].c_str());
-			//unsigned char dSubType=atoi(sd[2].c_str());
-			//int nValue=atoi(sd[3].c_str());
-			std::string sValue = sd[4];
-
-			//do not include sensors that have no reading within an hour
-			std::string sLastUpdate = sd[5];
-			struct tm ntime;
-			time_t checktime;
-			ParseSQLdatetime(checktime, ntime, sLastUpdate, tm1.tm_isdst);
+		if ((sd.Type != pTypeGeneral) || (sd.SubType != sTypeFan))
+			continue;
 
-			if (difftime(now, checktime) >= SensorTimeOut * 60)
-				continue;
+		//do not include sensors that have no reading within an hour
+		if (difftime(now, sd.LastUpdate) >= SensorTimeOut * 60)
+			continue;
 
-			std::vector<std::string> splitresults;
-			StringSplit(sValue, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
+		if (sd.Values.empty())
+			continue; //impossible
 
-			int speed = (int)atoi(sValue.c_str());
+		int speed = (int)atoi(sd.sValue.c_str());
 
-			//insert record
-			safe_query(
-				"INSERT INTO Fan (DeviceRowID, Speed) "
-				"VALUES ('%" PRIu64 "', '%d')",
-				ID,
-				speed
-			);
-		}
+		rows.push_back({ std::to_string(sd.ID), std::to_string(speed) });
 	}
 }
 
@@ -6937,10 +7042,11 @@ void CSQLHelper::AddCalendarUpdateMeter()
 					std::vector<std::string> sd = result[0];
 					//Insert the last (max) counter value into the meter table to get the "today" value correct.
 					result = safe_query(
-						"INSERT INTO Meter (DeviceRowID, Value, Date) "
-						"VALUES ('%" PRIu64 "', '%q', '%q')",
+						"INSERT INTO Meter (DeviceRowID, Value, Date, ts) "
+						"VALUES ('%" PRIu64 "', '%q', '%q', strftime('%%s', '%q', 'utc'))",
 						ID,
 						sd[0].c_str(),
+						szDateEnd,
 						szDateEnd
 					);
 				}
@@ -7304,6 +7410,50 @@ void CSQLHelper::AddCalendarUpdateFan()
 	}
 }
 
+//Deletes the short log entries of one table that are older than cutoff.
+//Works per device in bounded chunks so the (DeviceRowID, ts) index is used and
+//the SQL mutex is released between chunks to let device updates through.
+//The devices are taken from the table itself, so rows of deleted devices are cleaned too
+uint64_t CSQLHelper::CleanupShortLogTable(const char *szTable, const time_t cutoff)
+{
+	uint64_t totalRows = 0;
+	int64_t lastIdx = -1;
+	while (!IsStopRequested(0))
+	{
+		std::vector<std::vector<std::string> > result;
+		result = safe_query("SELECT MIN(DeviceRowID) FROM %s WHERE (DeviceRowID>%" PRId64 ")", szTable, lastIdx);
+		if (result.empty() || result[0][0].empty())
+			break;
+		lastIdx = std::stoll(result[0][0]);
+		while (true)
+		{
+			int nChanges;
+			{
+				std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+				char *zQuery = sqlite3_mprintf("DELETE FROM %s WHERE rowid IN (SELECT rowid FROM %s WHERE (DeviceRowID==%" PRId64 ") AND (ts<%lld) LIMIT %d)",
+					szTable, szTable, lastIdx, (long long)cutoff, SHORTLOG_CLEANUP_BATCH_SIZE);
+				if (!zQuery)
+					return totalRows;
+				char *errorMessage = nullptr;
+				int rc = sqlite3_exec(m_dbase, zQuery, nullptr, nullptr, &errorMessage);
+				sqlite3_free(zQuery);
+				if (rc != SQLITE_OK)
+				{
+					_log.Log(LOG_ERROR, "CleanupShortLog: %s, %s", szTable, (errorMessage != nullptr) ? errorMessage : sqlite3_errstr(rc));
+					sqlite3_free(errorMessage);
+					return totalRows;
+				}
+				nChanges = sqlite3_changes(m_dbase);
+			}
+			totalRows += nChanges;
+			if (nChanges < SHORTLOG_CLEANUP_BATCH_SIZE)
+				break;
+			sleep_milliseconds(1);
+		}
+	}
+	return totalRows;
+}
+
 void CSQLHelper::CleanupShortLog()
 {
 	int n5MinuteHistoryDays = 1;
@@ -7315,41 +7465,34 @@ void CSQLHelper::CleanupShortLog()
 			_log.Log(LOG_ERROR, "CleanupShortLog(): MinuteHistoryDays is zero!");
 			return;
 		}
-#if 0
-		char szDateStr[40];
-		time_t clear_time = mytime(NULL) - (n5MinuteHistoryDays * 24 * 3600);
-		struct tm ltime;
-		localtime_r(&clear_time, &ltime);
-		sprintf(szDateStr, "%04d-%02d-%02d %02d:%02d:%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
-		_log.Log(LOG_STATUS, "Cleaning up shortlog older than %s", szDateStr);
-#endif
-
-		char szQuery[250];
-		std::string szQueryFilter = "strftime('%s',datetime('now','localtime')) - strftime('%s',Date) > (SELECT p.nValue * 86400 From Preferences AS p WHERE p.Key='5MinuteHistoryDays')";
-
-		sprintf(szQuery, "DELETE FROM Temperature WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Rain WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Wind WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM UV WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
-
-		sprintf(szQuery, "DELETE FROM Meter WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
 
-		sprintf(szQuery, "DELETE FROM MultiMeter WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
+		static const char *szTables[] = { "Temperature", "Rain", "Wind", "UV", "Meter", "MultiMeter", "Percentage", "Fan" };
 
-		sprintf(szQuery, "DELETE FROM Percentage WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
+		time_t now = mytime(nullptr);
+		uint64_t totalRows = 0;
+		auto tStart = std::chrono::steady_clock::now();
+		for (const auto szTable : szTables)
+		{
+			// Optional per table retention, for example 5MinuteHistoryDaysTemperature
+			int nDays = n5MinuteHistoryDays;
+			int nTableDays = 0;
+			if (GetPreferencesVar(std::string("5MinuteHistoryDays") + szTable, nTableDays) && (nTableDays > 0))
+				nDays = nTableDays;
+
+			char szDateStr[40];
+			time_t clear_time = now - (nDays * 24 * 3600);
+			struct tm ltime;
+			localtime_r(&clear_time, &ltime);
+			sprintf(szDateStr, "%04d-%02d-%02d %02d:%02d:%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday, ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
 
-		sprintf(szQuery, "DELETE FROM Fan WHERE %s", szQueryFilter.c_str());
-		query(szQuery);
+			auto tTable = std::chrono::steady_clock::now();
+			uint64_t nRows = CleanupShortLogTable(szTable, clear_time);
+			totalRows += nRows;
+			_log.Debug(DEBUG_NORM, "CleanupShortLog: %s, %" PRIu64 " rows older than %s removed (%d ms)", szTable, nRows, szDateStr,
+				static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tTable).count()));
+		}
+		_log.Debug(DEBUG_NORM, "CleanupShortLog: %" PRIu64 " rows removed (%d ms)", totalRows,
+			static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - tStart).count()));
 	}
 }
 
@@ -7363,9 +7506,105 @@ void CSQLHelper::ClearShortLog()
 	query("DELETE FROM MultiMeter");
 	query("DELETE FROM Percentage");
 	query("DELETE FROM Fan");
+	HistoryChanged();
 	VacuumDatabase();
 }
 
+void CSQLHelper::GetDzVentsData(const std::string &Module, std::vector<std::pair<std::string, std::string>> &values,
+				std::map<std::string, std::vector<std::pair<int64_t, std::string>>> &history)
+{
+	auto result = safe_query("SELECT Name, Value FROM DzVentsData WHERE (Module=='%q')", Module.c_str());
+	for (const auto &sd : result)
+		values.emplace_back(sd[0], sd[1]);
+
+	//youngest entry first, as the runtime keeps them
+	result = safe_query("SELECT Name, Seq, Value FROM DzVentsHistory WHERE (Module=='%q') ORDER BY Name, Seq DESC", Module.c_str());
+	for (const auto &sd : result)
+		history[sd[0]].emplace_back(std::stoll(sd[1]), sd[2]);
+}
+
+//Writes only the given variables of a module, a missing value removes the variable.
+//History variables only get their new entries appended and the dropped ones removed
+void CSQLHelper::StoreDzVentsData(const std::string &Module, const std::map<std::string, std::string> &changed, const std::vector<std::string> &removed,
+				  const std::map<std::string, _tDzVentsHistoryChange> &history)
+{
+	if (changed.empty() && removed.empty() && history.empty())
+		return;
+
+	std::lock_guard<std::mutex> t(m_transactionMutex);
+	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	sqlite3_stmt *stmtInsert = nullptr;
+	sqlite3_stmt *stmtDelete = nullptr;
+	sqlite3_stmt *stmtAppend = nullptr;
+	sqlite3_stmt *stmtTrim = nullptr;
+	if (
+		(sqlite3_prepare_v2(m_dbase, "INSERT OR REPLACE INTO DzVentsData (Module, Name, Value) VALUES (?,?,?)", -1, &stmtInsert, nullptr) != SQLITE_OK)
+		|| (sqlite3_prepare_v2(m_dbase, "DELETE FROM DzVentsData WHERE (Module==?) AND (Name==?)", -1, &stmtDelete, nullptr) != SQLITE_OK)
+		|| (sqlite3_prepare_v2(m_dbase, "INSERT OR REPLACE INTO DzVentsHistory (Module, Name, Seq, Value) VALUES (?,?,?,?)", -1, &stmtAppend, nullptr) != SQLITE_OK)
+		|| (sqlite3_prepare_v2(m_dbase, "DELETE FROM DzVentsHistory WHERE (Module==?) AND (Name==?) AND (Seq<?)", -1, &stmtTrim, nullptr) != SQLITE_OK)
+		)
+	{
+		_log.Log(LOG_ERROR, "SQL: Unable to prepare dzVents data statements (%s)", sqlite3_errmsg(m_dbase));
+		sqlite3_finalize(stmtInsert);
+		sqlite3_finalize(stmtDelete);
+		sqlite3_finalize(stmtAppend);
+		sqlite3_finalize(stmtTrim);
+		return;
+	}
+
+	sqlite3_exec(m_dbase, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+	for (const auto &itt : changed)
+	{
+		sqlite3_bind_text(stmtInsert, 1, Module.c_str(), (int)Module.size(), SQLITE_STATIC);
+		sqlite3_bind_text(stmtInsert, 2, itt.first.c_str(), (int)itt.first.size(), SQLITE_STATIC);
+		sqlite3_bind_text(stmtInsert, 3, itt.second.c_str(), (int)itt.second.size(), SQLITE_STATIC);
+		if (sqlite3_step(stmtInsert) != SQLITE_DONE)
+			_log.Log(LOG_ERROR, "SQL: Unable to store dzVents data %s/%s (%s)", Module.c_str(), itt.first.c_str(), sqlite3_errmsg(m_dbase));
+		sqlite3_reset(stmtInsert);
+	}
+	for (const auto &name : removed)
+	{
+		sqlite3_bind_text(stmtDelete, 1, Module.c_str(), (int)Module.size(), SQLITE_STATIC);
+		sqlite3_bind_text(stmtDelete, 2, name.c_str(), (int)name.size(), SQLITE_STATIC);
+		sqlite3_step(stmtDelete);
+		sqlite3_reset(stmtDelete);
+	}
+	for (const auto &itt : history)
+	{
+		if (itt.second.TrimBelow > 0)
+		{
+			sqlite3_bind_text(stmtTrim, 1, Module.c_str(), (int)Module.size(), SQLITE_STATIC);
+			sqlite3_bind_text(stmtTrim, 2, itt.first.c_str(), (int)itt.first.size(), SQLITE_STATIC);
+			sqlite3_bind_int64(stmtTrim, 3, itt.second.TrimBelow);
+			sqlite3_step(stmtTrim);
+			sqlite3_reset(stmtTrim);
+		}
+		for (const auto &entry : itt.second.Added)
+		{
+			sqlite3_bind_text(stmtAppend, 1, Module.c_str(), (int)Module.size(), SQLITE_STATIC);
+			sqlite3_bind_text(stmtAppend, 2, itt.first.c_str(), (int)itt.first.size(), SQLITE_STATIC);
+			sqlite3_bind_int64(stmtAppend, 3, entry.first);
+			sqlite3_bind_text(stmtAppend, 4, entry.second.c_str(), (int)entry.second.size(), SQLITE_STATIC);
+			if (sqlite3_step(stmtAppend) != SQLITE_DONE)
+				_log.Log(LOG_ERROR, "SQL: Unable to store dzVents history %s/%s (%s)", Module.c_str(), itt.first.c_str(), sqlite3_errmsg(m_dbase));
+			sqlite3_reset(stmtAppend);
+		}
+	}
+	sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, nullptr);
+	sqlite3_finalize(stmtInsert);
+	sqlite3_finalize(stmtDelete);
+	sqlite3_finalize(stmtAppend);
+	sqlite3_finalize(stmtTrim);
+}
+
+//Removes all stored data of a dzVents script
+void CSQLHelper::DeleteDzVentsData(const std::string &Module)
+{
+	CSQLTransaction transaction(*this);
+	safe_query("DELETE FROM DzVentsData WHERE (Module=='%q')", Module.c_str());
+	safe_query("DELETE FROM DzVentsHistory WHERE (Module=='%q')", Module.c_str());
+}
+
 void CSQLHelper::VacuumDatabase()
 {
 	query("VACUUM");
@@ -7450,6 +7689,7 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 #endif
 	{
 		//Avoid mutex deadlock here
+		std::lock_guard<std::mutex> t(m_transactionMutex);
 		std::lock_guard<std::mutex> l(m_sqlQueryMutex);
 
 		char* errorMessage;
@@ -7493,6 +7733,9 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 		}
 		sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, &errorMessage);
 	}
+	//only after the commit, and without the SQL locks held
+	for (const auto &str : _idx)
+		m_mainworker.m_devicestore.Remove(std::stoull(str));
 #ifdef ENABLE_PYTHON
 	for (const auto& it : removeddevices)
 	{
@@ -7513,6 +7756,30 @@ void CSQLHelper::DeleteDevices(const std::string& idx)
 	m_notifications.ReloadNotifications();
 }
 
+void CSQLHelper::BeginTransaction()
+{
+	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	sqlite3_exec(m_dbase, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+}
+
+void CSQLHelper::CommitTransaction()
+{
+	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	sqlite3_exec(m_dbase, "COMMIT TRANSACTION", nullptr, nullptr, nullptr);
+}
+
+CSQLTransaction::CSQLTransaction(CSQLHelper &sql)
+	: m_helper(sql)
+	, m_lock(sql.m_transactionMutex)
+{
+	m_helper.BeginTransaction();
+}
+
+CSQLTransaction::~CSQLTransaction()
+{
+	m_helper.CommitTransaction();
+}
+
 //Argument, one or multiple devices separated by a semicolumn (;)
 void CSQLHelper::DeleteScenes(const std::string& idx)
 {
@@ -7522,6 +7789,7 @@ void CSQLHelper::DeleteScenes(const std::string& idx)
 		return;
 	{
 		//Avoid mutex deadlock here
+		std::lock_guard<std::mutex> t(m_transactionMutex);
 		std::lock_guard<std::mutex> l(m_sqlQueryMutex);
 
 		char* errorMessage;
@@ -7658,6 +7926,8 @@ void CSQLHelper::TransferDevice(const std::string& idx, const std::string& newid
 		safe_query("UPDATE Percentage_Calendar SET DeviceRowID='%q' WHERE (DeviceRowID == '%q') AND (Date<'%q')", newidx.c_str(), idx.c_str(), result[0][0].c_str());
 	else
 		safe_query("UPDATE Percentage_Calendar SET DeviceRowID='%q' WHERE (DeviceRowID == '%q')", newidx.c_str(), idx.c_str());
+	HistoryChanged(std::stoull(idx));
+	HistoryChanged(std::stoull(newidx));
 }
 
 void CSQLHelper::CheckAndUpdateDeviceOrder()
@@ -7834,6 +8104,7 @@ void CSQLHelper::DeleteDateRange(const char *ID, const std::string &fromDate, co
 		safe_query("DELETE FROM %q WHERE (DeviceRowID=='%q') AND (Date>='%q') AND (Date<='%q')", historyTable.c_str(), ID, fromDate.c_str(), toDate.c_str() );
 		_log.Debug(DEBUG_NORM, "CSQLHelper::DeleteDateRange; delete from %s with idx: %s and Date >= %s and date <= %s " , historyTable.c_str(), std::string(ID).c_str(), fromDate.c_str(), toDate.c_str() );
 	}
+	HistoryChanged(std::strtoull(ID, nullptr, 10));
 }
 
 void CSQLHelper::DeleteDataPoint(const char* ID, const std::string& Date)
@@ -7961,6 +8232,7 @@ bool CSQLHelper::RestoreDatabase(const std::string& dbase)
 	StopThread();
 
 	//stop database
+	CloseReaderPool();
 	sqlite3_close(m_dbase);
 	m_dbase = nullptr;
 	std::ofstream outfile2;
@@ -7993,6 +8265,7 @@ bool CSQLHelper::RestoreDatabase(const std::string& dbase)
 	}
 	//Cleanup the database
 	VacuumDatabase();
+	HistoryChanged();
 	_log.Log(LOG_STATUS, "Restore Database: Succeeded!");
 	return true;
 }
@@ -8002,12 +8275,42 @@ bool CSQLHelper::BackupDatabase(const std::string& OutputFile)
 	if (!m_dbase)
 		return false; //database not open!
 
-	//First cleanup the database
-	OptimizeDatabase(m_dbase);
-	VacuumDatabase();
+	if (m_journal_mode != "WAL")
+	{
+		//Without WAL a reader blocks the writers, so copy through the main connection
+		std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+		return BackupDatabase(m_dbase, OutputFile);
+	}
 
-	std::lock_guard<std::mutex> l(m_sqlQueryMutex);
+	//Copy from a WAL snapshot on a separate read-only connection,
+	//device updates and web requests can continue while the backup runs
+	sqlite3* pSource = nullptr;
+	int rc = sqlite3_open_v2(m_dbase_name.c_str(), &pSource, SQLITE_OPEN_READONLY, nullptr);
+	if (rc != SQLITE_OK)
+	{
+		_log.Log(LOG_ERROR, "SQLHelper: Unable to open database for backup: %s", sqlite3_errmsg(pSource));
+		sqlite3_close(pSource);
+		return false;
+	}
+	sqlite3_exec(pSource, "PRAGMA busy_timeout = 1000", nullptr, nullptr, nullptr);
+
+	//Start the read transaction, this pins the snapshot for the whole copy
+	sqlite3_exec(pSource, "BEGIN", nullptr, nullptr, nullptr);
+	rc = sqlite3_exec(pSource, "SELECT COUNT(*) FROM sqlite_master", nullptr, nullptr, nullptr);
+
+	bool bRet = false;
+	if (rc == SQLITE_OK)
+		bRet = BackupDatabase(pSource, OutputFile);
+	else
+		_log.Log(LOG_ERROR, "SQLHelper: Unable to start backup read transaction: %s", sqlite3_errmsg(pSource));
+
+	sqlite3_exec(pSource, "COMMIT", nullptr, nullptr, nullptr);
+	sqlite3_close(pSource);
+	return bRet;
+}
 
+bool CSQLHelper::BackupDatabase(sqlite3* pSource, const std::string& OutputFile)
+{
 	int rc;					 // Function return code
 	sqlite3* pFile;			 // Database connection opened on zFilename
 	sqlite3_backup* pBackup;	// Backup handle used to copy data
@@ -8015,23 +8318,22 @@ bool CSQLHelper::BackupDatabase(const std::string& OutputFile)
 	// Open the database file identified by zFilename.
 	rc = sqlite3_open(OutputFile.c_str(), &pFile);
 	if (rc != SQLITE_OK)
+	{
+		sqlite3_close(pFile);
 		return false;
+	}
 
 	// Open the sqlite3_backup object used to accomplish the transfer
-	pBackup = sqlite3_backup_init(pFile, "main", m_dbase, "main");
+	pBackup = sqlite3_backup_init(pFile, "main", pSource, "main");
 
 	time_t startTime = time(nullptr);
 
 	if (pBackup)
 	{
-		// Each iteration of this loop copies 5 database pages from database
-		// pDb to the backup database.
+		// Copy all pages in one step, the source read transaction keeps them consistent.
+		// Only the destination can report BUSY/LOCKED here.
 		do {
-			rc = sqlite3_backup_step(pBackup, 256);
-			//xProgress(  sqlite3_backup_remaining(pBackup), sqlite3_backup_pagecount(pBackup) );
-			if( rc==SQLITE_BUSY || rc==SQLITE_LOCKED ){
-			  sqlite3_sleep(250);
-			}
+			rc = sqlite3_backup_step(pBackup, -1);
 			if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
 				time_t actTime = time(nullptr);
 				if (actTime - startTime > 2 * 60)
@@ -8040,6 +8342,7 @@ bool CSQLHelper::BackupDatabase(const std::string& OutputFile)
 					_log.Log(LOG_ERROR, "SQLHelper: Problem making backup! Check destination folder/rights. Process timeout!");
 					break;
 				}
+				sqlite3_sleep(50);
 			}
 		} while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
 
@@ -8095,6 +8398,7 @@ void CSQLHelper::Lighting2GroupCmd(const std::string& ID, const unsigned char su
 		pTypeLighting2,
 		subType,
 		GroupCmd);
+	RefreshDeviceGroup(ID, pTypeLighting2, subType);
 }
 
 uint64_t CSQLHelper::UpdateValueHomeConfortGroupCmd(const int HardwareID, const char* ID, const unsigned char unit,
@@ -8138,11 +8442,21 @@ void CSQLHelper::HomeConfortGroupCmd(const std::string& ID, const unsigned char
 		pTypeHomeConfort,
 		subType,
 		GroupCmd);
+	RefreshDeviceGroup(ID, pTypeHomeConfort, subType);
 }
 
 void CSQLHelper::GeneralSwitchGroupCmd(const std::string& ID, const unsigned char subType, const unsigned char GroupCmd)
 {
 	safe_query("UPDATE DeviceStatus SET nValue = %d WHERE (DeviceID=='%q') And (Type==%d) And (SubType==%d)", GroupCmd, ID.c_str(), pTypeGeneralSwitch, subType);
+	RefreshDeviceGroup(ID, pTypeGeneralSwitch, subType);
+}
+
+//Group commands write DeviceStatus directly, republish the devices of the group
+void CSQLHelper::RefreshDeviceGroup(const std::string& ID, const unsigned char devType, const unsigned char subType)
+{
+	auto result = safe_query("SELECT ID FROM DeviceStatus WHERE (DeviceID=='%q') AND (Type==%d) AND (SubType==%d)", ID.c_str(), devType, subType);
+	for (const auto &sd : result)
+		m_mainworker.m_devicestore.Refresh(std::stoull(sd[0]));
 }
 
 void CSQLHelper::SetUnitsAndScale()
@@ -8907,17 +9221,34 @@ std::string CSQLHelper::GetDeviceValue(const char * FieldName, const char *Idx)
 }
 */
 
+//Fields cached by the notification system, see CNotificationHelper::DeviceChanged
+static bool IsNotificationDeviceField(const char* FieldName)
+{
+	return (
+		(strcmp(FieldName, "SwitchType") == 0)
+		|| (strcmp(FieldName, "CustomImage") == 0)
+		|| (strcmp(FieldName, "Options") == 0)
+		|| (strcmp(FieldName, "AddjMulti") == 0)
+		);
+}
+
 void CSQLHelper::UpdateDeviceValue(const char* FieldName, const std::string& Value, const std::string& Idx)
 {
 	safe_query("UPDATE DeviceStatus SET %s='%s' , LastUpdate='%s' WHERE (ID == %s )", FieldName, Value.c_str(), TimeToString(nullptr, TF_DateTime).c_str(), Idx.c_str());
+	if (IsNotificationDeviceField(FieldName))
+		m_notifications.DeviceChanged(std::strtoull(Idx.c_str(), nullptr, 10));
 }
 void CSQLHelper::UpdateDeviceValue(const char* FieldName, const int Value, const std::string& Idx)
 {
 	safe_query("UPDATE DeviceStatus SET %s=%d , LastUpdate='%s' WHERE (ID == %s )", FieldName, Value, TimeToString(nullptr, TF_DateTime).c_str(), Idx.c_str());
+	if (IsNotificationDeviceField(FieldName))
+		m_notifications.DeviceChanged(std::strtoull(Idx.c_str(), nullptr, 10));
 }
 void CSQLHelper::UpdateDeviceValue(const char* FieldName, const float Value, const std::string& Idx)
 {
 	safe_query("UPDATE DeviceStatus SET %s=%4.2f , LastUpdate='%s' WHERE (ID == %s )", FieldName, Value, TimeToString(nullptr, TF_DateTime).c_str(), Idx.c_str());
+	if (IsNotificationDeviceField(FieldName))
+		m_notifications.DeviceChanged(std::strtoull(Idx.c_str(), nullptr, 10));
 }
 
 void CSQLHelper::UpdateDeviceName(const std::string& Idx, const std::string& Name)
@@ -9235,6 +9566,7 @@ bool CSQLHelper::SetDeviceOptions(const uint64_t idx, const std::map<std::string
 		//_log.Log(LOG_STATUS, "DEBUG : setting options '%s' on device %" PRIu64 "", options.c_str(), idx);
 		safe_query("UPDATE DeviceStatus SET Options = '%q' WHERE (ID==%" PRIu64 ")", options.c_str(), idx);
 	}
+	m_notifications.DeviceChanged(idx);
 	return true;
 }
 
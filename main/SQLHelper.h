@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <condition_variable>
+#include <atomic>
 #include "RFXNames.h"
 #include "../hardware/hardwaretypes.h"
 #include "Helper.h"
@@ -320,6 +322,30 @@ typedef std::vector<std::string> TSqlRowQuery;
 // result for an sql query : Vector of TSqlRowQuery
 typedef std::vector<TSqlRowQuery> TSqlQueryResult;
 
+// Changes to one dzVents history variable, entries are only appended and trimmed
+struct _tDzVentsHistoryChange
+{
+	int64_t TrimBelow = 0; // entries with a lower sequence are removed
+	std::vector<std::pair<int64_t, std::string>> Added; // sequence, serialized entry
+};
+
+// DeviceStatus row as seen by the 5 minute short log samplers
+struct _tShortLogDevice
+{
+	uint64_t ID;
+	std::string Name;
+	int HardwareID;
+	std::string DeviceID;
+	unsigned char Unit;
+	unsigned char Type;
+	unsigned char SubType;
+	int nValue;
+	std::string sValue;
+	std::vector<std::string> Values; // sValue split on ';'
+	std::string Options;
+	time_t LastUpdate = 0;
+};
+
 class CSQLHelper : public StoppableTask
 {
       public:
@@ -392,6 +418,11 @@ class CSQLHelper : public StoppableTask
 	void ScheduleDay();
 
 	void ClearShortLog();
+	void GetDzVentsData(const std::string &Module, std::vector<std::pair<std::string, std::string>> &values,
+			    std::map<std::string, std::vector<std::pair<int64_t, std::string>>> &history);
+	void StoreDzVentsData(const std::string &Module, const std::map<std::string, std::string> &changed, const std::vector<std::string> &removed,
+			      const std::map<std::string, _tDzVentsHistoryChange> &history);
+	void DeleteDzVentsData(const std::string &Module);
 	void VacuumDatabase();
 	void OptimizeDatabase(sqlite3 *dbase);
 	void DeleteHardware(const std::string &idx);
@@ -422,6 +453,12 @@ class CSQLHelper : public StoppableTask
 
 	std::vector<std::vector<std::string>> safe_query(const char *fmt, ...);
 	std::vector<std::vector<std::string>> safe_queryBlob(const char *fmt, ...);
+	std::vector<std::vector<std::string>> safe_query_read(const char *fmt, ...);
+
+	// Changes whenever stored history of a device may have changed, used to validate cached graphs
+	uint64_t GetHistoryGeneration(uint64_t DeviceRowID);
+	void HistoryChanged();
+	void HistoryChanged(uint64_t DeviceRowID);
 	void safe_exec_no_return(const char *fmt, ...);
 	bool safe_UpdateBlobInTableWithID(const std::string &Table, const std::string &Column, const std::string &sID, const std::string &BlobData);
 	bool DoesColumnExistsInTable(const std::string &columnname, const std::string &tablename);
@@ -480,9 +517,17 @@ class CSQLHelper : public StoppableTask
 	int scriptoutputindex=0;
 	std::mutex m_executeThreadMutex;
 	std::mutex m_sqlQueryMutex;
+	std::mutex m_transactionMutex; //one open transaction on m_dbase at a time, taken before m_sqlQueryMutex
 	sqlite3 *m_dbase;
 	std::string m_dbase_name;
 	std::string m_journal_mode;
+	std::atomic<uint64_t> m_historyGeneration{ 0 };
+	std::mutex m_historyMutex;
+	std::map<uint64_t, uint64_t> m_deviceHistoryGeneration;
+	std::mutex m_readerMutex;
+	std::condition_variable m_readerCondition;
+	std::vector<sqlite3 *> m_readers;
+	std::vector<sqlite3 *> m_idleReaders;
 	unsigned char m_sensortimeoutcounter;
 	std::map<uint64_t, int> m_timeoutlastsend;
 	std::map<uint64_t, int> m_batterylowlastsend;
@@ -519,14 +564,17 @@ class CSQLHelper : public StoppableTask
 
 	void CleanupLightSceneLog();
 
-	void UpdateTemperatureLog();
-	void UpdateRainLog();
-	void UpdateWindLog();
-	void UpdateUVLog();
-	void UpdateMeter();
-	void UpdateMultiMeter();
-	void UpdatePercentageLog();
-	void UpdateFanLog();
+	void GetShortLogDevices(std::vector<_tShortLogDevice> &devices);
+	void InsertShortLogRows(const char *szTable, const char *szColumns, const TSqlQueryResult &rows);
+	void RefreshDeviceGroup(const std::string &ID, unsigned char devType, unsigned char subType);
+	void UpdateTemperatureLog(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
+	void UpdateRainLog(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
+	void UpdateWindLog(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
+	void UpdateUVLog(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
+	void UpdateMeter(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
+	void UpdateMultiMeter(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
+	void UpdatePercentageLog(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
+	void UpdateFanLog(const std::vector<_tShortLogDevice> &devices, time_t now, int SensorTimeOut, TSqlQueryResult &rows);
 	void AddCalendarTemperature();
 	void AddCalendarUpdateRain();
 	void AddCalendarUpdateWind();
@@ -536,6 +584,8 @@ class CSQLHelper : public StoppableTask
 	void AddCalendarUpdatePercentage();
 	void AddCalendarUpdateFan();
 	void CleanupShortLog();
+	bool BackupDatabase(sqlite3 *pSource, const std::string &OutputFile);
+	uint64_t CleanupShortLogTable(const char *szTable, time_t cutoff);
 	bool CheckDate(const std::string &sDate, int &d, int &m, int &y);
 	bool CheckDateSQL(const std::string &sDate);
 	bool CheckDateTimeSQL(const std::string &sDateTime);
@@ -543,6 +593,32 @@ class CSQLHelper : public StoppableTask
 
 	std::vector<std::vector<std::string>> query(const std::string &szQuery);
 	std::vector<std::vector<std::string>> queryBlob(const std::string &szQuery);
+	std::vector<std::vector<std::string>> query(sqlite3 *dbase, const std::string &szQuery);
+	std::vector<std::vector<std::string>> query_read(const std::string &szQuery);
+	void OpenReaderPool();
+	void CloseReaderPool();
+	sqlite3 *AcquireReader();
+	void ReleaseReader(sqlite3 *pReader);
+	//caller holds m_transactionMutex, see CSQLTransaction
+	void BeginTransaction();
+	void CommitTransaction();
+	friend class CSQLTransaction;
+};
+
+//Groups the statements issued on the main connection while it lives into one transaction (one sync),
+//statements issued by other threads meanwhile are committed with it. Keep its scope short,
+//reader connections do not see the changes before the commit
+class CSQLTransaction
+{
+      public:
+	explicit CSQLTransaction(CSQLHelper &sql);
+	~CSQLTransaction();
+	CSQLTransaction(const CSQLTransaction &) = delete;
+	CSQLTransaction &operator=(const CSQLTransaction &) = delete;
+
+      private:
+	CSQLHelper &m_helper;
+	std::lock_guard<std::mutex> m_lock;
 };
 
 extern CSQLHelper m_sql;
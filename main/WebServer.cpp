@@ -69,6 +69,14 @@
 
 #define round(a) (int)(a + .5)
 
+// Upper bound of graph points held by the graph response cache
+#define GRAPH_CACHE_MAX_POINTS 250000
+
+// Upper bound of device updates in one udevicebulk request
+#define BULK_UPDATE_MAX_ITEMS 5000
+// Updates per database transaction, readers only see the changes once they are committed
+#define BULK_UPDATE_TRANSACTION_SIZE 50
+
 extern std::string szStartupFolder;
 extern std::string szUserDataFolder;
 extern std::string szWWWFolder;
@@ -100,6 +108,211 @@ namespace
 		{ "pl", "Polish" },    { "pt", "Portuguese" }, { "ro", "Romanian" }, { "ru", "Russian" },      { "sr", "Serbian" },   { "sk", "Slovak" },
 		{ "sl", "Slovenian" }, { "es", "Spanish" },    { "sv", "Swedish" },  { "zh_TW", "Taiwanese" }, { "tr", "Turkish" },   { "uk", "Ukrainian" },
 	} };
+
+	// Graph point fields are stored either as string or as number
+	double GraphPointValue(const Json::Value &point, const char *szField)
+	{
+		const Json::Value &value = point[szField];
+		if (value.isString())
+			return atof(value.asCString());
+		if (value.isNumeric())
+			return value.asDouble();
+		return 0;
+	}
+
+	// Largest-Triangle-Three-Buckets on the main series of the graph, keeps first/last and complete original points
+	void DownsampleGraph(Json::Value &result, const size_t maxPoints)
+	{
+		const size_t nPoints = result.size();
+		if ((maxPoints < 3) || (nPoints <= maxPoints))
+			return;
+		if (!result[0].isMember("d"))
+			return; // not a time series (groupby)
+
+		static const char *szFields[] = { "te", "v", "v1", "hu", "ba", "sp", "mm", "uvi", "v_max", "lux_max", "co2_max", "u_max" };
+		const char *szField = nullptr;
+		for (const auto field : szFields)
+		{
+			if (result[0].isMember(field))
+			{
+				szField = field;
+				break;
+			}
+		}
+		if (szField == nullptr)
+			return;
+
+		std::vector<double> y(nPoints);
+		for (size_t ii = 0; ii < nPoints; ii++)
+			y[ii] = GraphPointValue(result[(Json::ArrayIndex)ii], szField);
+
+		Json::Value sampled(Json::arrayValue);
+		sampled.append(result[0]);
+
+		const double every = double(nPoints - 2) / double(maxPoints - 2);
+		size_t a = 0;
+		for (size_t ii = 0; ii < maxPoints - 2; ii++)
+		{
+			// average of the next bucket
+			size_t avgStart = (size_t)std::floor((ii + 1) * every) + 1;
+			size_t avgEnd = std::min<size_t>((size_t)std::floor((ii + 2) * every) + 1, nPoints);
+			double avgX = 0;
+			double avgY = 0;
+			for (size_t jj = avgStart; jj < avgEnd; jj++)
+			{
+				avgX += jj;
+				avgY += y[jj];
+			}
+			if (avgEnd > avgStart)
+			{
+				avgX /= (avgEnd - avgStart);
+				avgY /= (avgEnd - avgStart);
+			}
+
+			// point of this bucket forming the largest triangle with the previous selected point and the next average
+			size_t rangeStart = (size_t)std::floor(ii * every) + 1;
+			size_t rangeEnd = (size_t)std::floor((ii + 1) * every) + 1;
+			double maxArea = -1;
+			size_t next = rangeStart;
+			for (size_t jj = rangeStart; jj < rangeEnd; jj++)
+			{
+				double area = std::fabs((double(a) - avgX) * (y[jj] - y[a]) - (double(a) - double(jj)) * (avgY - y[a]));
+				if (area > maxArea)
+				{
+					maxArea = area;
+					next = jj;
+				}
+			}
+			sampled.append(result[(Json::ArrayIndex)next]);
+			a = next;
+		}
+		sampled.append(result[(Json::ArrayIndex)(nPoints - 1)]);
+		result.swap(sampled);
+	}
+
+	// Graph dates are local time "YYYY-MM-DD" or "YYYY-MM-DD HH:MM[:SS]"
+	bool GraphDateToEpoch(const std::string &sDate, int64_t &epoch)
+	{
+		struct tm ltime = {};
+		int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+		if (sscanf(sDate.c_str(), "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) < 3)
+			return false;
+		ltime.tm_year = year - 1900;
+		ltime.tm_mon = month - 1;
+		ltime.tm_mday = day;
+		ltime.tm_hour = hour;
+		ltime.tm_min = minute;
+		ltime.tm_sec = second;
+		ltime.tm_isdst = -1;
+		epoch = (int64_t)mktime(&ltime);
+		return true;
+	}
+
+	template <typename T> void AppendLE(std::string &out, T value)
+	{
+		unsigned char bytes[sizeof(T)];
+		memcpy(bytes, &value, sizeof(T));
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+		std::reverse(bytes, bytes + sizeof(T));
+#endif
+		out.append((const char *)bytes, sizeof(T));
+	}
+
+	void AlignTo4(std::string &out)
+	{
+		while (out.size() % 4)
+			out.push_back(0);
+	}
+
+	/*
+	 * Columnar binary graph format (little endian, sections 4 byte aligned so columns can be mapped to typed arrays):
+	 *  "DZG1", uint16 version, uint16 columns, uint32 rows, int64 base epoch (seconds),
+	 *  uint32 meta length + meta (JSON of the response without "result"),
+	 *  per column: uint8 type (0 = int32 seconds from base, 1 = float32, NaN when absent), uint8 name length + name,
+	 *  then per column: rows values.
+	 */
+	bool EncodeGraphColumnar(const Json::Value &root, std::string &out)
+	{
+		const Json::Value &result = root["result"];
+		if (!result.isArray())
+			return false;
+		const Json::ArrayIndex nRows = result.size();
+
+		std::vector<int64_t> epochs(nRows, 0);
+		int64_t base = 0;
+		std::vector<std::string> columns;
+		std::map<std::string, size_t> columnIndex;
+		for (Json::ArrayIndex ii = 0; ii < nRows; ii++)
+		{
+			const Json::Value &point = result[ii];
+			if (!point.isObject() || !GraphDateToEpoch(point["d"].asString(), epochs[ii]))
+				return false; // not a time series
+			if ((ii == 0) || (epochs[ii] < base))
+				base = epochs[ii];
+			for (const auto &name : point.getMemberNames())
+			{
+				if ((name == "d") || (columnIndex.find(name) != columnIndex.end()))
+					continue;
+				const Json::Value &value = point[name];
+				if (!value.isNumeric() && !value.isString())
+					continue;
+				columnIndex[name] = columns.size();
+				columns.push_back(name);
+			}
+		}
+
+		std::vector<std::vector<float>> values(columns.size(), std::vector<float>(nRows, std::numeric_limits<float>::quiet_NaN()));
+		for (Json::ArrayIndex ii = 0; ii < nRows; ii++)
+		{
+			const Json::Value &point = result[ii];
+			for (size_t col = 0; col < columns.size(); col++)
+			{
+				const Json::Value &value = point[columns[col]];
+				if (value.isNumeric())
+					values[col][ii] = value.asFloat();
+				else if (value.isString())
+				{
+					const char *szValue = value.asCString();
+					char *pEnd = nullptr;
+					double fValue = strtod(szValue, &pEnd);
+					if ((pEnd != szValue) && (*pEnd == 0))
+						values[col][ii] = static_cast<float>(fValue);
+				}
+			}
+		}
+
+		Json::Value meta = root;
+		meta.removeMember("result");
+		std::string sMeta = JSonToRawString(meta);
+
+		out.clear();
+		out.append("DZG1");
+		AppendLE<uint16_t>(out, 1);
+		AppendLE<uint16_t>(out, (uint16_t)(columns.size() + 1));
+		AppendLE<uint32_t>(out, nRows);
+		AppendLE<int64_t>(out, base);
+		AppendLE<uint32_t>(out, (uint32_t)sMeta.size());
+		out.append(sMeta);
+		AlignTo4(out);
+
+		out.push_back(0);
+		out.push_back(1);
+		out.push_back('d');
+		for (const auto &name : columns)
+		{
+			out.push_back(1);
+			out.push_back((char)std::min<size_t>(name.size(), 255));
+			out.append(name.substr(0, 255));
+		}
+		AlignTo4(out);
+
+		for (const auto epoch : epochs)
+			AppendLE<int32_t>(out, (int32_t)(epoch - base));
+		for (const auto &column : values)
+			for (const auto value : column)
+				AppendLE<float>(out, value);
+		return true;
+	}
 } // namespace
 
 extern http::server::CWebServerHelper m_webservers;
@@ -339,6 +552,7 @@ namespace http
 			m_pWebEm->RegisterPageCode("/uploadcustomicon", [this](auto &&session, auto &&req, auto &&rep) { Post_UploadCustomIcon(session, req, rep); });
 			m_pWebEm->RegisterPageCode("/html5.appcache", [this](auto &&session, auto &&req, auto &&rep) { GetAppCache(session, req, rep); });
 			m_pWebEm->RegisterPageCode("/camsnapshot.jpg", [this](auto &&session, auto &&req, auto &&rep) { GetCameraSnapshot(session, req, rep); });
+			m_pWebEm->RegisterPageCode("/metrics", [this](auto &&session, auto &&req, auto &&rep) { GetMetrics(session, req, rep); });
 			m_pWebEm->RegisterPageCode("/backupdatabase.php", [this](auto &&session, auto &&req, auto &&rep) { GetDatabaseBackup(session, req, rep); });
 			m_pWebEm->RegisterPageCode("/raspberry.cgi", [this](auto &&session, auto &&req, auto &&rep) { GetInternalCameraSnapshot(session, req, rep); });
 			m_pWebEm->RegisterPageCode("/uvccapture.cgi", [this](auto &&session, auto &&req, auto &&rep) { GetInternalCameraSnapshot(session, req, rep); });
@@ -515,6 +729,7 @@ namespace http
 			RegisterCommandCode("emailcamerasnapshot", [this](auto &&session, auto &&req, auto &&root) { Cmd_EmailCameraSnapshot(session, req, root); });
 			RegisterCommandCode("udevice", [this](auto &&session, auto &&req, auto &&root) { Cmd_UpdateDevice(session, req, root); });
 			RegisterCommandCode("udevices", [this](auto &&session, auto &&req, auto &&root) { Cmd_UpdateDevices(session, req, root); });
+			RegisterCommandCode("udevicebulk", [this](auto &&session, auto &&req, auto &&root) { Cmd_UpdateDeviceBulk(session, req, root); });
 			RegisterCommandCode("thermostatstate", [this](auto &&session, auto &&req, auto &&root) { Cmd_SetThermostatState(session, req, root); });
 			RegisterCommandCode("system_shutdown", [this](auto &&session, auto &&req, auto &&root) { Cmd_SystemShutdown(session, req, root); });
 			RegisterCommandCode("system_reboot", [this](auto &&session, auto &&req, auto &&root) { Cmd_SystemReboot(session, req, root); });
@@ -761,6 +976,24 @@ namespace http
 			}
 		}
 
+		void CWebServer::GetMetrics(WebEmSession &session, const request &req, reply &rep)
+		{
+			if (session.rights != 2)
+			{
+				session.reply_status = reply::forbidden;
+				return; // Only admin user allowed
+			}
+			const char *encoding_header = request::get_req_header(&req, "Accept-Encoding");
+			bool bGZip = (encoding_header != nullptr) && (strstr(encoding_header, "gzip") != nullptr);
+			rep.content = m_mainworker.m_metrics.GetMetrics(bGZip);
+			if (bGZip && !rep.content.empty())
+			{
+				rep.bIsGZIP = true;
+				reply::add_header(&rep, "Content-Encoding", "gzip");
+			}
+			reply::add_header(&rep, "Content-Type", "text/plain; version=0.0.4; charset=utf-8");
+		}
+
 		void CWebServer::GetAppCache(WebEmSession &session, const request &req, reply &rep)
 		{
 			std::string response;
@@ -880,6 +1113,20 @@ namespace http
 			else
 			{
 				HandleRType(rtype, session, req, root);
+				if ((rtype == "graph") && (root["status"].asString() == "OK"))
+				{
+					const char *szAccept = request::get_req_header(&req, "Accept");
+					if ((request::findValue(&req, "format") == "binary") || ((szAccept != nullptr) && (strstr(szAccept, "application/vnd.domoticz.graph") != nullptr)))
+					{
+						std::string sBinary;
+						if (EncodeGraphColumnar(root, sBinary))
+						{
+							reply::set_content(&rep, sBinary);
+							reply::add_header_content_type(&rep, "application/vnd.domoticz.graph");
+							return;
+						}
+					}
+				}
 			}
 		exitjson:
 			std::string jcallback = request::findValue(&req, "jsoncallback");
@@ -2976,72 +3223,220 @@ namespace http
 				return;
 			}
 
-			std::string hid = request::findValue(&req, "hid");
-			std::string did = request::findValue(&req, "did");
-			std::string dunit = request::findValue(&req, "dunit");
-			std::string dtype = request::findValue(&req, "dtype");
-			std::string dsubtype = request::findValue(&req, "dsubtype");
-
-			std::string nvalue = request::findValue(&req, "nvalue");
-			std::string svalue = request::findValue(&req, "svalue");
-			std::string ptrigger = request::findValue(&req, "parsetrigger");
+			_tDeviceUpdate update;
+			update.idx = idx;
+			update.hid = request::findValue(&req, "hid");
+			update.did = request::findValue(&req, "did");
+			update.dunit = request::findValue(&req, "dunit");
+			update.dtype = request::findValue(&req, "dtype");
+			update.dsubtype = request::findValue(&req, "dsubtype");
+			update.nvalue = request::findValue(&req, "nvalue");
+			update.svalue = request::findValue(&req, "svalue");
+			update.rssi = request::findValue(&req, "rssi");
+			update.battery = request::findValue(&req, "battery");
+			update.parseTrigger = (request::findValue(&req, "parsetrigger") != "false");
 
-			bool parseTrigger = (ptrigger != "false");
+			std::string szUpdateUser = Username + " (IP: " + session.remote_host + ")";
+			if (ApplyDeviceUpdate(update, szUpdateUser).empty())
+			{
+				root["status"] = "OK";
+				root["title"] = "Update Device";
+			}
+		}
 
-			if ((nvalue.empty() && svalue.empty()))
+		// Returns an error text, or an empty string when the device was updated
+		std::string CWebServer::ApplyDeviceUpdate(_tDeviceUpdate &update, const std::string &szUpdateUser)
+		{
+			if ((update.nvalue.empty() && update.svalue.empty()))
 			{
-				return;
+				return "missing nvalue/svalue";
 			}
 
 			int signallevel = 12;
 			int batterylevel = 255;
 
-			if (idx.empty())
+			if (update.idx.empty())
 			{
 				// No index supplied, check if raw parameters where supplied
-				if ((hid.empty()) || (did.empty()) || (dunit.empty()) || (dtype.empty()) || (dsubtype.empty()))
-					return;
+				if ((update.hid.empty()) || (update.did.empty()) || (update.dunit.empty()) || (update.dtype.empty()) || (update.dsubtype.empty()))
+					return "missing idx or hid/did/dunit/dtype/dsubtype";
 			}
 			else
 			{
 				// Get the raw device parameters
 				std::vector<std::vector<std::string>> result;
-				result = m_sql.safe_query("SELECT HardwareID, DeviceID, Unit, Type, SubType FROM DeviceStatus WHERE (ID=='%q')", idx.c_str());
+				result = m_sql.safe_query("SELECT HardwareID, DeviceID, Unit, Type, SubType FROM DeviceStatus WHERE (ID=='%q')", update.idx.c_str());
 				if (result.empty())
-					return;
-				hid = result[0][0];
-				did = result[0][1];
-				dunit = result[0][2];
-				dtype = result[0][3];
-				dsubtype = result[0][4];
+					return "unknown idx";
+				update.hid = result[0][0];
+				update.did = result[0][1];
+				update.dunit = result[0][2];
+				update.dtype = result[0][3];
+				update.dsubtype = result[0][4];
 			}
 
-			int HardwareID = atoi(hid.c_str());
-			std::string DeviceID = did;
-			int unit = atoi(dunit.c_str());
-			int devType = atoi(dtype.c_str());
-			int subType = atoi(dsubtype.c_str());
+			int HardwareID = atoi(update.hid.c_str());
+			std::string DeviceID = update.did;
+			int unit = atoi(update.dunit.c_str());
+			int devType = atoi(update.dtype.c_str());
+			int subType = atoi(update.dsubtype.c_str());
 
-			// uint64_t ulIdx = std::strtoull(idx.c_str(), nullptr, 10);
+			int invalue = atoi(update.nvalue.c_str());
 
-			int invalue = atoi(nvalue.c_str());
+			if (!update.rssi.empty())
+			{
+				signallevel = atoi(update.rssi.c_str());
+			}
+			if (!update.battery.empty())
+			{
+				batterylevel = atoi(update.battery.c_str());
+			}
+			if (!m_mainworker.UpdateDevice(HardwareID, DeviceID, unit, devType, subType, invalue, update.svalue, szUpdateUser, signallevel, batterylevel, update.parseTrigger))
+				return "update failed";
+			return "";
+		}
+
+		// Bulk udevice, the POST body is a JSON array of update objects or one object per line:
+		// {"idx":"12","nvalue":"0","svalue":"21.5;54;1","rssi":"7","battery":"90","parsetrigger":"true"}
+		// Devices can also be addressed with hid/did/dunit/dtype/dsubtype like udevice.
+		// Updates are committed in small batches, each item gets its own result.
+		void CWebServer::Cmd_UpdateDeviceBulk(WebEmSession &session, const request &req, Json::Value &root)
+		{
+			std::string Username = "Admin";
+			if (!session.username.empty())
+				Username = session.username;
+
+			if (session.rights < 1)
+			{
+				session.reply_status = reply::forbidden;
+				return; // only user or higher allowed
+			}
 
-			std::string sSignalLevel = request::findValue(&req, "rssi");
-			if (!sSignalLevel.empty())
+			Json::Value items(Json::arrayValue);
+			size_t firstchar = req.content.find_first_not_of(" \t\r\n");
+			if (firstchar == std::string::npos)
+				return;
+			if (req.content[firstchar] == '[')
+			{
+				if (!ParseJSon(req.content, items) || !items.isArray())
+				{
+					root["message"] = "invalid JSON array";
+					return;
+				}
+			}
+			else
 			{
-				signallevel = atoi(sSignalLevel.c_str());
+				std::vector<std::string> lines;
+				StringSplit(req.content, "\n", lines);
+				for (const auto &line : lines)
+				{
+					if (line.find_first_not_of(" \t\r") == std::string::npos)
+						continue;
+					Json::Value item;
+					if (!ParseJSon(line, item))
+						item = Json::Value(Json::nullValue);
+					items.append(item);
+				}
 			}
-			std::string sBatteryLevel = request::findValue(&req, "battery");
-			if (!sBatteryLevel.empty())
+			if (items.size() > BULK_UPDATE_MAX_ITEMS)
 			{
-				batterylevel = atoi(sBatteryLevel.c_str());
+				root["message"] = std_format("too many updates (max %d)", BULK_UPDATE_MAX_ITEMS);
+				return;
 			}
+
+			auto jsonString = [](const Json::Value &item, const char *szKey) -> std::string {
+				const Json::Value &value = item[szKey];
+				if (value.isNull())
+					return "";
+				return value.asString();
+			};
+
 			std::string szUpdateUser = Username + " (IP: " + session.remote_host + ")";
-			if (m_mainworker.UpdateDevice(HardwareID, DeviceID, unit, devType, subType, invalue, svalue, szUpdateUser, signallevel, batterylevel, parseTrigger))
+			int nUpdated = 0;
+
+			std::unique_ptr<CSQLTransaction> transaction;
+			for (Json::ArrayIndex ii = 0; ii < items.size(); ii++)
 			{
-				root["status"] = "OK";
-				root["title"] = "Update Device";
+				if ((ii % BULK_UPDATE_TRANSACTION_SIZE) == 0)
+				{
+					transaction.reset();
+					transaction.reset(new CSQLTransaction(m_sql));
+				}
+				const Json::Value &item = items[ii];
+				Json::Value &result = root["result"][ii];
+				std::string szError;
+				if (!item.isObject())
+					szError = "invalid item";
+				else
+				{
+					_tDeviceUpdate update;
+					try
+					{
+						update.idx = jsonString(item, "idx");
+						update.hid = jsonString(item, "hid");
+						update.did = jsonString(item, "did");
+						update.dunit = jsonString(item, "dunit");
+						update.dtype = jsonString(item, "dtype");
+						update.dsubtype = jsonString(item, "dsubtype");
+						update.nvalue = jsonString(item, "nvalue");
+						update.svalue = jsonString(item, "svalue");
+						update.rssi = jsonString(item, "rssi");
+						update.battery = jsonString(item, "battery");
+						update.parseTrigger = (jsonString(item, "parsetrigger") != "false");
+					}
+					catch (const Json::Exception &)
+					{
+						szError = "invalid item";
+					}
+					if (!update.idx.empty())
+						result["idx"] = update.idx;
+					if ((szError.empty()) && (update.idx.empty()) && (session.rights != 2))
+					{
+						// Raw form, check the rights on the device it addresses. Only admins may create devices this way
+						std::vector<std::vector<std::string>> devices;
+						devices = m_sql.safe_query("SELECT ID FROM DeviceStatus WHERE (HardwareID==%d) AND (DeviceID=='%q') AND (Unit==%d) AND (Type==%d) AND (SubType==%d)",
+									  atoi(update.hid.c_str()), update.did.c_str(), atoi(update.dunit.c_str()), atoi(update.dtype.c_str()), atoi(update.dsubtype.c_str()));
+						if (devices.empty())
+							szError = "unknown device";
+						else
+							update.idx = devices[0][0];
+					}
+					if (szError.empty())
+					{
+						if ((!update.idx.empty()) && (!IsIdxForUser(&session, atoi(update.idx.c_str()))))
+						{
+							_log.Log(LOG_ERROR, "User: %s tried to update an Unauthorized device!", session.username.c_str());
+							szError = "unauthorized";
+						}
+						else
+						{
+							try
+							{
+								szError = ApplyDeviceUpdate(update, szUpdateUser);
+							}
+							catch (const std::exception &e)
+							{
+								szError = e.what();
+							}
+						}
+					}
+				}
+				if (szError.empty())
+				{
+					result["status"] = "OK";
+					nUpdated++;
+				}
+				else
+				{
+					result["status"] = "ERR";
+					result["message"] = szError;
+				}
 			}
+			transaction.reset();
+
+			root["updated"] = nUpdated;
+			root["status"] = "OK";
+			root["title"] = "Update Devices";
 		}
 
 		void CWebServer::Cmd_UpdateDevices(WebEmSession &session, const request &req, Json::Value &root)
@@ -5207,6 +5602,7 @@ namespace http
 						std::string ID = result[0][0];
 
 						m_sql.safe_query("UPDATE DeviceStatus SET Used=1, Name='%q', SwitchType=%d WHERE (ID == '%q')", name.c_str(), switchtype, ID.c_str());
+						m_notifications.DeviceChanged(std::strtoull(ID.c_str(), nullptr, 10));
 
 						// Now continue to insert the switch
 						dtype = pTypeRadiator1;
@@ -5472,6 +5868,7 @@ namespace http
 				std::string ID = result[0][0];
 
 				m_sql.safe_query("UPDATE DeviceStatus SET Used=1, Name='%q', SwitchType=%d WHERE (ID == '%q')", name.c_str(), switchtype, ID.c_str());
+				m_notifications.DeviceChanged(std::strtoull(ID.c_str(), nullptr, 10));
 
 				if (lighttype == 407)
 				{
@@ -6493,6 +6890,7 @@ namespace http
 				if (nValue >= 0)
 				{
 					m_sql.safe_query("UPDATE DeviceStatus SET nValue=%d WHERE (ID == '%q')", nValue, idx.c_str());
+					m_mainworker.m_devicestore.Refresh(std::strtoull(idx.c_str(), nullptr, 10));
 					root["status"] = "OK";
 					root["title"] = "SwitchLight";
 				}
@@ -7942,6 +8340,18 @@ namespace http
 					m_sql.UpdatePreferencesVar("UVCParams", UVCParams);
 			}
 
+			std::string CameraSnapshotMaxAge = request::findValue(&req, "CameraSnapshotMaxAge");
+			if (!CameraSnapshotMaxAge.empty())
+			{
+				m_sql.GetPreferencesVar("CameraSnapshotMaxAge", rnOldvalue);
+				rnvalue = atoi(CameraSnapshotMaxAge.c_str());
+				if (rnOldvalue != rnvalue)
+				{
+					m_sql.UpdatePreferencesVar("CameraSnapshotMaxAge", rnvalue);
+					m_mainworker.m_cameras.ReloadCameras();
+				}
+			}
+
 			std::string EnableNewHardware = request::findValue(&req, "AcceptNewHardware");
 			int iEnableNewHardware = (EnableNewHardware == "on" ? 1 : 0);
 			m_sql.UpdatePreferencesVar("AcceptNewHardware", iEnableNewHardware);
@@ -8168,7 +8578,7 @@ namespace http
 
 			// Get All Hardware ID's/Names, need them later
 			std::map<int, _tHardwareListInt> _hardwareNames;
-			result = m_sql.safe_query("SELECT ID, Name, Enabled, Type, Mode1, Mode2 FROM Hardware");
+			result = m_sql.safe_query_read("SELECT ID, Name, Enabled, Type, Mode1, Mode2 FROM Hardware");
 			if (!result.empty())
 			{
 				for (const auto &sd : result)
@@ -8257,7 +8667,7 @@ namespace http
 					_eUserRights urights = m_users[iUser].userrights;
 					if (urights != URIGHTS_ADMIN)
 					{
-						result = m_sql.safe_query("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == %lu)", m_users[iUser].ID);
+						result = m_sql.safe_query_read("SELECT COUNT(*) FROM SharedDevices WHERE (SharedUserID == %lu)", m_users[iUser].ID);
 						if (!result.empty())
 						{
 							totUserDevices = (unsigned int)std::stoi(result[0][0]);
@@ -8277,20 +8687,20 @@ namespace http
 				{
 					// add scenes
 					if (!rowid.empty())
-						result = m_sql.safe_query("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
+						result = m_sql.safe_query_read("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
 									  " A.Protected, B.XOffset, B.YOffset, B.PlanID, A.Description"
 									  " FROM Scenes as A"
 									  " LEFT OUTER JOIN DeviceToPlansMap as B ON (B.DeviceRowID==a.ID) AND (B.DevSceneType==1)"
 									  " WHERE (A.ID=='%q')",
 									  rowid.c_str());
 					else if ((!planID.empty()) && (planID != "0"))
-						result = m_sql.safe_query("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
+						result = m_sql.safe_query_read("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
 									  " A.Protected, B.XOffset, B.YOffset, B.PlanID, A.Description"
 									  " FROM Scenes as A, DeviceToPlansMap as B WHERE (B.PlanID=='%q')"
 									  " AND (B.DeviceRowID==a.ID) AND (B.DevSceneType==1) ORDER BY B.[Order]",
 									  planID.c_str());
 					else if ((!floorID.empty()) && (floorID != "0"))
-						result = m_sql.safe_query("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
+						result = m_sql.safe_query_read("SELECT A.ID, A.Name, A.nValue, A.LastUpdate, A.Favorite, A.SceneType,"
 									  " A.Protected, B.XOffset, B.YOffset, B.PlanID, A.Description"
 									  " FROM Scenes as A, DeviceToPlansMap as B, Plans as C"
 									  " WHERE (C.FloorplanID=='%q') AND (C.ID==B.PlanID) AND (B.DeviceRowID==a.ID)"
@@ -8304,7 +8714,7 @@ namespace http
 							   " LEFT OUTER JOIN DeviceToPlansMap as B ON (B.DeviceRowID==a.ID) AND (B.DevSceneType==1)"
 							   " ORDER BY ");
 						szQuery += szOrderBy;
-						result = m_sql.safe_query(szQuery.c_str(), order.c_str());
+						result = m_sql.safe_query_read(szQuery.c_str(), order.c_str());
 					}
 
 					if (!result.empty())
@@ -8405,7 +8815,7 @@ namespace http
 				if (!rowid.empty())
 				{
 					//_log.Log(LOG_STATUS, "Getting device with id: %s", rowid.c_str());
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used, A.Type, A.SubType,"
+					result = m_sql.safe_query_read("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used, A.Type, A.SubType,"
 								  " A.SignalLevel, A.BatteryLevel, A.nValue, A.sValue,"
 								  " A.LastUpdate, A.Favorite, A.SwitchType, A.HardwareID,"
 								  " A.AddjValue, A.AddjMulti, A.AddjValue2, A.AddjMulti2,"
@@ -8417,7 +8827,7 @@ namespace http
 								  rowid.c_str());
 				}
 				else if ((!planID.empty()) && (planID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_read("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 								  " A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 								  " A.nValue, A.sValue, A.LastUpdate, A.Favorite,"
 								  " A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8431,7 +8841,7 @@ namespace http
 								  " AND (B.DevSceneType==0) ORDER BY B.[Order]",
 								  planID.c_str());
 				else if ((!floorID.empty()) && (floorID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_read("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 								  " A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 								  " A.nValue, A.sValue, A.LastUpdate, A.Favorite,"
 								  " A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8451,11 +8861,11 @@ namespace http
 					if (!bDisplayHidden)
 					{
 						// Build a list of Hidden Devices
-						result = m_sql.safe_query("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
+						result = m_sql.safe_query_read("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
 						if (!result.empty())
 						{
 							std::string pID = result[0][0];
-							result = m_sql.safe_query("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q') AND (DevSceneType==0)", pID.c_str());
+							result = m_sql.safe_query_read("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q') AND (DevSceneType==0)", pID.c_str());
 							if (!result.empty())
 							{
 								for (const auto &r : result)
@@ -8488,7 +8898,7 @@ namespace http
 							   "WHERE (A.HardwareID == %q) "
 							   "ORDER BY ");
 						szQuery += szOrderBy;
-						result = m_sql.safe_query(szQuery.c_str(), hardwareid.c_str(), order.c_str());
+						result = m_sql.safe_query_read(szQuery.c_str(), hardwareid.c_str(), order.c_str());
 					}
 					else
 					{
@@ -8503,7 +8913,7 @@ namespace http
 							   "ON (B.DeviceRowID==a.ID) AND (B.DevSceneType==0) "
 							   "ORDER BY ");
 						szQuery += szOrderBy;
-						result = m_sql.safe_query(szQuery.c_str(), order.c_str());
+						result = m_sql.safe_query_read(szQuery.c_str(), order.c_str());
 					}
 				}
 			}
@@ -8517,7 +8927,7 @@ namespace http
 				if (!rowid.empty())
 				{
 					//_log.Log(LOG_STATUS, "Getting device with id: %s for user %lu", rowid.c_str(), m_users[iUser].ID);
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_read("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 								  " A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 								  " A.nValue, A.sValue, A.LastUpdate, B.Favorite,"
 								  " A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8532,7 +8942,7 @@ namespace http
 								  m_users[iUser].ID, rowid.c_str());
 				}
 				else if ((!planID.empty()) && (planID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_read("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 								  " A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 								  " A.nValue, A.sValue, A.LastUpdate, B.Favorite,"
 								  " A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8548,7 +8958,7 @@ namespace http
 								  "AND (B.SharedUserID==%lu) ORDER BY C.[Order]",
 								  planID.c_str(), m_users[iUser].ID);
 				else if ((!floorID.empty()) && (floorID != "0"))
-					result = m_sql.safe_query("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
+					result = m_sql.safe_query_read("SELECT A.ID, A.DeviceID, A.Unit, A.Name, A.Used,"
 								  " A.Type, A.SubType, A.SignalLevel, A.BatteryLevel,"
 								  " A.nValue, A.sValue, A.LastUpdate, B.Favorite,"
 								  " A.SwitchType, A.HardwareID, A.AddjValue,"
@@ -8568,11 +8978,11 @@ namespace http
 					if (!bDisplayHidden)
 					{
 						// Build a list of Hidden Devices
-						result = m_sql.safe_query("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
+						result = m_sql.safe_query_read("SELECT ID FROM Plans WHERE (Name=='$Hidden Devices')");
 						if (!result.empty())
 						{
 							std::string pID = result[0][0];
-							result = m_sql.safe_query("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q')  AND (DevSceneType==0)", pID.c_str());
+							result = m_sql.safe_query_read("SELECT DeviceRowID FROM DeviceToPlansMap WHERE (PlanID=='%q')  AND (DevSceneType==0)", pID.c_str());
 							if (!result.empty())
 							{
 								for (const auto &r : result)
@@ -8607,7 +9017,7 @@ namespace http
 						   "WHERE (B.DeviceRowID==A.ID)"
 						   " AND (B.SharedUserID==%lu) ORDER BY ");
 					szQuery += szOrderBy;
-					result = m_sql.safe_query(szQuery.c_str(), m_users[iUser].ID, order.c_str());
+					result = m_sql.safe_query_read(szQuery.c_str(), m_users[iUser].ID, order.c_str());
 				}
 			}
 
@@ -9036,7 +9446,7 @@ namespace http
 
 						bool bIsSubDevice = false;
 						std::vector<std::vector<std::string>> resultSD;
-						resultSD = m_sql.safe_query("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q')", sd[0].c_str());
+						resultSD = m_sql.safe_query_read("SELECT ID FROM LightSubDevices WHERE (DeviceRowID=='%q')", sd[0].c_str());
 						bIsSubDevice = (!resultSD.empty());
 
 						root["result"][ii]["IsSubDevice"] = bIsSubDevice;
@@ -9649,12 +10059,12 @@ namespace http
 
 							if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 							{
-								result2 = m_sql.safe_query("SELECT Total, Rate FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
+								result2 = m_sql.safe_query_read("SELECT Total, Rate FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY ROWID DESC LIMIT 1",
 											   sd[0].c_str(), szDate);
 							}
 							else
 							{
-								result2 = m_sql.safe_query("SELECT MIN(Total), MAX(Total) FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
+								result2 = m_sql.safe_query_read("SELECT MIN(Total), MAX(Total) FROM Rain WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
 							}
 
 							if (!result2.empty())
@@ -9723,7 +10133,7 @@ namespace http
 
 						std::vector<std::vector<std::string>> result2;
 						strcpy(szTmp, "0");
-						result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
+						result2 = m_sql.safe_query_read("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
 						if (!result2.empty())
 						{
 							std::vector<std::string> sd2 = result2[0];
@@ -9833,7 +10243,7 @@ namespace http
 
 						std::vector<std::vector<std::string>> result2;
 						strcpy(szTmp, "0");
-						result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
+						result2 = m_sql.safe_query_read("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
 						if (!result2.empty())
 						{
 							std::vector<std::string> sd2 = result2[0];
@@ -10011,7 +10421,7 @@ namespace http
 
 						std::vector<std::vector<std::string>> result2;
 						strcpy(szTmp, "0");
-						result2 = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
+						result2 = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
 						if (!result2.empty())
 						{
 							std::vector<std::string> sd2 = result2[0];
@@ -10202,7 +10612,7 @@ namespace http
 
 							std::vector<std::vector<std::string>> result2;
 							strcpy(szTmp, "0");
-							result2 = m_sql.safe_query("SELECT MIN(Value1), MIN(Value2), MIN(Value5), MIN(Value6) FROM MultiMeter WHERE (DeviceRowID='%q' AND Date>='%q')",
+							result2 = m_sql.safe_query_read("SELECT MIN(Value1), MIN(Value2), MIN(Value5), MIN(Value6) FROM MultiMeter WHERE (DeviceRowID='%q' AND Date>='%q')",
 										   sd[0].c_str(), szDate);
 							if (!result2.empty())
 							{
@@ -10248,7 +10658,7 @@ namespace http
 						float divider = m_sql.GetCounterDivider(int(metertype), int(dType), float(AddjValue2));
 
 						strcpy(szTmp, "0");
-						result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
+						result2 = m_sql.safe_query_read("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
 						if (!result2.empty())
 						{
 							std::vector<std::string> sd2 = result2[0];
@@ -10371,8 +10781,8 @@ namespace http
 							std::vector<std::vector<std::string>> result2;
 							strcpy(szTmp, "0");
 							// get the first value of the day instead of the minimum value, because counter can also decrease
-							// result2 = m_sql.safe_query("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')",
-							result2 = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
+							// result2 = m_sql.safe_query_read("SELECT MIN(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')",
+							result2 = m_sql.safe_query_read("SELECT Value FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q') ORDER BY Date LIMIT 1", sd[0].c_str(), szDate);
 							if (!result2.empty())
 							{
 								float divider = m_sql.GetCounterDivider(int(metertype), int(dType), float(AddjValue2));
@@ -10899,7 +11309,7 @@ namespace http
 
 								std::vector<std::vector<std::string>> result2;
 								strcpy(szTmp, "0");
-								result2 = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
+								result2 = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID='%q' AND Date>='%q')", sd[0].c_str(), szDate);
 								if (!result2.empty())
 								{
 									std::vector<std::string> sd2 = result2[0];
@@ -12035,6 +12445,7 @@ namespace http
 
 			m_sql.safe_query("UPDATE DeviceStatus SET Name='%q' WHERE (ID == %d)", sname.c_str(), idx);
 			uint64_t ullidx = std::strtoull(sidx.c_str(), nullptr, 10);
+			m_mainworker.m_devicestore.Refresh(ullidx);
 			m_mainworker.m_eventsystem.WWWUpdateSingleState(ullidx, sname, m_mainworker.m_eventsystem.REASON_DEVICE);
 
 #ifdef ENABLE_PYTHON
@@ -12085,6 +12496,7 @@ namespace http
 				m_sql.safe_query("UPDATE DeviceStatus SET Used=%d, Name='%q' WHERE (ID == %d)", bIsUsed ? 1 : 0, sName.c_str(), idx);
 			else
 				m_sql.safe_query("UPDATE DeviceStatus SET Used=%d WHERE (ID == %d)", bIsUsed ? 1 : 0, idx);
+			m_mainworker.m_devicestore.Refresh(idx);
 
 			root["status"] = "OK";
 			root["title"] = "SetDeviceUsed";
@@ -12529,6 +12941,7 @@ namespace http
 				if (dType != pTypeEvohomeZone && dType != pTypeEvohomeWater) // sql update now done in setsetpoint for evohome devices
 				{
 					m_sql.safe_query("UPDATE DeviceStatus SET Used=%d, sValue='%q' WHERE (ID == '%q')", used, szTmp, idx.c_str());
+					m_mainworker.m_devicestore.Refresh(std::strtoull(idx.c_str(), nullptr, 10));
 				}
 			}
 			if (name.empty())
@@ -12733,6 +13146,7 @@ namespace http
 			}
 			else
 			{
+				m_notifications.DeviceChanged(std::strtoull(idx.c_str(), nullptr, 10));
 #ifdef ENABLE_PYTHON
 				// Notify plugin framework about the change
 				m_mainworker.m_pluginsystem.DeviceModified(atoi(idx.c_str()));
@@ -12745,6 +13159,8 @@ namespace http
 			}
 			if (m_sql.m_bEnableEventSystem)
 				m_mainworker.m_eventsystem.GetCurrentStates();
+			else
+				m_mainworker.m_devicestore.Refresh(std::strtoull(idx.c_str(), nullptr, 10));
 		}
 
 		void CWebServer::RType_Settings(WebEmSession &session, const request &req, Json::Value &root)
@@ -13042,6 +13458,10 @@ namespace http
 				{
 					root["SecOnDelay"] = nValue;
 				}
+				else if (Key == "CameraSnapshotMaxAge")
+				{
+					root["CameraSnapshotMaxAge"] = nValue;
+				}
 				else if (Key == "AllowWidgetOrdering")
 				{
 					root["AllowWidgetOrdering"] = nValue;
@@ -13332,6 +13752,94 @@ namespace http
 		}
 
 		void CWebServer::RType_HandleGraph(WebEmSession &session, const request &req, Json::Value &root)
+		{
+			// Calendar ranges only change on rollup, short log samples of this device, data deletion or device/settings changes
+			std::string srange = request::findValue(&req, "range");
+			std::string sCacheKey;
+			if ((srange == "month") || (srange == "year") || !request::findValue(&req, "groupby").empty())
+				sCacheKey = GetGraphCacheKey(req);
+			const uint64_t generation = m_sql.GetHistoryGeneration(std::strtoull(request::findValue(&req, "idx").c_str(), nullptr, 10));
+			if (!sCacheKey.empty() && GetCachedGraph(sCacheKey, generation, root))
+				return;
+
+			RType_HandleGraphData(session, req, root);
+
+			// Optional server side downsampling, charts can not show more points than they have pixels anyway
+			int maxPoints = atoi(request::findValue(&req, "maxpoints").c_str());
+			if ((maxPoints > 0) && root.isMember("result"))
+				DownsampleGraph(root["result"], (size_t)maxPoints);
+
+			if (!sCacheKey.empty() && (root["status"].asString() == "OK"))
+				StoreCachedGraph(sCacheKey, generation, root);
+		}
+
+		std::string CWebServer::GetGraphCacheKey(const request &req)
+		{
+			uint64_t idx = std::strtoull(request::findValue(&req, "idx").c_str(), nullptr, 10);
+			std::vector<std::vector<std::string>> result;
+			result = m_sql.safe_query_read("SELECT Type, SubType, SwitchType, AddjValue, AddjMulti, AddjValue2, Options FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
+			if (result.empty())
+				return "";
+
+			time_t now = mytime(nullptr);
+			struct tm ltime;
+			localtime_r(&now, &ltime);
+			std::string sKey = std_format("%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
+			for (const char *szParam : { "idx", "sensor", "sensorarea", "range", "groupby", "actmonth", "actyear", "maxpoints" })
+				sKey += "|" + request::findValue(&req, szParam);
+
+			// device settings that affect dividers and adjustments, today's values follow the short log generation
+			for (const auto &sValue : result[0])
+				sKey += "|" + sValue;
+			return sKey;
+		}
+
+		bool CWebServer::GetCachedGraph(const std::string &key, const uint64_t generation, Json::Value &root)
+		{
+			std::lock_guard<std::mutex> l(m_graphCacheMutex);
+			auto itt = m_graphCacheIndex.find(key);
+			if (itt == m_graphCacheIndex.end())
+				return false;
+			if (itt->second->generation != generation)
+			{
+				m_graphCachePoints -= itt->second->points;
+				m_graphCache.erase(itt->second);
+				m_graphCacheIndex.erase(itt);
+				return false;
+			}
+			m_graphCache.splice(m_graphCache.begin(), m_graphCache, itt->second);
+			root = *m_graphCache.front().root;
+			return true;
+		}
+
+		void CWebServer::StoreCachedGraph(const std::string &key, const uint64_t generation, const Json::Value &root)
+		{
+			const size_t points = root.isMember("result") ? root["result"].size() + 1 : 1;
+			if (points > GRAPH_CACHE_MAX_POINTS / 4)
+				return;
+
+			std::lock_guard<std::mutex> l(m_graphCacheMutex);
+			auto itt = m_graphCacheIndex.find(key);
+			if (itt != m_graphCacheIndex.end())
+			{
+				m_graphCachePoints -= itt->second->points;
+				m_graphCache.erase(itt->second);
+				m_graphCacheIndex.erase(itt);
+			}
+			m_graphCache.push_front({ key, generation, points, std::make_shared<Json::Value>(root) });
+			m_graphCacheIndex[key] = m_graphCache.begin();
+			m_graphCachePoints += points;
+
+			while (m_graphCachePoints > GRAPH_CACHE_MAX_POINTS)
+			{
+				const auto &oldest = m_graphCache.back();
+				m_graphCachePoints -= oldest.points;
+				m_graphCacheIndex.erase(oldest.key);
+				m_graphCache.pop_back();
+			}
+		}
+
+		void CWebServer::RType_HandleGraphData(WebEmSession &session, const request &req, Json::Value &root)
 		{
 			uint64_t idx = 0;
 			if (!request::findValue(&req, "idx").empty())
@@ -13355,7 +13863,7 @@ namespace http
 			struct tm tm1;
 			localtime_r(&now, &tm1);
 
-			result = m_sql.safe_query("SELECT Type, SubType, SwitchType, AddjValue, AddjMulti, AddjValue2, Options FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
+			result = m_sql.safe_query_read("SELECT Type, SubType, SwitchType, AddjValue, AddjMulti, AddjValue2, Options FROM DeviceStatus WHERE (ID == %" PRIu64 ")", idx);
 			if (result.empty())
 				return;
 
@@ -13453,7 +13961,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Temperature, Chill, Humidity, Barometer, Date, SetPoint FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC",
+					result = m_sql.safe_query_read("SELECT Temperature, Chill, Humidity, Barometer, Date, SetPoint FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC",
 								  dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
@@ -13517,7 +14025,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Percentage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_read("SELECT Percentage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -13534,7 +14042,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Speed, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_read("SELECT Speed, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -13554,7 +14062,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1, Value2, Value3, Value4, Value5, Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value1, Value2, Value3, Value4, Value5, Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC",
 									  dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
@@ -13666,7 +14174,7 @@ namespace http
 											int day = ltime.tm_mday;
 											sprintf(szTmp, "%04d-%02d-%02d", year, mon, day);
 											std::vector<std::vector<std::string>> result2;
-											result2 = m_sql.safe_query(
+											result2 = m_sql.safe_query_read(
 												"SELECT Counter1, Counter2, Counter3, Counter4 FROM Multimeter_Calendar WHERE (DeviceRowID==%" PRIu64
 												") AND (Date=='%q')",
 												idx, szTmp);
@@ -13710,7 +14218,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13727,7 +14235,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13751,7 +14259,7 @@ namespace http
 						{
 							vdiv = 1000.0F;
 						}
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13782,7 +14290,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13799,7 +14307,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13816,7 +14324,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13834,7 +14342,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13859,7 +14367,7 @@ namespace http
 
 						root["displaytype"] = displaytype;
 
-						result = m_sql.safe_query("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13929,7 +14437,7 @@ namespace http
 
 						root["displaytype"] = displaytype;
 
-						result = m_sql.safe_query("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value1, Value2, Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							int ii = 0;
@@ -13995,7 +14503,7 @@ namespace http
 
 						// First check if we had any usage in the short log, if not, its probably a meter without usage
 						bool bHaveUsage = true;
-						result = m_sql.safe_query("SELECT MIN([Usage]), MAX([Usage]) FROM %s WHERE (DeviceRowID==%" PRIu64 ")", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT MIN([Usage]), MAX([Usage]) FROM %s WHERE (DeviceRowID==%" PRIu64 ")", dbasetable.c_str(), idx);
 						if (!result.empty())
 						{
 							long long minValue = std::strtoll(result[0][0].c_str(), nullptr, 10);
@@ -14008,7 +14516,7 @@ namespace http
 						}
 
 						int ii = 0;
-						result = m_sql.safe_query("SELECT Value,[Usage], Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+						result = m_sql.safe_query_read("SELECT Value,[Usage], Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 
 						int method = 0;
 						std::string sMethod = request::findValue(&req, "method");
@@ -14156,13 +14664,13 @@ namespace http
 
 						if (bIsManagedCounter)
 						{
-							result = m_sql.safe_query("SELECT Usage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+							result = m_sql.safe_query_read("SELECT Usage, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 							bHaveFirstValue = true;
 							bHaveFirstRealValue = true;
 						}
 						else
 						{
-							result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+							result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 						}
 
 						int method = 0;
@@ -14339,7 +14847,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_read("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -14362,7 +14870,7 @@ namespace http
 					float LastValue = -1;
 					std::string LastDate;
 
-					result = m_sql.safe_query("SELECT Total, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_read("SELECT Total, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -14408,7 +14916,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Direction, Speed, Gust, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_read("SELECT Direction, Speed, Gust, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						int ii = 0;
@@ -14445,7 +14953,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Direction, Speed, Gust FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY Date ASC", dbasetable.c_str(), idx);
+					result = m_sql.safe_query_read("SELECT Direction, Speed, Gust FROM %s WHERE (DeviceRowID==%" PRIu64 ") ORDER BY ts ASC", dbasetable.c_str(), idx);
 					if (!result.empty())
 					{
 						std::map<int, int> _directions;
@@ -14701,7 +15209,7 @@ namespace http
 					getNoon(weekbefore, tm2, tm1.tm_year + 1900, tm1.tm_mon + 1, tm1.tm_mday - 7); // We only want the date
 					sprintf(szDateStart, "%04d-%02d-%02d", tm2.tm_year + 1900, tm2.tm_mon + 1, tm2.tm_mday);
 
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_read("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -14719,12 +15227,12 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query_read("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
 									  szDateEnd);
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					}
 					if (!result.empty())
 					{
@@ -14770,7 +15278,7 @@ namespace http
 					int ii = 0;
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6,Date FROM %s WHERE (DeviceRowID==%" PRIu64
+						result = m_sql.safe_query_read("SELECT Value1,Value2,Value5,Value6,Date FROM %s WHERE (DeviceRowID==%" PRIu64
 									  " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
@@ -14812,7 +15320,7 @@ namespace http
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -14851,7 +15359,7 @@ namespace http
 					// add today (have to calculate it)
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value1), MAX(Value1), MIN(Value2), MAX(Value2),MIN(Value5), MAX(Value5), MIN(Value6), MAX(Value6) FROM "
+						result = m_sql.safe_query_read("SELECT MIN(Value1), MAX(Value1), MIN(Value2), MAX(Value2),MIN(Value5), MAX(Value5), MIN(Value6), MAX(Value6) FROM "
 									  "MultiMeter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')",
 									  idx, szDateEnd);
 						if (!result.empty())
@@ -14909,7 +15417,7 @@ namespace http
 					else if (!bIsManagedCounter)
 					{
 						// get the first value of the day
-						result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC LIMIT 1", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC LIMIT 1", idx, szDateEnd);
 						if (!result.empty())
 						{
 							std::vector<std::string> sd = result[0];
@@ -14919,7 +15427,7 @@ namespace http
 							unsigned long long total_real;
 
 							// get the last value of the day
-							result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx, szDateEnd);
+							result = m_sql.safe_query_read("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx, szDateEnd);
 							if (!result.empty())
 							{
 								std::vector<std::string> sd = result[0];
@@ -15023,7 +15531,7 @@ namespace http
 					root["title"] = "Graph " + sensor + " " + srange;
 
 					// Actual Year
-					result = m_sql.safe_query("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
+					result = m_sql.safe_query_read("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
 								  " Humidity, Barometer, Temp_Avg, Date, SetPoint_Min,"
 								  " SetPoint_Max, SetPoint_Avg "
 								  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
@@ -15104,7 +15612,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MIN(Temperature), MAX(Temperature),"
+					result = m_sql.safe_query_read("SELECT MIN(Temperature), MAX(Temperature),"
 								  " MIN(Chill), MAX(Chill), AVG(Humidity),"
 								  " AVG(Barometer), AVG(Temperature), MIN(SetPoint),"
 								  " MAX(SetPoint), AVG(SetPoint) "
@@ -15175,7 +15683,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
+					result = m_sql.safe_query_read("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
 								  " Humidity, Barometer, Temp_Avg, Date, SetPoint_Min,"
 								  " SetPoint_Max, SetPoint_Avg "
 								  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
@@ -15261,7 +15769,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Percentage_Min, Percentage_Max, Percentage_Avg, Date FROM %s WHERE (DeviceRowID==%" PRIu64
+					result = m_sql.safe_query_read("SELECT Percentage_Min, Percentage_Max, Percentage_Avg, Date FROM %s WHERE (DeviceRowID==%" PRIu64
 								  " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
@@ -15277,7 +15785,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MIN(Percentage), MAX(Percentage), AVG(Percentage) FROM Percentage WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx,
+					result = m_sql.safe_query_read("SELECT MIN(Percentage), MAX(Percentage), AVG(Percentage) FROM Percentage WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx,
 								  szDateEnd);
 					if (!result.empty())
 					{
@@ -15294,7 +15802,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Speed_Min, Speed_Max, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_read("SELECT Speed_Min, Speed_Max, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -15308,7 +15816,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MIN(Speed), MAX(Speed) FROM Fan WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+					result = m_sql.safe_query_read("SELECT MIN(Speed), MAX(Speed) FROM Fan WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -15323,7 +15831,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
+					result = m_sql.safe_query_read("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
 								  idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -15336,7 +15844,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MAX(Level) FROM UV WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+					result = m_sql.safe_query_read("SELECT MAX(Level) FROM UV WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -15346,7 +15854,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
+					result = m_sql.safe_query_read("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC", dbasetable.c_str(),
 								  idx, szDateStartPrev, szDateEndPrev);
 					if (!result.empty())
 					{
@@ -15364,7 +15872,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_read("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 					int ii = 0;
 					if (!result.empty())
@@ -15382,12 +15890,12 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query_read("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
 									  szDateEnd);
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 					}
 					if (!result.empty())
 					{
@@ -15413,7 +15921,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+					result = m_sql.safe_query_read("SELECT Total, Rate, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								  dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 					if (!result.empty())
 					{
@@ -15439,7 +15947,7 @@ namespace http
 					// int nValue = 0;
 					std::string sValue;
 
-					result = m_sql.safe_query("SELECT nValue, sValue FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
+					result = m_sql.safe_query_read("SELECT nValue, sValue FROM DeviceStatus WHERE (ID==%" PRIu64 ")", idx);
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -15498,7 +16006,7 @@ namespace http
 						else
 						{
 							// Actual Year
-							result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6, Date,"
+							result = m_sql.safe_query_read("SELECT Value1,Value2,Value5,Value6, Date,"
 										  " Counter1, Counter2, Counter3, Counter4 "
 										  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 										  " AND Date<='%q') ORDER BY Date ASC",
@@ -15584,7 +16092,7 @@ namespace http
 								}
 							}
 							// Previous Year
-							result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6, Date "
+							result = m_sql.safe_query_read("SELECT Value1,Value2,Value5,Value6, Date "
 										  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 										  dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 							if (!result.empty())
@@ -15626,7 +16134,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -15639,7 +16147,7 @@ namespace http
 								ii++;
 							}
 						}
-						result = m_sql.safe_query("SELECT Value2,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value2,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 						if (!result.empty())
 						{
@@ -15658,7 +16166,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -15685,7 +16193,7 @@ namespace http
 							vdiv = 1000.0F;
 						}
 
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value1,Value2,Value3,Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -15744,7 +16252,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value1,Value2,Value3, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -15763,7 +16271,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -15783,7 +16291,7 @@ namespace http
 						root["status"] = "OK";
 						root["title"] = "Graph " + sensor + " " + srange;
 
-						result = m_sql.safe_query("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value1,Value2, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
 						{
@@ -15798,7 +16306,7 @@ namespace http
 					}
 					else if (dType == pTypeCURRENT)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
+						result = m_sql.safe_query_read("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
 									  " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
@@ -15882,7 +16390,7 @@ namespace http
 					}
 					else if (dType == pTypeCURRENTENERGY)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
+						result = m_sql.safe_query_read("SELECT Value1,Value2,Value3,Value4,Value5,Value6, Date FROM %s WHERE (DeviceRowID==%" PRIu64
 									  " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart, szDateEnd);
 						if (!result.empty())
@@ -16081,7 +16589,7 @@ namespace http
 						{
 							// Actual Year
 							result =
-								m_sql.safe_query("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+								m_sql.safe_query_read("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 										 dbasetable.c_str(), idx, szDateStart, szDateEnd);
 							if (!result.empty())
 							{
@@ -16138,7 +16646,7 @@ namespace http
 							}
 							// Past Year
 							result =
-								m_sql.safe_query("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+								m_sql.safe_query_read("SELECT Value, Date, Counter FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 										 dbasetable.c_str(), idx, szDateStartPrev, szDateEndPrev);
 							if (!result.empty())
 							{
@@ -16200,7 +16708,7 @@ namespace http
 
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT "
+						result = m_sql.safe_query_read("SELECT "
 									  " MIN(Value1) as levering_laag_min,"
 									  " MAX(Value1) as levering_laag_max,"
 									  " MIN(Value2) as teruglevering_laag_min,"
@@ -16287,7 +16795,7 @@ namespace http
 					}
 					else if (dType == pTypeAirQuality)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16300,7 +16808,7 @@ namespace http
 					else if (((dType == pTypeGeneral) && ((dSubType == sTypeSoilMoisture) || (dSubType == sTypeLeafWetness))) ||
 						 ((dType == pTypeRFXSensor) && ((dSubType == sTypeRFXSensorAD) || (dSubType == sTypeRFXSensorVolt))))
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16320,7 +16828,7 @@ namespace http
 							vdiv = 1000.0F;
 						}
 
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16361,7 +16869,7 @@ namespace http
 					}
 					else if (dType == pTypeLux)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value), AVG(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16373,7 +16881,7 @@ namespace http
 					}
 					else if (dType == pTypeWEIGHT)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16386,7 +16894,7 @@ namespace http
 					}
 					else if (dType == pTypeUsage)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
+						result = m_sql.safe_query_read("SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')", idx, szDateEnd);
 						if (!result.empty())
 						{
 							root["result"][ii]["d"] = szDateEnd;
@@ -16402,7 +16910,7 @@ namespace http
 						} else*/
 						{
 							// get the first value
-							result = m_sql.safe_query(
+							result = m_sql.safe_query_read(
 								//"SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')",
 								"SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC LIMIT 1", idx, szDateEnd);
 							if (!result.empty())
@@ -16413,7 +16921,7 @@ namespace http
 								unsigned long long total_real;
 
 								// Get the last value
-								result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
+								result = m_sql.safe_query_read("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
 											  szDateEnd);
 								if (!result.empty())
 								{
@@ -16503,7 +17011,7 @@ namespace http
 
 					int ii = 0;
 
-					result = m_sql.safe_query("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
+					result = m_sql.safe_query_read("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
 								  " Gust_Max, Date "
 								  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 								  " AND Date<='%q') ORDER BY Date ASC",
@@ -16537,7 +17045,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT AVG(Direction), MIN(Speed), MAX(Speed),"
+					result = m_sql.safe_query_read("SELECT AVG(Direction), MIN(Speed), MAX(Speed),"
 								  " MIN(Gust), MAX(Gust) "
 								  "FROM Wind WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC",
 								  idx, szDateEnd);
@@ -16569,7 +17077,7 @@ namespace http
 						ii++;
 					}
 					// Previous Year
-					result = m_sql.safe_query("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
+					result = m_sql.safe_query_read("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
 								  " Gust_Max, Date "
 								  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 								  " AND Date<='%q') ORDER BY Date ASC",
@@ -16661,7 +17169,7 @@ namespace http
 					if (sgraphtype == "1")
 					{
 						// Need to get all values of the end date so 23:59:59 is appended to the date string
-						result = m_sql.safe_query("SELECT Temperature, Chill, Humidity, Barometer,"
+						result = m_sql.safe_query_read("SELECT Temperature, Chill, Humidity, Barometer,"
 									  " Date, DewPoint, SetPoint "
 									  "FROM Temperature WHERE (DeviceRowID==%" PRIu64 ""
 									  " AND Date>='%q' AND Date<='%q 23:59:59') ORDER BY Date ASC",
@@ -16729,7 +17237,7 @@ namespace http
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
+						result = m_sql.safe_query_read("SELECT Temp_Min, Temp_Max, Chill_Min, Chill_Max,"
 									  " Humidity, Barometer, Date, DewPoint, Temp_Avg,"
 									  " SetPoint_Min, SetPoint_Max, SetPoint_Avg "
 									  "FROM Temperature_Calendar "
@@ -16809,7 +17317,7 @@ namespace http
 						}
 
 						// add today (have to calculate it)
-						result = m_sql.safe_query("SELECT MIN(Temperature), MAX(Temperature),"
+						result = m_sql.safe_query_read("SELECT MIN(Temperature), MAX(Temperature),"
 									  " MIN(Chill), MAX(Chill), AVG(Humidity),"
 									  " AVG(Barometer), MIN(DewPoint), AVG(Temperature),"
 									  " MIN(SetPoint), MAX(SetPoint), AVG(SetPoint) "
@@ -16888,7 +17396,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ""
+					result = m_sql.safe_query_read("SELECT Level, Date FROM %s WHERE (DeviceRowID==%" PRIu64 ""
 								  " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								  dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
 					int ii = 0;
@@ -16902,7 +17410,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT MAX(Level) FROM UV WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
+					result = m_sql.safe_query_read("SELECT MAX(Level) FROM UV WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
 					if (!result.empty())
 					{
 						std::vector<std::string> sd = result[0];
@@ -16917,7 +17425,7 @@ namespace http
 					root["status"] = "OK";
 					root["title"] = "Graph " + sensor + " " + srange;
 
-					result = m_sql.safe_query("SELECT Total, Rate, Date FROM %s "
+					result = m_sql.safe_query_read("SELECT Total, Rate, Date FROM %s "
 								  "WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 								  dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
 					int ii = 0;
@@ -16933,12 +17441,12 @@ namespace http
 					// add today (have to calculate it)
 					if (dSubType == sTypeRAINWU || dSubType == sTypeRAINByRate)
 					{
-						result = m_sql.safe_query("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
+						result = m_sql.safe_query_read("SELECT Total, Total, Rate FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY ROWID DESC LIMIT 1", idx,
 									  szDateEnd.c_str());
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
+						result = m_sql.safe_query_read("SELECT MIN(Total), MAX(Total), MAX(Rate) FROM Rain WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')", idx, szDateEnd.c_str());
 					}
 					if (!result.empty())
 					{
@@ -16973,7 +17481,7 @@ namespace http
 					int ii = 0;
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT Value1,Value2,Value5,Value6, Date "
+						result = m_sql.safe_query_read("SELECT Value1,Value2,Value5,Value6, Date "
 									  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 									  " AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
@@ -17008,7 +17516,7 @@ namespace http
 					}
 					else
 					{
-						result = m_sql.safe_query("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
+						result = m_sql.safe_query_read("SELECT Value, Date FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q' AND Date<='%q') ORDER BY Date ASC",
 									  dbasetable.c_str(), idx, szDateStart.c_str(), szDateEnd.c_str());
 						if (!result.empty())
 						{
@@ -17040,7 +17548,7 @@ namespace http
 					// add today (have to calculate it)
 					if (dType == pTypeP1Power)
 					{
-						result = m_sql.safe_query("SELECT MIN(Value1), MAX(Value1), MIN(Value2),"
+						result = m_sql.safe_query_read("SELECT MIN(Value1), MAX(Value1), MIN(Value2),"
 									  " MAX(Value2),MIN(Value5), MAX(Value5),"
 									  " MIN(Value6), MAX(Value6) "
 									  "FROM MultiMeter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')",
@@ -17087,7 +17595,7 @@ namespace http
 					}
 					else if (!bIsManagedCounter)
 					{ // get the first value of the day
-						result = m_sql.safe_query(
+						result = m_sql.safe_query_read(
 							//"SELECT MIN(Value), MAX(Value) FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q')",
 							"SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date ASC LIMIT 1", idx, szDateEnd.c_str());
 						if (!result.empty())
@@ -17098,7 +17606,7 @@ namespace http
 							unsigned long long total_real;
 
 							// get the last value of the day
-							result = m_sql.safe_query("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
+							result = m_sql.safe_query_read("SELECT Value FROM Meter WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q') ORDER BY Date DESC LIMIT 1", idx,
 										  szDateEnd.c_str());
 							if (!result.empty())
 							{
@@ -17140,7 +17648,7 @@ namespace http
 
 					int ii = 0;
 
-					result = m_sql.safe_query("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
+					result = m_sql.safe_query_read("SELECT Direction, Speed_Min, Speed_Max, Gust_Min,"
 								  " Gust_Max, Date "
 								  "FROM %s WHERE (DeviceRowID==%" PRIu64 " AND Date>='%q'"
 								  " AND Date<='%q') ORDER BY Date ASC",
@@ -17174,7 +17682,7 @@ namespace http
 						}
 					}
 					// add today (have to calculate it)
-					result = m_sql.safe_query("SELECT AVG(Direction), MIN(Speed), MAX(Speed), MIN(Gust), MAX(Gust) FROM Wind WHERE (DeviceRowID==%" PRIu64
+					result = m_sql.safe_query_read("SELECT AVG(Direction), MIN(Speed), MAX(Speed), MIN(Gust), MAX(Gust) FROM Wind WHERE (DeviceRowID==%" PRIu64
 								  " AND Date>='%q') ORDER BY Date ASC",
 								  idx, szDateEnd.c_str());
 					if (!result.empty())
@@ -17250,8 +17758,8 @@ namespace http
 					 std::function<std::string(std::string)> value, std::function<std::string(double)> sumToResult)
 		{
 			/*
-			 * This query selects all records (in mc0) that belong to DeviceRowID, each with the record before it (in mc1), and calculates for each record
-			 * the "usage" by subtracting the previous counter from its counter.
+			 * This selects all records that belong to DeviceRowID in date order, and calculates for each record the "usage" by subtracting the previous
+			 * counter from its counter, in a single pass over the rows.
 			 * - It does not take into account records that have a 0-valued counter, to prevent one falling between two categories, which would cause the
 			 *   value for one category to be extremely low and the value for the other extremely high.
 			 * - When the previous counter is greater than its counter, assumed is that a meter change has taken place; the previous counter is ignored
@@ -17260,46 +17768,54 @@ namespace http
 			 *   records for some days are not recorded or sometimes disappear, hence values would be missing and that would result in an incomplete total.
 			 *   Plus it seems that the value is not always the same as the difference between the counters. Counters are more often reliable.
 			 */
-			std::vector<std::vector<std::string>> result = m_sql.safe_query(
-				(std::string("") + " select" + "  strftime('%%Y',Date) as Year," + "  sum(Difference) as Sum" +
-				 (sgroupby == "quarter" ? std::string("") + ",case" + "   when cast(strftime('%%m',Date) as integer) between 1 and 3 then 'Q1'" +
-								  "   when cast(strftime('%%m',Date) as integer) between 4 and 6 then 'Q2'" +
-								  "   when cast(strftime('%%m',Date) as integer) between 7 and 9 then 'Q3'" +
-								  "                                                              else 'Q4'" + "   end as Quarter"
-				  : sgroupby == "month" ? ",strftime('%%m',Date) as Month"
-							: "") +
-				 " from (" + " 	select" + "         mc0.DeviceRowID," + "         date(mc0.Date) as Date," + "         case when (" + counter("mc1") + ") <= (" + counter("mc0") +
-				 ") then (" + counter("mc0") + ") - (" + counter("mc1") + ") else (" + value("mc0") + ") end as Difference" + " 	from " + dbasetable + " mc0" + " 	inner join " +
-				 dbasetable + " mc1 on mc1.DeviceRowID = mc0.DeviceRowID" + "         and mc1.Date = (select max(mcm.Date) from " + dbasetable +
-				 " mcm where mcm.DeviceRowID = mc0.DeviceRowID and mcm.Date < mc0.Date and (" + counter("mcm") + ") <> 0)" + " 	where" + "         mc0.DeviceRowID = %" PRIu64 "" +
-				 "         and (" + counter("mc0") + ") <> 0" + "         and (select min(Date) from " + dbasetable + " where DeviceRowID = %" PRIu64 " and (" + counter("") +
-				 ") <> 0) <= mc1.Date" + "         and mc0.Date <= (select max(Date) from " + dbasetable + " where DeviceRowID = %" PRIu64 " and (" + counter("") + ") <> 0)" + " )" +
-				 " group by strftime('%%Y',Date)" +
-				 (sgroupby == "quarter" ? std::string("") + ",case" + "   when cast(strftime('%%m',Date) as integer) between 1 and 3 then 'Q1'" +
-								  "   when cast(strftime('%%m',Date) as integer) between 4 and 6 then 'Q2'" +
-								  "   when cast(strftime('%%m',Date) as integer) between 7 and 9 then 'Q3'" +
-								  "                                                              else 'Q4'" + "   end"
-				  : sgroupby == "month" ? ",strftime('%%m',Date)"
-							: "") +
-				 " order by 1 asc" + (sgroupby == "quarter" || sgroupby == "month" ? ", 3 asc" : ""))
+			std::vector<std::vector<std::string>> rows = m_sql.safe_query_read(
+				("SELECT date(Date), (" + counter("") + "), (" + value("") + ") FROM " + dbasetable + " WHERE (DeviceRowID==%" PRIu64 ") AND ((" + counter("") +
+				 ") <> 0) ORDER BY Date ASC")
 					.c_str(),
-				idx, idx, idx);
-			if (!result.empty())
+				idx);
+
+			// (year, category) -> sum of differences, ordered like the result
+			std::map<std::pair<std::string, std::string>, double> sums;
+			bool bHavePrevious = false;
+			double fPreviousCounter = 0;
+			for (const auto &sd : rows)
+			{
+				const double fCounter = atof(sd[1].c_str());
+				if (bHavePrevious && (sd[0].size() >= 10))
+				{
+					const double fDifference = (fPreviousCounter <= fCounter) ? fCounter - fPreviousCounter : atof(sd[2].c_str());
+					std::string sYear = sd[0].substr(0, 4);
+					std::string sCategory;
+					if (sgroupby == "quarter")
+					{
+						int month = atoi(sd[0].substr(5, 2).c_str());
+						sCategory = (month <= 3) ? "Q1" : (month <= 6) ? "Q2" : (month <= 9) ? "Q3" : "Q4";
+					}
+					else if (sgroupby == "month")
+						sCategory = sd[0].substr(5, 2);
+					sums[std::make_pair(sYear, sCategory)] += fDifference;
+				}
+				fPreviousCounter = fCounter;
+				bHavePrevious = true;
+			}
+
+			if (!sums.empty())
 			{
 				int firstYearCounting = 0;
 				double fsumPrevious;
-				for (const auto &sd : result)
+				for (const auto &itt : sums)
 				{
-					const int year = atoi(sd[0].c_str());
-					const double fsum = atof(sd[1].c_str());
+					const std::string &sYear = itt.first.first;
+					const int year = atoi(sYear.c_str());
+					const double fsum = itt.second;
 					const char *trend = firstYearCounting == 0 ? "" : fsumPrevious < fsum ? "up" : fsumPrevious > fsum ? "down" : "equal";
 					const int ii = root["result"].size();
 					if (firstYearCounting == 0 || year < firstYearCounting)
 					{
 						firstYearCounting = year;
 					}
-					root["result"][ii]["y"] = sd[0];
-					root["result"][ii]["c"] = sgroupby == "year" ? sd[0] : sd[2];
+					root["result"][ii]["y"] = sYear;
+					root["result"][ii]["c"] = sgroupby == "year" ? sYear : itt.first.second;
 					root["result"][ii]["s"] = sumToResult(fsum);
 					root["result"][ii]["t"] = trend;
 					fsumPrevious = fsum;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <list>
 #include "../webserver/cWebem.h"
 #include "../webserver/request.hpp"
 #include "../webserver/session_store.hpp"
@@ -43,6 +44,7 @@ class CWebServer : public session_store, public std::enable_shared_from_this<CWe
 	void GetJSonPage(WebEmSession & session, const request& req, reply & rep);
 	void GetAppCache(WebEmSession & session, const request& req, reply & rep);
 	void GetCameraSnapshot(WebEmSession & session, const request& req, reply & rep);
+	void GetMetrics(WebEmSession &session, const request &req, reply &rep);
 	void GetInternalCameraSnapshot(WebEmSession & session, const request& req, reply & rep);
 	void GetFloorplanImage(WebEmSession & session, const request& req, reply & rep);
 	void GetDatabaseBackup(WebEmSession & session, const request& req, reply & rep);
@@ -102,6 +104,22 @@ private:
 
 	bool IsIdxForUser(const WebEmSession *pSession, int Idx);
 
+	struct _tDeviceUpdate
+	{
+		std::string idx;
+		std::string hid;
+		std::string did;
+		std::string dunit;
+		std::string dtype;
+		std::string dsubtype;
+		std::string nvalue;
+		std::string svalue;
+		std::string rssi;
+		std::string battery;
+		bool parseTrigger = true;
+	};
+	std::string ApplyDeviceUpdate(_tDeviceUpdate &update, const std::string &szUpdateUser);
+
 	//Commands
 	void Cmd_RFXComGetFirmwarePercentage(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_GetLanguage(WebEmSession & session, const request& req, Json::Value &root);
@@ -186,6 +204,7 @@ private:
 	void Cmd_EmailCameraSnapshot(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_UpdateDevice(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_UpdateDevices(WebEmSession & session, const request& req, Json::Value &root);
+	void Cmd_UpdateDeviceBulk(WebEmSession &session, const request &req, Json::Value &root);
 	void Cmd_SetThermostatState(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_SystemShutdown(WebEmSession & session, const request& req, Json::Value &root);
 	void Cmd_SystemReboot(WebEmSession & session, const request& req, Json::Value &root);
@@ -293,6 +312,7 @@ private:
 
 	//RTypes
 	void RType_HandleGraph(WebEmSession & session, const request& req, Json::Value &root);
+	void RType_HandleGraphData(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_LightLog(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_TextLog(WebEmSession & session, const request& req, Json::Value &root);
 	void RType_SceneLog(WebEmSession & session, const request& req, Json::Value &root);
@@ -386,6 +406,22 @@ private:
 	std::map<int, int> m_custom_light_icons_lookup;
 	bool m_bDoStop;
 	std::string m_server_alias;
+
+	// LRU cache of calendar range graph responses
+	struct _tGraphCacheEntry
+	{
+		std::string key;
+		uint64_t generation;
+		size_t points;
+		std::shared_ptr<Json::Value> root;
+	};
+	std::mutex m_graphCacheMutex;
+	std::list<_tGraphCacheEntry> m_graphCache; // most recently used first
+	std::map<std::string, std::list<_tGraphCacheEntry>::iterator> m_graphCacheIndex;
+	size_t m_graphCachePoints = 0;
+	std::string GetGraphCacheKey(const request &req);
+	bool GetCachedGraph(const std::string &key, uint64_t generation, Json::Value &root);
+	void StoreCachedGraph(const std::string &key, uint64_t generation, const Json::Value &root);
 };
 
 	} // namespace server
@@ -47,6 +47,12 @@ void CdzVents::EvaluateDzVents(lua_State *lua_state, const std::vector<CEventSys
 	lua_pushcfunction(lua_state, l_domoticz_print);
 	lua_setglobal(lua_state, "print");
 
+	// persistent script data lives in the database, see EventHelpers.getStorageContext
+	lua_pushcfunction(lua_state, l_dzvents_data_load);
+	lua_setglobal(lua_state, "dzVents_dataLoad");
+	lua_pushcfunction(lua_state, l_dzvents_data_store);
+	lua_setglobal(lua_state, "dzVents_dataStore");
+
 	bool reasonTime = false;
 	bool reasonURL = false;
 	bool reasonShellCommand = false;
@@ -736,6 +742,115 @@ int CdzVents::l_domoticz_print(lua_State* lua_state)
 	return 0;
 }
 
+// dzVents_dataLoad(module) returns a table with the serialized value of each stored variable,
+// and a table with the { sequence, serialized entry } pairs of each history variable, youngest first
+int CdzVents::l_dzvents_data_load(lua_State *lua_state)
+{
+	if (!lua_isstring(lua_state, 1))
+		return luaL_error(lua_state, "dzVents_dataLoad: module name expected");
+
+	std::vector<std::pair<std::string, std::string>> values;
+	std::map<std::string, std::vector<std::pair<int64_t, std::string>>> history;
+	m_sql.GetDzVentsData(lua_tostring(lua_state, 1), values, history);
+
+	lua_createtable(lua_state, 0, (int)values.size());
+	for (const auto &itt : values)
+	{
+		lua_pushlstring(lua_state, itt.first.c_str(), itt.first.size());
+		lua_pushlstring(lua_state, itt.second.c_str(), itt.second.size());
+		lua_rawset(lua_state, -3);
+	}
+
+	lua_createtable(lua_state, 0, (int)history.size());
+	for (const auto &itt : history)
+	{
+		lua_pushlstring(lua_state, itt.first.c_str(), itt.first.size());
+		lua_createtable(lua_state, (int)itt.second.size(), 0);
+		int index = 1;
+		for (const auto &entry : itt.second)
+		{
+			lua_createtable(lua_state, 2, 0);
+			lua_pushinteger(lua_state, (lua_Integer)entry.first);
+			lua_rawseti(lua_state, -2, 1);
+			lua_pushlstring(lua_state, entry.second.c_str(), entry.second.size());
+			lua_rawseti(lua_state, -2, 2);
+			lua_rawseti(lua_state, -2, index++);
+		}
+		lua_rawset(lua_state, -3);
+	}
+	return 2;
+}
+
+// dzVents_dataStore(module, changes, history), changes maps a variable to its serialized value or false to remove it,
+// history maps a history variable to { trim = <remove entries below this sequence>, added = { { sequence, serialized entry }, ... } }
+int CdzVents::l_dzvents_data_store(lua_State *lua_state)
+{
+	if ((!lua_isstring(lua_state, 1)) || (!lua_istable(lua_state, 2)))
+		return luaL_error(lua_state, "dzVents_dataStore: module name and table expected");
+
+	std::string module = lua_tostring(lua_state, 1);
+	std::map<std::string, std::string> changed;
+	std::vector<std::string> removed;
+	std::map<std::string, _tDzVentsHistoryChange> history;
+
+	lua_pushnil(lua_state);
+	while (lua_next(lua_state, 2) != 0)
+	{
+		if (lua_type(lua_state, -2) == LUA_TSTRING)
+		{
+			size_t len = 0;
+			std::string name = lua_tostring(lua_state, -2);
+			if (lua_type(lua_state, -1) == LUA_TSTRING)
+			{
+				const char *pValue = lua_tolstring(lua_state, -1, &len);
+				changed[name] = std::string(pValue, len);
+			}
+			else
+				removed.push_back(name);
+		}
+		lua_pop(lua_state, 1);
+	}
+
+	if (lua_istable(lua_state, 3))
+	{
+		lua_pushnil(lua_state);
+		while (lua_next(lua_state, 3) != 0)
+		{
+			if ((lua_type(lua_state, -2) == LUA_TSTRING) && (lua_istable(lua_state, -1)))
+			{
+				_tDzVentsHistoryChange &change = history[lua_tostring(lua_state, -2)];
+				lua_getfield(lua_state, -1, "trim");
+				if (lua_isnumber(lua_state, -1))
+					change.TrimBelow = (int64_t)lua_tointeger(lua_state, -1);
+				lua_pop(lua_state, 1);
+
+				lua_getfield(lua_state, -1, "added");
+				if (lua_istable(lua_state, -1))
+				{
+					int count = (int)lua_rawlen(lua_state, -1);
+					for (int ii = 1; ii <= count; ii++)
+					{
+						lua_rawgeti(lua_state, -1, ii);
+						lua_rawgeti(lua_state, -1, 1);
+						lua_rawgeti(lua_state, -2, 2);
+						if ((lua_isnumber(lua_state, -2)) && (lua_type(lua_state, -1) == LUA_TSTRING))
+						{
+							size_t len = 0;
+							const char *pValue = lua_tolstring(lua_state, -1, &len);
+							change.Added.emplace_back((int64_t)lua_tointeger(lua_state, -2), std::string(pValue, len));
+						}
+						lua_pop(lua_state, 3);
+					}
+				}
+				lua_pop(lua_state, 1);
+			}
+			lua_pop(lua_state, 1);
+		}
+	}
+	m_sql.StoreDzVentsData(module, changed, removed, history);
+	return 0;
+}
+
 void CdzVents::SetGlobalVariables(lua_State *lua_state, const bool reasonTime, const int secStatus)
 {
 	std::stringstream lua_DirT, runtime_DirT;
@@ -814,9 +929,34 @@ void CdzVents::SetGlobalVariables(lua_State *lua_state, const bool reasonTime, c
 	luaTable.AddString("domoticz_version", szAppVersion);
 	luaTable.AddString("dzVents_version", GetVersion());
 
+	// script names from the event system catalog, so the runtime does not have to list the folders itself
+#ifdef WIN32
+	ExportScriptNames(luaTable, "external_scripts", lua_DirT.str() + "scripts\\");
+	ExportScriptNames(luaTable, "internal_scripts", lua_DirT.str() + "generated_scripts\\");
+#else
+	ExportScriptNames(luaTable, "external_scripts", lua_DirT.str() + "scripts/");
+	ExportScriptNames(luaTable, "internal_scripts", lua_DirT.str() + "generated_scripts/");
+#endif
+
 	luaTable.Publish();
 }
 
+void CdzVents::ExportScriptNames(CLuaTable &luaTable, const std::string &Name, const std::string &dir)
+{
+	std::vector<std::string> FileEntries;
+	m_mainworker.m_eventsystem.GetScriptFiles(FileEntries, dir);
+	std::sort(FileEntries.begin(), FileEntries.end());
+
+	luaTable.OpenSubTableEntry(Name, 0, 0);
+	int index = 1;
+	for (const auto &filename : FileEntries)
+	{
+		if ((filename.size() > 4) && (filename[0] != '.') && (filename.compare(filename.size() - 4, 4, ".lua") == 0))
+			luaTable.AddString(index++, filename.substr(0, filename.size() - 4));
+	}
+	luaTable.CloseSubTableEntry();
+}
+
 void CdzVents::ExportHardwareData(CLuaTable &luaTable, int& index, const std::vector<CEventSystem::_tEventQueue>& items)
 {
 	;// to be implemented when hardware notification support is added
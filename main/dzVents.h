@@ -52,12 +52,15 @@ private:
 	void ExportDomoticzDataToLua(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items);
 	void IterateTable(lua_State *lua_state, const int tIndex, std::vector<_tLuaTableValues> &vLuaTable);
 	void SetGlobalVariables(lua_State *lua_state, const bool reasonTime, const int secStatus);
+	void ExportScriptNames(CLuaTable &luaTable, const std::string &Name, const std::string &dir);
 	void ProcessHttpResponse(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items);
 	void ProcessShellCommandResponse(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items);
 	void ProcessSecurity(lua_State *lua_state, const std::vector<CEventSystem::_tEventQueue> &items);
 	void ProcessNotification(lua_State* lua_state, const std::vector<CEventSystem::_tEventQueue>& items);
 	void ProcessNotificationItem(CLuaTable &luaTable, int &index, const CEventSystem::_tEventQueue& item);
 	static int l_domoticz_print(lua_State* lua_state);
+	static int l_dzvents_data_load(lua_State *lua_state);
+	static int l_dzvents_data_store(lua_State *lua_state);
 	static CdzVents m_dzvents;
 	std::string m_version;
 };
@@ -436,6 +436,21 @@ CDomoticzHardwareBase* MainWorker::GetHardware(int HwdId)
 	return nullptr;
 }
 
+void MainWorker::GetHardwareStatus(std::vector<CMetrics::_tHardwareStatus> &hardware)
+{
+	std::lock_guard<std::mutex> l(m_devicemutex);
+	for (const auto &device : m_hardwaredevices)
+	{
+		CMetrics::_tHardwareStatus hw;
+		hw.ID = device->m_HwdID;
+		hw.Name = device->m_Name;
+		hw.bStarted = device->IsStarted();
+		hw.LastHeartbeat = device->m_LastHeartbeat;
+		hw.LastReceive = device->m_LastHeartbeatReceive;
+		hardware.push_back(hw);
+	}
+}
+
 CDomoticzHardwareBase* MainWorker::GetHardwareByIDType(const std::string& HwdId, const _eHardwareTypes HWType)
 {
 	if (HwdId.empty())
@@ -1102,6 +1117,8 @@ bool MainWorker::Start()
 	{
 		return false;
 	}
+	//the push links and event system read device states from the store
+	m_devicestore.Load();
 
 	HTTPClient::SetUserAgent(GenerateUserAgent());
 	m_notifications.Init();
@@ -5996,6 +6013,7 @@ void MainWorker::decode_ColorSwitch(const CDomoticzHardwareBase* pHardware, cons
 				"UPDATE DeviceStatus SET LastLevel='%d' WHERE (ID = %" PRIu64 ")",
 				value,
 				ulID);
+			m_devicestore.Modify(ulID, [value](CDeviceStateStore::_tDeviceState &state) { state.LastLevel = value; });
 		}
 
 	}
@@ -6011,10 +6029,12 @@ void MainWorker::decode_ColorSwitch(const CDomoticzHardwareBase* pHardware, cons
 			uint64_t ulID = std::strtoull(result[0][0].c_str(), nullptr, 10);
 
 			//store color in database
+			std::string sColor = color.toJSONString();
 			m_sql.safe_query(
 				"UPDATE DeviceStatus SET Color='%q' WHERE (ID = %" PRIu64 ")",
-				color.toJSONString().c_str(),
+				sColor.c_str(),
 				ulID);
+			m_devicestore.Modify(ulID, [&sColor](CDeviceStateStore::_tDeviceState &state) { state.Color = sColor; });
 		}
 
 	}
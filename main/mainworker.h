@@ -6,6 +6,8 @@
 #include "EventSystem.h"
 #include "NotificationSystem.h"
 #include "Camera.h"
+#include "DeviceStateStore.h"
+#include "Metrics.h"
 #include <deque>
 #include "WindCalculation.h"
 #include "TrendCalculator.h"
@@ -37,6 +39,11 @@ public:
 	CDomoticzHardwareBase* GetHardware(int HwdId);
 	CDomoticzHardwareBase *GetHardwareByIDType(const std::string &HwdId, _eHardwareTypes HWType);
 	CDomoticzHardwareBase *GetHardwareByType(_eHardwareTypes HWType);
+	void GetHardwareStatus(std::vector<CMetrics::_tHardwareStatus> &hardware);
+	size_t GetRxQueueSize() const
+	{
+		return m_rxMessageQueue.size();
+	}
 
 	void HeartbeatUpdate(const std::string &component, bool critical = true);
 	void HeartbeatRemove(const std::string &component);
@@ -105,6 +112,8 @@ public:
 	Plugins::CPluginSystem m_pluginsystem;
 #endif
 	CCameraHandler m_cameras;
+	CDeviceStateStore m_devicestore;
+	CMetrics m_metrics;
 	bool m_bIgnoreUsernamePassword;
 	bool m_bHaveUpdate;
 	int m_iRevision;
@@ -199,17 +199,52 @@ std::string CNotificationHelper::ParseCustomMessage(const std::string &cMessage,
 	return ret;
 }
 
-bool CNotificationHelper::ApplyRule(const std::string &rule, const bool equal, const bool less)
+_eNotificationRule CNotificationHelper::ParseRule(const std::string &rule)
 {
-	if (((rule == ">") || (rule == ">=")) && (!less) && (!equal))
-		return true;
-	if (((rule == "<") || (rule == "<=")) && (less))
-		return true;
-	if (((rule == "=") || (rule == ">=") || (rule == "<=")) && (equal))
-		return true;
-	if ((rule == "!=") && (!equal))
-		return true;
-	return false;
+	if (rule == ">")
+		return NRULE_GREATER;
+	if (rule == ">=")
+		return NRULE_GREATER_EQUAL;
+	if (rule == "=")
+		return NRULE_EQUAL;
+	if (rule == "!=")
+		return NRULE_NOT_EQUAL;
+	if (rule == "<")
+		return NRULE_LESS;
+	if (rule == "<=")
+		return NRULE_LESS_EQUAL;
+	return NRULE_NONE;
+}
+
+int CNotificationHelper::ParseNotificationType(const std::string &sign)
+{
+	for (int ii = NTYPE_TEMPERATURE; ii <= NTYPE_SLEEPING; ii++)
+	{
+		if (sign == Notification_Type_Desc(ii, 1))
+			return ii;
+	}
+	return -1;
+}
+
+bool CNotificationHelper::ApplyRule(const _eNotificationRule rule, const bool equal, const bool less)
+{
+	switch (rule)
+	{
+	case NRULE_GREATER:
+		return (!less) && (!equal);
+	case NRULE_GREATER_EQUAL:
+		return ((!less) && (!equal)) || (equal);
+	case NRULE_EQUAL:
+		return equal;
+	case NRULE_NOT_EQUAL:
+		return !equal;
+	case NRULE_LESS:
+		return less;
+	case NRULE_LESS_EQUAL:
+		return (less) || (equal);
+	default:
+		return false;
+	}
 }
 
 bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, const int HardwareID, const std::string &ID, const std::string &sName, const unsigned char unit, const unsigned char cType, const unsigned char cSubType, const int nValue) {
@@ -239,6 +274,9 @@ bool CNotificationHelper::CheckAndHandleNotification(const uint64_t DevRowIdx, c
 	if ((DevRowIdx == -1) || IsLightOrSwitch(cType, cSubType)) {
 		return false;
 	}
+	// Nothing to evaluate, skip the svalue parsing and meter/rain lookups below
+	if (!HasNotifications(DevRowIdx))
+		return false;
 
 	int meterType = 0;
 	std::vector<std::string> strarray;
@@ -498,13 +536,13 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 	std::string msg;
 
 	std::string label = Notification_Type_Label(NTYPE_TEMPERATURE);
-	std::string signtemp = Notification_Type_Desc(NTYPE_TEMPERATURE, 1);
-	std::string signhum = Notification_Type_Desc(NTYPE_HUMIDITY, 1);
 
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
+		if ((n.NType != NTYPE_TEMPERATURE) && (n.NType != NTYPE_HUMIDITY))
+			continue;
 
 		if ((atime >= n.LastSend) || (n.SendAlways) || (!n.CustomMessage.empty())) // emergency always goes true
 		{
@@ -513,18 +551,15 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 			bRecoveryMessage = CustomRecoveryMessage(n.ID, recoverymsg, true);
 			if ((atime < n.LastSend) && (!n.SendAlways) && (!bRecoveryMessage))
 				continue;
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 3)
+			if (n.ParamCount < 3)
 				continue; //impossible
-			std::string ntype = splitresults[0];
 			std::string custommsg;
-			float svalue = static_cast<float>(atof(splitresults[2].c_str()));
+			float svalue = n.fValue;
 			bool bSendNotification = false;
 			bool bCustomMessage = false;
 			bCustomMessage = CustomRecoveryMessage(n.ID, custommsg, false);
 
-			if ((ntype == signtemp) && (bHaveTemp))
+			if ((n.NType == NTYPE_TEMPERATURE) && (bHaveTemp))
 			{
 				//temperature
 				if (m_sql.m_tempunit == TEMPUNIT_F)
@@ -540,10 +575,10 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 				else if (temp > 10.0) szExtraData += "Image=temp-10-15|";
 				else if (temp > 5.0) szExtraData += "Image=temp-5-10|";
 				else szExtraData += "Image=temp48|";
-				bSendNotification = ApplyRule(splitresults[1], (temp == svalue), (temp < svalue));
+				bSendNotification = ApplyRule(n.eRule, (temp == svalue), (temp < svalue));
 				if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 				{
-					sprintf(szTmp, "%s Temperature is %.1f %s [%s %.1f %s]", devicename.c_str(), temp, label.c_str(), splitresults[1].c_str(), svalue, label.c_str());
+					sprintf(szTmp, "%s Temperature is %.1f %s [%s %.1f %s]", devicename.c_str(), temp, label.c_str(), n.Rule.c_str(), svalue, label.c_str());
 					msg = szTmp;
 					sprintf(szTmp, "%.1f", temp);
 					notValue = szTmp;
@@ -560,14 +595,14 @@ bool CNotificationHelper::CheckAndHandleTempHumidityNotification(
 					bSendNotification = false;
 				}
 			}
-			else if ((ntype == signhum) && (bHaveHumidity))
+			else if ((n.NType == NTYPE_HUMIDITY) && (bHaveHumidity))
 			{
 				//humidity
 				szExtraData += "Image=moisture48|";
-				bSendNotification = ApplyRule(splitresults[1], (humidity == svalue), (humidity < svalue));
+				bSendNotification = ApplyRule(n.eRule, (humidity == svalue), (humidity < svalue));
 				if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 				{
-					sprintf(szTmp, "%s Humidity is %d %% [%s %.0f %%]", devicename.c_str(), humidity, splitresults[1].c_str(), svalue);
+					sprintf(szTmp, "%s Humidity is %d %% [%s %.0f %%]", devicename.c_str(), humidity, n.Rule.c_str(), svalue);
 					msg = szTmp;
 					sprintf(szTmp, "%d", humidity);
 					notValue = szTmp;
@@ -622,21 +657,13 @@ bool CNotificationHelper::CheckAndHandleDewPointNotification(
 
 	std::string msg;
 
-	std::string signdewpoint = Notification_Type_Desc(NTYPE_DEWPOINT, 1);
-
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-			std::string ntype = splitresults[0];
-
-			if (ntype == signdewpoint)
+			if (n.NType == NTYPE_DEWPOINT)
 			{
 				//dewpoint
 				if (temp <= dewpoint)
@@ -677,22 +704,17 @@ bool CNotificationHelper::CheckAndHandleValueNotification(
 	std::string msg;
 	std::string notValue;
 
-	std::string signvalue = Notification_Type_Desc(NTYPE_VALUE, 1);
-
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 2)
+			if (n.ParamCount < 2)
 				continue; //impossible
-			std::string ntype = splitresults[0];
-			int svalue = static_cast<int>(atoi(splitresults[1].c_str()));
+			int svalue = n.iValue;
 
-			if (ntype == signvalue)
+			if (n.NType == NTYPE_VALUE)
 			{
 				if (value > svalue)
 				{
@@ -736,14 +758,12 @@ bool CNotificationHelper::CheckAndHandleAmpere123Notification(
 
 	std::string notValue;
 
-	std::string signamp1 = Notification_Type_Desc(NTYPE_AMPERE1, 1);
-	std::string signamp2 = Notification_Type_Desc(NTYPE_AMPERE2, 1);
-	std::string signamp3 = Notification_Type_Desc(NTYPE_AMPERE3, 1);
-
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
+		if ((n.NType != NTYPE_AMPERE1) && (n.NType != NTYPE_AMPERE2) && (n.NType != NTYPE_AMPERE3))
+			continue;
 
 		if ((atime >= n.LastSend) || (n.SendAlways) || (!n.CustomMessage.empty())) // emergency always goes true
 		{
@@ -752,38 +772,26 @@ bool CNotificationHelper::CheckAndHandleAmpere123Notification(
 			bRecoveryMessage = CustomRecoveryMessage(n.ID, recoverymsg, true);
 			if ((atime < n.LastSend) && (!n.SendAlways) && (!bRecoveryMessage))
 				continue;
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 3)
+			if (n.ParamCount < 3)
 				continue; //impossible
-			std::string ntype = splitresults[0];
 			std::string custommsg;
-			std::string ltype;
-			float svalue = static_cast<float>(atof(splitresults[2].c_str()));
+			std::string ltype = Notification_Type_Desc(n.NType, 0);
+			float svalue = n.fValue;
 			float ampere = 0.0F;
 			bool bSendNotification = false;
 			bool bCustomMessage = false;
 			bCustomMessage = CustomRecoveryMessage(n.ID, custommsg, false);
 
-			if (ntype == signamp1)
-			{
+			if (n.NType == NTYPE_AMPERE1)
 				ampere = Ampere1;
-				ltype = Notification_Type_Desc(NTYPE_AMPERE1, 0);
-			}
-			else if (ntype == signamp2)
-			{
+			else if (n.NType == NTYPE_AMPERE2)
 				ampere = Ampere2;
-				ltype = Notification_Type_Desc(NTYPE_AMPERE2, 0);
-			}
-			else if (ntype == signamp3)
-			{
+			else
 				ampere = Ampere3;
-				ltype = Notification_Type_Desc(NTYPE_AMPERE3, 0);
-			}
-			bSendNotification = ApplyRule(splitresults[1], (ampere == svalue), (ampere < svalue));
+			bSendNotification = ApplyRule(n.eRule, (ampere == svalue), (ampere < svalue));
 			if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 			{
-				sprintf(szTmp, "%s %s is %.1f Ampere [%s %.1f Ampere]", devicename.c_str(), ltype.c_str(), ampere, splitresults[1].c_str(), svalue);
+				sprintf(szTmp, "%s %s is %.1f Ampere [%s %.1f Ampere]", devicename.c_str(), ltype.c_str(), ampere, n.Rule.c_str(), svalue);
 				msg = szTmp;
 				sprintf(szTmp, "%.1f", ampere);
 				notValue = szTmp;
@@ -825,12 +833,11 @@ bool CNotificationHelper::CheckAndHandleNotification(
 	if (notifications.empty())
 		return false;
 
-	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT SwitchType, CustomImage FROM DeviceStatus WHERE (ID=%" PRIu64 ")", Idx);
-	if (result.empty())
+	_tNotificationDevice device;
+	if (!GetDeviceInfo(Idx, device))
 		return false;
 
-	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + result[0][0] + "|CustomImage=" + result[0][1] + "|";
+	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + device.SwitchType + "|CustomImage=" + device.CustomImage + "|";
 	std::string notValue;
 
 	time_t atime = mytime(nullptr);
@@ -838,17 +845,11 @@ bool CNotificationHelper::CheckAndHandleNotification(
 	//check if not sent 12 hours ago, and if applicable
 	atime -= m_NotificationSensorInterval;
 
-	std::string ltype = Notification_Type_Desc(ntype, 1);
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
-		std::vector<std::string> splitresults;
-		StringSplit(n.Params, ";", splitresults);
-		if (splitresults.empty())
-			continue; //impossible
-		std::string atype = splitresults[0];
-		if (atype == ltype)
+		if (n.NType == ntype)
 		{
 			if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 			{
@@ -885,11 +886,10 @@ bool CNotificationHelper::CheckAndHandleNotification(
 		sprintf(szTmp, "%.1f", mvalue);
 	pvalue = szTmp;
 
-	std::vector<std::vector<std::string> > result;
-	result = m_sql.safe_query("SELECT SwitchType FROM DeviceStatus WHERE (ID=%" PRIu64 ")", Idx);
-	if (result.empty())
+	_tNotificationDevice device;
+	if (!GetDeviceInfo(Idx, device))
 		return false;
-	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + result[0][0] + "|";
+	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + device.SwitchType + "|";
 
 	time_t atime = mytime(nullptr);
 
@@ -899,13 +899,14 @@ bool CNotificationHelper::CheckAndHandleNotification(
 	std::string msg;
 
 	std::string ltype = Notification_Type_Desc(ntype, 0);
-	std::string nsign = Notification_Type_Desc(ntype, 1);
 	std::string label = Notification_Type_Label(ntype);
 
 	for (const auto &n : notifications)
 	{
 		if (n.LastUpdate)
 			TouchLastUpdate(n.ID);
+		if (n.NType != ntype)
+			continue;
 
 		if ((atime >= n.LastSend) || (n.SendAlways) || (!n.CustomMessage.empty())) // emergency always goes true
 		{
@@ -914,36 +915,30 @@ bool CNotificationHelper::CheckAndHandleNotification(
 			bRecoveryMessage = CustomRecoveryMessage(n.ID, recoverymsg, true);
 			if ((atime < n.LastSend) && (!n.SendAlways) && (!bRecoveryMessage))
 				continue;
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.size() < 3)
+			if (n.ParamCount < 3)
 				continue; //impossible
-			std::string ntype = splitresults[0];
 			std::string custommsg;
-			float svalue = static_cast<float>(atof(splitresults[2].c_str()));
+			float svalue = n.fValue;
 			bool bSendNotification = false;
 			bool bCustomMessage = false;
 			bCustomMessage = CustomRecoveryMessage(n.ID, custommsg, false);
 
-			if (ntype == nsign)
+			bSendNotification = ApplyRule(n.eRule, (mvalue == svalue), (mvalue < svalue));
+			if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
 			{
-				bSendNotification = ApplyRule(splitresults[1], (mvalue == svalue), (mvalue < svalue));
-				if (bSendNotification && (!bRecoveryMessage || n.SendAlways))
-				{
-					sprintf(szTmp, "%s %s is %s %s [%s %.1f %s]", devicename.c_str(), ltype.c_str(), pvalue.c_str(), label.c_str(), splitresults[1].c_str(), svalue, label.c_str());
-					msg = szTmp;
-				}
-				else if (!bSendNotification && bRecoveryMessage)
-				{
-					bSendNotification = true;
-					msg = recoverymsg;
-					std::string clearstr = "!";
-					CustomRecoveryMessage(n.ID, clearstr, true);
-				}
-				else
-				{
-					bSendNotification = false;
-				}
+				sprintf(szTmp, "%s %s is %s %s [%s %.1f %s]", devicename.c_str(), ltype.c_str(), pvalue.c_str(), label.c_str(), n.Rule.c_str(), svalue, label.c_str());
+				msg = szTmp;
+			}
+			else if (!bSendNotification && bRecoveryMessage)
+			{
+				bSendNotification = true;
+				msg = recoverymsg;
+				std::string clearstr = "!";
+				CustomRecoveryMessage(n.ID, clearstr, true);
+			}
+			else
+			{
+				bSendNotification = false;
 			}
 			if (bSendNotification)
 			{
@@ -970,19 +965,14 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 	if (notifications.empty())
 		return false;
 
-	std::vector<std::vector<std::string> > result;
-
-	result = m_sql.safe_query("SELECT SwitchType, CustomImage FROM DeviceStatus WHERE (ID=%" PRIu64 ")",
-		Idx);
-	if (result.empty())
+	_tNotificationDevice device;
+	if (!GetDeviceInfo(Idx, device))
 		return false;
-	_eSwitchType switchtype = (_eSwitchType)atoi(result[0][0].c_str());
-	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + result[0][0] + "|CustomImage=" + result[0][1] + "|";
+	_eSwitchType switchtype = (_eSwitchType)atoi(device.SwitchType.c_str());
+	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + device.SwitchType + "|CustomImage=" + device.CustomImage + "|";
 
 	std::string msg;
 
-	std::string ltype = Notification_Type_Desc(ntype, 1);
-
 	time_t atime = mytime(nullptr);
 	atime -= m_NotificationSwitchInterval;
 
@@ -990,16 +980,10 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 	{
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-			std::string atype = splitresults[0];
-
 			bool bSendNotification = false;
 			std::string notValue;
 
-			if (atype == ltype)
+			if (n.NType == ntype)
 			{
 				bSendNotification = true;
 				msg = devicename;
@@ -1082,20 +1066,15 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 	std::vector<_tNotification> notifications = GetNotifications(Idx);
 	if (notifications.empty())
 		return false;
-	std::vector<std::vector<std::string> > result;
-
-	result = m_sql.safe_query("SELECT SwitchType, CustomImage, Options FROM DeviceStatus WHERE (ID=%" PRIu64 ")",
-		Idx);
-	if (result.empty())
+	_tNotificationDevice device;
+	if (!GetDeviceInfo(Idx, device))
 		return false;
-	_eSwitchType switchtype = (_eSwitchType)atoi(result[0][0].c_str());
-	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + result[0][0] + "|CustomImage=" + result[0][1] + "|";
-	std::string sOptions = result[0][2];
+	_eSwitchType switchtype = (_eSwitchType)atoi(device.SwitchType.c_str());
+	std::string szExtraData = "|Name=" + devicename + "|SwitchType=" + device.SwitchType + "|CustomImage=" + device.CustomImage + "|";
+	const std::string &sOptions = device.Options;
 
 	std::string msg;
 
-	std::string ltype = Notification_Type_Desc(ntype, 1);
-
 	time_t atime = mytime(nullptr);
 	atime -= m_NotificationSwitchInterval;
 
@@ -1103,24 +1082,18 @@ bool CNotificationHelper::CheckAndHandleSwitchNotification(
 	{
 		if ((atime >= n.LastSend) || (n.SendAlways)) // emergency always goes true
 		{
-			std::vector<std::string> splitresults;
-			StringSplit(n.Params, ";", splitresults);
-			if (splitresults.empty())
-				continue; //impossible
-			std::string atype = splitresults[0];
-
 			bool bSendNotification = false;
 			std::string notValue;
 
-			if (atype == ltype)
+			if (n.NType == ntype)
 			{
 				msg = devicename;
 				if (ntype == NTYPE_SWITCH_ON)
 				{
-					if (splitresults.size() < 3)
+					if (n.ParamCount < 3)
 						continue; //impossible
-					bool bWhenEqual = (splitresults[1] == "=");
-					int iLevel = atoi(splitresults[2].c_str());
+					bool bWhenEqual = (n.eRule == NRULE_EQUAL);
+					int iLevel = n.iValue;
 					if (!bWhenEqual || iLevel < 10 || iLevel > 100)
 						continue; //invalid
 
@@ -1174,15 +1147,6 @@ bool CNotificationHelper::CheckAndHandleRainNotification(
 	const _eNotificationTypes ntype,
 	const float mvalue)
 {
-	std::vector<std::vector<std::string> > result;
-
-	result = m_sql.safe_query("SELECT AddjValue,AddjMulti FROM DeviceStatus WHERE (ID=%" PRIu64 ")",
-		Idx);
-	if (result.empty())
-		return false;
-	//double AddjValue = atof(result[0][0].c_str());
-	double AddjMulti = atof(result[0][1].c_str());
-
 	char szDateEnd[40];
 
 	time_t now = mytime(nullptr);
@@ -1199,7 +1163,41 @@ bool CNotificationHelper::CheckAndHandleRainNotification(
 	ltime.tm_mday = tm1.tm_mday;
 	sprintf(szDateEnd, "%04d-%02d-%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday);
 
-	if (subType == sTypeRAINWU || subType == sTypeRAINByRate)
+	bool bTotalRain = (subType == sTypeRAINWU || subType == sTypeRAINByRate);
+	double AddjMulti;
+	float total_min = 0.0F;
+	{
+		std::lock_guard<std::mutex> l(m_mutex);
+		auto itt = m_devices.find(Idx);
+		if (itt == m_devices.end())
+		{
+			if (!LoadDeviceInfo(Idx))
+				return false;
+			itt = m_devices.find(Idx);
+		}
+		_tNotificationDevice &device = itt->second;
+		AddjMulti = device.AddjMulti;
+
+		// The rain counter only goes up, so the day's first stored total only has to be read once a day,
+		// or again when the counter went down (sensor reset)
+		bool bCounterDown = (mvalue < device.RainDayStart) && (now >= device.RainNextQuery);
+		if ((!bTotalRain) && ((device.RainDate != szDateEnd) || bCounterDown || ((device.RainNextQuery != 0) && (now >= device.RainNextQuery))))
+		{
+			std::vector<std::vector<std::string> > result;
+			result = m_sql.safe_query("SELECT MIN(Total) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
+				Idx, szDateEnd);
+			device.RainDate = szDateEnd;
+			device.RainDayStart = 0.0F;
+			device.RainNextQuery = 0;
+			if ((!result.empty()) && (!result[0][0].empty()))
+				device.RainDayStart = static_cast<float>(atof(result[0][0].c_str()));
+			if ((result.empty()) || (result[0][0].empty()) || (mvalue < device.RainDayStart))
+				device.RainNextQuery = now + 300; // nothing (lower) stored yet today, retry after the next 5 minute sample
+		}
+		total_min = device.RainDayStart;
+	}
+
+	if (bTotalRain)
 	{
 		//value is already total rain
 		double total_real = mvalue;
@@ -1208,18 +1206,10 @@ bool CNotificationHelper::CheckAndHandleRainNotification(
 	}
 	else
 	{
-		result = m_sql.safe_query("SELECT MIN(Total) FROM Rain WHERE (DeviceRowID=%" PRIu64 " AND Date>='%q')",
-			Idx, szDateEnd);
-		if (!result.empty())
-		{
-			std::vector<std::string> sd = result[0];
-
-			float total_min = static_cast<float>(atof(sd[0].c_str()));
-			float total_max = mvalue;
-			double total_real = total_max - total_min;
-			total_real *= AddjMulti;
-			CheckAndHandleNotification(Idx, devicename, devType, subType, NTYPE_RAIN, (float)total_real);
-		}
+		float total_max = mvalue;
+		double total_real = total_max - total_min;
+		total_real *= AddjMulti;
+		CheckAndHandleNotification(Idx, devicename, devType, subType, NTYPE_RAIN, (float)total_real);
 	}
 	return false;
 }
@@ -1240,12 +1230,9 @@ void CNotificationHelper::CheckAndHandleLastUpdateNotification()
 			if (((atime >= n2.LastSend) || (n2.SendAlways) || (!n2.CustomMessage.empty()))
 			    && (n2.LastUpdate)) // emergency always goes true
 			{
-				std::vector<std::string> splitresults;
-				StringSplit(n2.Params, ";", splitresults);
-				if (splitresults.size() < 3)
+				if (n2.ParamCount < 3)
 					continue;
-				std::string ttype = Notification_Type_Desc(NTYPE_LASTUPDATE, 1);
-				if (splitresults[0] == ttype)
+				if (n2.NType == NTYPE_LASTUPDATE)
 				{
 					std::string recoverymsg;
 					bool bRecoveryMessage = false;
@@ -1258,10 +1245,10 @@ void CNotificationHelper::CheckAndHandleLastUpdateNotification()
 					std::string szExtraData;
 					std::string custommsg;
 					uint64_t Idx = n.first;
-					uint32_t SensorTimeOut = static_cast<uint32_t>(atoi(splitresults[2].c_str()));  // minutes
+					uint32_t SensorTimeOut = static_cast<uint32_t>(n2.iValue);  // minutes
 					uint32_t diff = static_cast<uint32_t>(round(difftime(btime, n2.LastUpdate)));
 					bool bStartTime = (difftime(btime, m_StartTime) < SensorTimeOut * 60);
-					bool bSendNotification = ApplyRule(splitresults[1], (diff == SensorTimeOut * 60), (diff < SensorTimeOut * 60));
+					bool bSendNotification = ApplyRule(n2.eRule, (diff == SensorTimeOut * 60), (diff < SensorTimeOut * 60));
 					bool bCustomMessage = false;
 					bCustomMessage = CustomRecoveryMessage(n2.ID, custommsg, false);
 
@@ -1269,11 +1256,10 @@ void CNotificationHelper::CheckAndHandleLastUpdateNotification()
 					{
 						if (SystemUptime() < SensorTimeOut * 60 && (!bRecoveryMessage || n2.SendAlways))
 							continue;
-						std::vector<std::vector<std::string> > result;
-						result = m_sql.safe_query("SELECT SwitchType FROM DeviceStatus WHERE (ID=%" PRIu64 ")", Idx);
-						if (result.empty())
+						_tNotificationDevice device;
+						if (!GetDeviceInfo(Idx, device))
 							continue;
-						szExtraData = "|Name=" + n2.DeviceName + "|SwitchType=" + result[0][0] + "|";
+						szExtraData = "|Name=" + n2.DeviceName + "|SwitchType=" + device.SwitchType + "|";
 						std::string ltype = Notification_Type_Desc(NTYPE_LASTUPDATE, 0);
 						std::string label = Notification_Type_Label(NTYPE_LASTUPDATE);
 						char szDate[50];
@@ -1283,7 +1269,7 @@ void CNotificationHelper::CheckAndHandleLastUpdateNotification()
 						sprintf(szDate, "%04d-%02d-%02d %02d:%02d:%02d", ltime.tm_year + 1900, ltime.tm_mon + 1, ltime.tm_mday,
 							ltime.tm_hour, ltime.tm_min, ltime.tm_sec);
 						sprintf(szTmp, "Sensor %s %s: %s [%s %d %s]", n2.DeviceName.c_str(), ltype.c_str(), szDate,
-							splitresults[1].c_str(), SensorTimeOut, label.c_str());
+							n2.Rule.c_str(), SensorTimeOut, label.c_str());
 						msg = szTmp;
 					}
 					else if (!bSendNotification && bRecoveryMessage)
@@ -1324,109 +1310,80 @@ void CNotificationHelper::TouchNotification(const uint64_t ID)
 
 	//Also touch it internally
 	std::lock_guard<std::mutex> l(m_mutex);
-
-	for (auto &m : m_notifications)
-	{
-		for (auto &n : m.second)
-		{
-			if (n.ID == ID)
-			{
-				n.LastSend = atime;
-				return;
-			}
-		}
-	}
+	_tNotification *pNotification = FindNotification(ID);
+	if (pNotification)
+		pNotification->LastSend = atime;
 }
 
 void CNotificationHelper::TouchLastUpdate(const uint64_t ID)
 {
 	time_t atime = mytime(nullptr);
 	std::lock_guard<std::mutex> l(m_mutex);
-
-	for (auto &m : m_notifications)
-	{
-		for (auto &n : m.second)
-		{
-			if (n.ID == ID)
-			{
-				n.LastUpdate = atime;
-				return;
-			}
-		}
-	}
+	_tNotification *pNotification = FindNotification(ID);
+	if (pNotification)
+		pNotification->LastUpdate = atime;
 }
 
 bool CNotificationHelper::CustomRecoveryMessage(const uint64_t ID, std::string &msg, const bool isRecovery)
 {
 	std::lock_guard<std::mutex> l(m_mutex);
 
-	for (auto &m : m_notifications)
+	_tNotification *pNotification = FindNotification(ID);
+	if (pNotification == nullptr)
+		return false;
+	_tNotification &n = *pNotification;
+
+	if (isRecovery && !n.bRecovery)
+		return false;
+
+	std::vector<std::string> splitresults;
+	std::string szTmp;
+	StringSplit(n.CustomMessage, ";;", splitresults);
+	if (msg.empty())
 	{
-		for (auto &n : m.second)
+		if (!splitresults.empty())
 		{
-			if (n.ID == ID)
+			if (!splitresults[0].empty() && !isRecovery)
 			{
-				std::vector<std::string> splitresults;
-				if (isRecovery)
-				{
-					StringSplit(n.Params, ";", splitresults);
-					if (splitresults.size() < 4)
-						return false;
-					if (splitresults[3] != "1")
-						return false;
-				}
-
-				std::string szTmp;
-				StringSplit(n.CustomMessage, ";;", splitresults);
-				if (msg.empty())
-				{
-					if (!splitresults.empty())
-					{
-						if (!splitresults[0].empty() && !isRecovery)
-						{
-							szTmp = splitresults[0];
-							msg = szTmp;
-							return true;
-						}
-						if (splitresults.size() > 1)
-						{
-							if (!splitresults[1].empty() && isRecovery)
-							{
-								szTmp = splitresults[1];
-								msg = szTmp;
-								return true;
-							}
-						}
-					}
-					return false;
-				}
-				if (!isRecovery)
-					return false;
-
-				if (!splitresults.empty())
-				{
-					if (!splitresults[0].empty())
-						szTmp = splitresults[0];
-				}
-				if ((msg.find('!') != 0) && (msg.size() > 1))
+				szTmp = splitresults[0];
+				msg = szTmp;
+				return true;
+			}
+			if (splitresults.size() > 1)
+			{
+				if (!splitresults[1].empty() && isRecovery)
 				{
-					szTmp.append(";;[Recovered] ");
-					szTmp.append(msg);
+					szTmp = splitresults[1];
+					msg = szTmp;
+					return true;
 				}
-				std::vector<std::vector<std::string> > result;
-				result = m_sql.safe_query("SELECT ID FROM Notifications WHERE (ID=='%" PRIu64 "') AND (Params=='%q')", n.ID,
-							  n.Params.c_str());
-				if (result.empty())
-					return false;
-
-				m_sql.safe_query("UPDATE Notifications SET CustomMessage='%q' WHERE ID=='%" PRIu64 "'", szTmp.c_str(),
-						 n.ID);
-				n.CustomMessage = szTmp;
-				return true;
 			}
 		}
+		return false;
 	}
-	return false;
+	if (!isRecovery)
+		return false;
+
+	if (!splitresults.empty())
+	{
+		if (!splitresults[0].empty())
+			szTmp = splitresults[0];
+	}
+	if ((msg.find('!') != 0) && (msg.size() > 1))
+	{
+		szTmp.append(";;[Recovered] ");
+		szTmp.append(msg);
+	}
+	std::vector<std::vector<std::string> > result;
+	result = m_sql.safe_query("SELECT ID FROM Notifications WHERE (ID=='%" PRIu64 "') AND (Params=='%q')", n.ID,
+				  n.Params.c_str());
+	if (result.empty())
+		return false;
+
+	m_sql.safe_query("UPDATE Notifications SET CustomMessage='%q' WHERE ID=='%" PRIu64 "'", szTmp.c_str(),
+			 n.ID);
+	n.CustomMessage = szTmp;
+	return true;
 }
 
 bool CNotificationHelper::AddNotification(
@@ -1503,11 +1460,62 @@ bool CNotificationHelper::HasNotifications(const uint64_t DevIdx)
 	return (m_notifications.find(DevIdx) != m_notifications.end());
 }
 
+// Caller must hold m_mutex
+_tNotification *CNotificationHelper::FindNotification(const uint64_t ID)
+{
+	auto itt = m_notificationsByID.find(ID);
+	if (itt == m_notificationsByID.end())
+		return nullptr;
+	return itt->second;
+}
+
+// Caller must hold m_mutex
+bool CNotificationHelper::LoadDeviceInfo(const uint64_t DevIdx)
+{
+	std::vector<std::vector<std::string> > result;
+	result = m_sql.safe_query("SELECT SwitchType, CustomImage, Options, AddjMulti FROM DeviceStatus WHERE (ID=%" PRIu64 ")", DevIdx);
+	if (result.empty())
+	{
+		m_devices.erase(DevIdx);
+		return false;
+	}
+	_tNotificationDevice &device = m_devices[DevIdx];
+	device.SwitchType = result[0][0];
+	device.CustomImage = result[0][1];
+	device.Options = result[0][2];
+	device.AddjMulti = atof(result[0][3].c_str());
+	return true;
+}
+
+bool CNotificationHelper::GetDeviceInfo(const uint64_t DevIdx, _tNotificationDevice &info)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	auto itt = m_devices.find(DevIdx);
+	if (itt == m_devices.end())
+	{
+		if (!LoadDeviceInfo(DevIdx))
+			return false;
+		itt = m_devices.find(DevIdx);
+	}
+	info = itt->second;
+	return true;
+}
+
+//Called when the SwitchType, CustomImage, Options or AddjMulti of a device are changed
+//Only drops the cached entry, it is reloaded on the next notification check
+void CNotificationHelper::DeviceChanged(const uint64_t DevIdx)
+{
+	std::lock_guard<std::mutex> l(m_mutex);
+	m_devices.erase(DevIdx);
+}
+
 //Re(Loads) all notifications stored in the database, so we do not have to query this all the time
 void CNotificationHelper::ReloadNotifications()
 {
 	std::lock_guard<std::mutex> l(m_mutex);
 	m_notifications.clear();
+	m_notificationsByID.clear();
+	m_devices.clear();
 	std::vector<std::vector<std::string> > result;
 
 	m_sql.GetPreferencesVar("NotificationSensorInterval", m_NotificationSensorInterval);
@@ -1557,20 +1565,23 @@ void CNotificationHelper::ReloadNotifications()
 			struct tm ntime;
 			ParseSQLdatetime(notification.LastSend, ntime, stime, atime.tm_isdst);
 		}
-		std::string ttype = Notification_Type_Desc(NTYPE_LASTUPDATE, 1);
+		notification.LastUpdate = 0;
+
+		// Compile the rule once so the update path does not have to parse it again
 		StringSplit(notification.Params, ";", splitresults);
-		if (splitresults[0] == ttype) {
+		notification.ParamCount = splitresults.size();
+		notification.NType = (!splitresults.empty()) ? ParseNotificationType(splitresults[0]) : -1;
+		notification.Rule = (splitresults.size() > 1) ? splitresults[1] : "";
+		notification.eRule = ParseRule(notification.Rule);
+		notification.fValue = (splitresults.size() > 2) ? static_cast<float>(atof(splitresults[2].c_str())) : 0.0F;
+		notification.iValue = (splitresults.size() > 2) ? atoi(splitresults[2].c_str()) : 0;
+		if (notification.NType == NTYPE_VALUE)
+			notification.iValue = atoi(notification.Rule.c_str()); // "F;value", there is no rule
+		notification.bRecovery = ((splitresults.size() > 3) && (splitresults[3] == "1"));
+
+		if (notification.NType == NTYPE_LASTUPDATE) {
 			std::vector<std::vector<std::string> > result2;
-			result2 = m_sql.safe_query(
-				"SELECT B.Name, B.LastUpdate "
-				"FROM Notifications AS A "
-				"LEFT OUTER JOIN DeviceStatus AS B "
-				"ON A.DeviceRowID=B.ID "
-				"WHERE (A.Params LIKE '%q%%') "
-				"AND (A.ID=='%" PRIu64 "') "
-				"LIMIT 1",
-				ttype.c_str(), notification.ID
-				);
+			result2 = m_sql.safe_query("SELECT Name, LastUpdate FROM DeviceStatus WHERE (ID==%" PRIu64 ")", Idx);
 			if (result2.size() == 1) {
 				struct tm ntime;
 				notification.DeviceName = result2[0][0];
@@ -1580,4 +1591,21 @@ void CNotificationHelper::ReloadNotifications()
 		}
 		m_notifications[Idx].push_back(notification);
 	}
+
+	for (auto &m : m_notifications)
+	{
+		for (auto &n : m.second)
+			m_notificationsByID[n.ID] = &n;
+	}
+
+	// Preload what the notifications need from DeviceStatus so an update does not have to query it
+	result = m_sql.safe_query("SELECT ID, SwitchType, CustomImage, Options, AddjMulti FROM DeviceStatus WHERE ID IN (SELECT DeviceRowID FROM Notifications)");
+	for (const auto &sd : result)
+	{
+		_tNotificationDevice &device = m_devices[std::stoull(sd[0])];
+		device.SwitchType = sd[1];
+		device.CustomImage = sd[2];
+		device.Options = sd[3];
+		device.AddjMulti = atof(sd[4].c_str());
+	}
 }
@@ -6,6 +6,17 @@
 
 #define NOTIFYALL std::string("")
 
+enum _eNotificationRule
+{
+	NRULE_NONE = 0,
+	NRULE_GREATER,
+	NRULE_GREATER_EQUAL,
+	NRULE_EQUAL,
+	NRULE_NOT_EQUAL,
+	NRULE_LESS,
+	NRULE_LESS_EQUAL,
+};
+
 struct _tNotification
 {
 	uint64_t ID;
@@ -17,6 +28,29 @@ struct _tNotification
 	std::string CustomMessage;
 	std::string ActiveSystems;
 	bool SendAlways;
+
+	// Params compiled by ReloadNotifications ("type;rule;value;recovery")
+	int NType;	 // _eNotificationTypes, -1 when unknown
+	size_t ParamCount;
+	std::string Rule;
+	_eNotificationRule eRule;
+	float fValue;
+	int iValue;
+	bool bRecovery;
+};
+
+// DeviceStatus fields used when sending, cached for devices that have notifications
+struct _tNotificationDevice
+{
+	std::string SwitchType;
+	std::string CustomImage;
+	std::string Options;
+	double AddjMulti;
+
+	// first rain total of the day
+	std::string RainDate;
+	float RainDayStart = 0.0F;
+	time_t RainNextQuery = 0;
 };
 
 class CNotificationHelper
@@ -46,6 +80,7 @@ class CNotificationHelper
 	bool CustomRecoveryMessage(uint64_t ID, std::string &msg, bool isRecovery);
 	bool HasNotifications(uint64_t DevIdx);
 	bool HasNotifications(const std::string &DevIdx);
+	void DeviceChanged(uint64_t DevIdx);
 
 	bool CheckAndHandleNotification(uint64_t DevRowIdx, int HardwareID, const std::string &ID, const std::string &sName, unsigned char unit, unsigned char cType, unsigned char cSubType,
 					int nValue);
@@ -80,9 +115,16 @@ class CNotificationHelper
 	bool CheckAndHandleAmpere123Notification(uint64_t Idx, const std::string &DeviceName, float Ampere1, float Ampere2, float Ampere3);
 
 	std::string ParseCustomMessage(const std::string &cMessage, const std::string &sName, const std::string &sValue);
-	bool ApplyRule(const std::string &rule, bool equal, bool less);
+	static _eNotificationRule ParseRule(const std::string &rule);
+	static int ParseNotificationType(const std::string &sign);
+	bool ApplyRule(_eNotificationRule rule, bool equal, bool less);
+	bool GetDeviceInfo(uint64_t DevIdx, _tNotificationDevice &info);
+	bool LoadDeviceInfo(uint64_t DevIdx);
+	_tNotification *FindNotification(uint64_t ID);
 	std::mutex m_mutex;
 	std::map<uint64_t, std::vector<_tNotification>> m_notifications;
+	std::map<uint64_t, _tNotification *> m_notificationsByID;
+	std::map<uint64_t, _tNotificationDevice> m_devices;
 	int m_NotificationSensorInterval;
 	int m_NotificationSwitchInterval;
 };
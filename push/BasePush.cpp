@@ -6,6 +6,8 @@
 #include "../main/Logger.h"
 #include "../main/RFXtrx.h"
 #include "../main/SQLHelper.h"
+#include "../main/mainworker.h"
+#include "../main/localtime_r.h"
 #include "../main/WebServer.h"
 
 #define __STDC_FORMAT_MACROS
@@ -400,6 +402,16 @@ unsigned long CBasePush::get_tzoffset()
 	return tzoffset;
 }
 
+// LastUpdate as seconds since epoch in local time, like SQLite strftime('%s') on the stored value
+int CBasePush::get_lastUpdateLocal(const std::string &szLastUpdate)
+{
+	time_t tLastUpdate = 0;
+	struct tm tmLastUpdate;
+	if (!ParseSQLdatetime(tLastUpdate, tmLastUpdate, szLastUpdate))
+		return 0;
+	return (int)(tLastUpdate + get_tzoffset());
+}
+
 #ifdef WIN32
 std::string CBasePush::get_lastUpdate(unsigned __int64 localTimeUtc)
 #else
@@ -892,19 +904,19 @@ void CBasePush::ReloadPushLinks(const PushType PType)
 	std::lock_guard<std::mutex> l(m_link_mutex);
 	m_pushlinks.clear();
 	std::vector<std::vector<std::string>> result;
-	result = m_sql.safe_query("SELECT A.DeviceRowID, A.DelimitedValue, B.ID, B.Name, B.Type, B.SubType, B.SwitchType "
-				  "FROM PushLink as A, DeviceStatus as B "
-				  "WHERE (A.PushType==%d AND A.Enabled==1 AND A.DeviceRowID == B.ID)",
-				  PType);
+	result = m_sql.safe_query("SELECT DeviceRowID, DelimitedValue FROM PushLink WHERE (PushType==%d AND Enabled==1)", PType);
 	for (const auto &sd : result)
 	{
 		_tPushLinks tlink;
 		tlink.DeviceRowIdx = std::stoull(sd[0]);
+		CDeviceStateStore::_tDeviceStatePtr state = m_mainworker.m_devicestore.Get(tlink.DeviceRowIdx);
+		if (!state)
+			continue;
 		tlink.DelimiterPos = std::stoi(sd[1]);
-		tlink.DeviceName = sd[3];
-		tlink.devType = std::stoi(sd[4]);
-		tlink.devSubType = std::stoi(sd[5]);
-		tlink.metertype = std::stoi(sd[6]);
+		tlink.DeviceName = state->Name;
+		tlink.devType = state->devType;
+		tlink.devSubType = state->subType;
+		tlink.metertype = state->SwitchType;
 		m_pushlinks.push_back(tlink);
 	}
 }
@@ -48,6 +48,7 @@ protected:
 	std::string getUnit(const int devType, const int devSubType, const int delpos, const int metertypein);
 
 	static unsigned long get_tzoffset();
+	static int get_lastUpdateLocal(const std::string &szLastUpdate);
 #ifdef WIN32
 	static std::string get_lastUpdate(unsigned __int64);
 #else
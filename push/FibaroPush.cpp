@@ -52,10 +52,13 @@ void CFibaroPush::OnDeviceReceived(const int m_HwdID, const uint64_t DeviceRowId
 
 void CFibaroPush::DoFibaroPush(const uint64_t DeviceRowIdx)
 {
+	CDeviceStateStore::_tDeviceStatePtr state = m_mainworker.m_devicestore.Get(DeviceRowIdx);
+	if (!state)
+		return;
+
 	std::vector<std::vector<std::string>> result;
-	result = m_sql.safe_query("SELECT A.DeviceRowID, A.DelimitedValue, B.ID, B.Type, B.SubType, B.nValue, B.sValue, A.TargetType, A.TargetVariable, A.TargetDeviceID, A.TargetProperty, "
-				  "A.IncludeUnit, B.SwitchType FROM PushLink as A, DeviceStatus as B "
-				  "WHERE (A.PushType==%d AND A.DeviceRowID == '%" PRIu64 "' AND A.Enabled = '1' AND A.DeviceRowID==B.ID)",
+	result = m_sql.safe_query("SELECT DeviceRowID, DelimitedValue, TargetType, TargetVariable, TargetDeviceID, TargetProperty, IncludeUnit FROM PushLink "
+				  "WHERE (PushType==%d AND DeviceRowID == '%" PRIu64 "' AND Enabled = '1')",
 				  PushType::PUSHTYPE_FIBARO, DeviceRowIdx);
 	if (result.empty())
 		return;
@@ -84,16 +87,16 @@ void CFibaroPush::DoFibaroPush(const uint64_t DeviceRowIdx)
 	{
 		std::string sendValue;
 		int delpos = atoi(sd[1].c_str());
-		int dType = atoi(sd[3].c_str());
-		int dSubType = atoi(sd[4].c_str());
-		int nValue = atoi(sd[5].c_str());
-		std::string sValue = sd[6];
-		int targetType = atoi(sd[7].c_str());
-		std::string targetVariable = sd[8];
-		int targetDeviceID = atoi(sd[9].c_str());
-		std::string targetProperty = sd[10];
-		int includeUnit = atoi(sd[11].c_str());
-		int metertype = atoi(sd[12].c_str());
+		int dType = state->devType;
+		int dSubType = state->subType;
+		int nValue = state->nValue;
+		std::string sValue = state->sValue;
+		int targetType = atoi(sd[2].c_str());
+		std::string targetVariable = sd[3];
+		int targetDeviceID = atoi(sd[4].c_str());
+		std::string targetProperty = sd[5];
+		int includeUnit = atoi(sd[6].c_str());
+		int metertype = state->SwitchType;
 		std::string lstatus;
 
 		if ((targetType == 0) || (targetType == 1)) {
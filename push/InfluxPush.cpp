@@ -122,10 +122,14 @@ void CInfluxPush::DoInfluxPush(const uint64_t DeviceRowIdx)
 	if (!IsLinkInDatabase(DeviceRowIdx))
 		return;
 
+	CDeviceStateStore::_tDeviceStatePtr state = m_mainworker.m_devicestore.Get(DeviceRowIdx);
+	if (!state)
+		return;
+
 	std::vector<std::vector<std::string>> result;
 	result = m_sql.safe_query(
-		"SELECT A.DeviceRowID, A.DelimitedValue, B.ID, B.Type, B.SubType, B.nValue, B.sValue, A.TargetType, A.IncludeUnit, B.Name, B.SwitchType FROM PushLink as A, DeviceStatus as B "
-		"WHERE (A.PushType==%d AND A.DeviceRowID == '%" PRIu64 "' AND A.Enabled==1 AND A.DeviceRowID==B.ID)",
+		"SELECT DeviceRowID, DelimitedValue, TargetType, IncludeUnit FROM PushLink "
+		"WHERE (PushType==%d AND DeviceRowID == '%" PRIu64 "' AND Enabled==1)",
 		PushType::PUSHTYPE_INFLUXDB, DeviceRowIdx);
 	if (result.empty())
 		return;
@@ -135,14 +139,14 @@ void CInfluxPush::DoInfluxPush(const uint64_t DeviceRowIdx)
 	{
 		std::string sendValue;
 		int delpos = atoi(sd[1].c_str());
-		int dType = atoi(sd[3].c_str());
-		int dSubType = atoi(sd[4].c_str());
-		int nValue = atoi(sd[5].c_str());
-		std::string sValue = sd[6];
-		int targetType = atoi(sd[7].c_str());
-		int includeUnit = atoi(sd[8].c_str());
-		std::string name = sd[9];
-		int metertype = atoi(sd[10].c_str());
+		int dType = state->devType;
+		int dSubType = state->subType;
+		int nValue = state->nValue;
+		const std::string &sValue = state->sValue;
+		int targetType = atoi(sd[2].c_str());
+		int includeUnit = atoi(sd[3].c_str());
+		std::string name = state->Name;
+		int metertype = state->SwitchType;
 
 		std::vector<std::string> strarray;
 		if (sValue.find(';') != std::string::npos)
@@ -19,10 +19,8 @@ void CWebSocketPush::Start()
 	if (isStarted) {
 		return;
 	}
-	m_sConnection = m_mainworker.sOnDeviceReceived.connect([this](auto id, auto idx, auto &&name, auto rx) { OnDeviceReceived(id, idx, name, rx); });
-	m_sDeviceUpdate = m_mainworker.sOnDeviceUpdate.connect([this](auto id, auto idx) { OnDeviceUpdate(id, idx); });
+	// Device and scene changes are rendered once for all clients by the CWebsocketBroadcaster
 	m_sNotification = sOnNotificationReceived.connect([this](auto &&s, auto &&t, auto &&e, auto p, auto &&sound, auto n) { OnNotificationReceived(s, t, e, p, sound, n); });
-	m_sSceneChanged = m_mainworker.sOnSwitchScene.connect([this](auto idx, auto &&name) { OnSceneChange(idx, name); });
 	isStarted = true;
 }
 
@@ -110,41 +108,6 @@ bool CWebSocketPush::WeListenTo(const unsigned long long DeviceRowIdx)
 	return std::find(listenIdxs.begin(), listenIdxs.end(), DeviceRowIdx) != listenIdxs.end();
 }
 
-void CWebSocketPush::OnDeviceReceived(const int m_HwdID, const unsigned long long DeviceRowIdx, const std::string &DeviceName, const unsigned char *pRXCommand)
-{
-	std::unique_lock<std::mutex> lock(handlerMutex);
-	if (!isStarted) {
-		return;
-	}
-
-	m_sock->OnDeviceChanged(DeviceRowIdx);
-	if (WeListenTo(DeviceRowIdx)) {
-		// push notification to web socket
-	}
-}
-
-void CWebSocketPush::OnDeviceUpdate(const int m_HwdID, const unsigned long long DeviceRowIdx)
-{
-	std::unique_lock<std::mutex> lock(handlerMutex);
-	if (!isStarted) {
-		return;
-	}
-
-	m_sock->OnDeviceChanged(DeviceRowIdx);
-	if (WeListenTo(DeviceRowIdx)) {
-		// push notification to web socket
-	}
-}
-
-void CWebSocketPush::OnSceneChange(const unsigned long long SceneRowIdx, const std::string& SceneName)
-{
-	std::unique_lock<std::mutex> lock(handlerMutex);
-	if (!isStarted) {
-		return;
-	}
-	m_sock->OnSceneChanged(SceneRowIdx);
-}
-
 void CWebSocketPush::OnNotificationReceived(const std::string & Subject, const std::string & Text, const std::string & ExtraData, const int Priority, const std::string & Sound, const bool bFromNotification)
 {
 	std::unique_lock<std::mutex> lock(handlerMutex);
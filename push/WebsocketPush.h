@@ -26,10 +26,7 @@ public:
 	bool WeListenTo(unsigned long long DeviceRowIdx);
 
       private:
-	void OnDeviceReceived(int m_HwdID, unsigned long long DeviceRowIdx, const std::string &DeviceName, const unsigned char *pRXCommand);
-	void OnDeviceUpdate(int m_HwdID, unsigned long long DeviceRowIdx);
 	void OnNotificationReceived(const std::string &Subject, const std::string &Text, const std::string &ExtraData, int Priority, const std::string &Sound, bool bFromNotification);
-	void OnSceneChange(unsigned long long SceneRowIdx, const std::string &SceneName);
 	bool listenRoomplan;
 	bool listenDeviceTable;
 	std::vector<unsigned long long> listenIdxs;
@@ -4,6 +4,16 @@
 #include "../main/Helper.h"
 #include "../main/Logger.h"
 #include "../webserver/proxyclient.h"
+#include <zlib.h>
+
+namespace
+{
+	void AppendUInt32(std::string &out, const uint32_t value)
+	{
+		for (int ii = 0; ii < 4; ii++)
+			out.push_back(static_cast<char>((value >> (ii * 8)) & 0xFF));
+	}
+} // namespace
 
 namespace tcp {
 namespace server {
@@ -55,15 +65,32 @@ void CTCPClient::handleRead(const boost::system::error_code& e,
 				StringSplit(recstr, ";", strarray);
 				if (strarray.size()==3)
 				{
-					m_bIsLoggedIn = pConnectionManager->HandleAuthentication(self, strarray[1], strarray[2]);
-					if (!m_bIsLoggedIn)
+					if (!pConnectionManager->HandleAuthentication(self, strarray[1], strarray[2]))
 					{
 						//Wrong username/password
+						m_bIsLoggedIn = false;
 						boost::asio::async_write(*socket_, boost::asio::buffer("NOAUTH", 6), [self](auto &&err, auto) { self->handleWrite(err); });
 						pConnectionManager->stopClient(self);
 						return;
 					}
 					m_username=strarray[1];
+					if (strarray[0].find(REPLICATION_AUTH) == 0)
+					{
+						//AUTHV2:<session>:<sequence>, the client wants framed updates and resumes after the given sequence
+						std::vector<std::string> resume;
+						StringSplit(strarray[0], ":", resume);
+						uint32_t Session = 0;
+						uint32_t Sequence = 0;
+						if (resume.size() == 3)
+						{
+							Session = static_cast<uint32_t>(strtoul(resume[1].c_str(), nullptr, 10));
+							Sequence = static_cast<uint32_t>(strtoul(resume[2].c_str(), nullptr, 10));
+						}
+						//ResumeClient logs us in, so no live update can be sent before the replay
+						pConnectionManager->ResumeClient(self, Session, Sequence);
+					}
+					else
+						m_bIsLoggedIn = true;
 				}
 			}
 			else
@@ -85,7 +112,89 @@ void CTCPClient::write(const char *pData, size_t Length)
 {
 	if (!m_bIsLoggedIn)
 		return;
-	boost::asio::async_write(*socket_, boost::asio::buffer(pData, Length), [self = shared_from_this()](auto &&err, auto) { self->handleWrite(err); });
+	std::lock_guard<std::mutex> l(m_writeMutex);
+	if (queueData(pData, Length))
+		flushWriteQueue();
+}
+
+void CTCPClient::writeDelta(const uint32_t Sequence, const char *pData, size_t Length)
+{
+	if (!m_bProtocolV2)
+	{
+		CTCPClientBase::writeDelta(Sequence, pData, Length);
+		return;
+	}
+	if (!m_bIsLoggedIn)
+		return;
+	std::lock_guard<std::mutex> l(m_writeMutex);
+	if ((Length != 0) && (!queueData(pData, Length)))
+		return;
+	m_pendingSequence = Sequence;
+	m_bSyncPending = true;
+	flushWriteQueue();
+}
+
+//caller holds m_writeMutex
+bool CTCPClient::queueData(const char *pData, size_t Length)
+{
+	if (m_pending.size() + Length > REPLICATION_MAX_PAYLOAD)
+	{
+		//the client does not keep up, disconnect it so it can reconnect (and resume when it supports it)
+		_log.Log(LOG_ERROR, "Domoticz client %s (%s) is not reading fast enough, disconnecting", m_username.c_str(), m_endpoint.c_str());
+		m_bIsLoggedIn = false;
+		m_pending.clear();
+		m_bSyncPending = false;
+		boost::system::error_code ec;
+		socket_->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+		return false;
+	}
+	m_pending.append(pData, Length);
+	return true;
+}
+
+//caller holds m_writeMutex
+void CTCPClient::flushWriteQueue()
+{
+	if ((m_bWriting) || ((m_pending.empty()) && (!m_bSyncPending)))
+		return;
+
+	m_writeBuffer.clear();
+	if (!m_bProtocolV2)
+	{
+		m_writeBuffer.swap(m_pending);
+	}
+	else
+	{
+		uint8_t flags = 0;
+		std::string compressed;
+		if (m_pending.size() >= REPLICATION_COMPRESS_MIN)
+		{
+			uLongf destLen = compressBound(static_cast<uLong>(m_pending.size()));
+			compressed.resize(destLen);
+			if (
+				(compress2((Bytef *)&compressed[0], &destLen, (const Bytef *)m_pending.data(), static_cast<uLong>(m_pending.size()), Z_BEST_SPEED) == Z_OK)
+				&& (destLen < m_pending.size())
+				)
+			{
+				compressed.resize(destLen);
+				flags |= REPLICATION_FLAG_ZLIB;
+			}
+		}
+		const std::string &payload = (flags & REPLICATION_FLAG_ZLIB) ? compressed : m_pending;
+
+		m_writeBuffer.reserve(REPLICATION_HEADER_SIZE + payload.size());
+		m_writeBuffer.append(REPLICATION_MAGIC, 4);
+		m_writeBuffer.push_back(static_cast<char>(flags));
+		AppendUInt32(m_writeBuffer, pConnectionManager->m_replicationSession);
+		AppendUInt32(m_writeBuffer, m_pendingSequence);
+		AppendUInt32(m_writeBuffer, static_cast<uint32_t>(m_pending.size()));
+		AppendUInt32(m_writeBuffer, static_cast<uint32_t>(payload.size()));
+		m_writeBuffer.append(payload);
+		m_pending.clear();
+	}
+	m_bSyncPending = false;
+	m_bWriting = true;
+	boost::asio::async_write(*socket_, boost::asio::buffer(m_writeBuffer), [self = shared_from_this()](auto &&err, auto) { self->handleWrite(err); });
 }
 
 void CTCPClient::handleWrite(const boost::system::error_code& error)
@@ -93,7 +202,11 @@ void CTCPClient::handleWrite(const boost::system::error_code& error)
 	if (error)
 	{
 		pConnectionManager->stopClient(shared_from_this());
+		return;
 	}
+	std::lock_guard<std::mutex> l(m_writeMutex);
+	m_bWriting = false;
+	flushWriteQueue();
 }
 
 #ifndef NOCLOUD
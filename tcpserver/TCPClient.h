@@ -2,6 +2,7 @@
 
 #include "../main/Noncopyable.h"
 #include <boost/asio.hpp>
+#include <mutex>
 
 namespace http {
 	namespace server {
@@ -25,10 +26,17 @@ public:
 	virtual void stop() = 0;
 
 	virtual void write(const char *pData, size_t Length) = 0;
+	//send a shared device update, an empty update only announces the sequence
+	virtual void writeDelta(uint32_t Sequence, const char *pData, size_t Length)
+	{
+		if (Length != 0)
+			write(pData, Length);
+	}
 
 	std::string m_username;
 	std::string m_endpoint;
 	bool m_bIsLoggedIn;
+	bool m_bProtocolV2 = false;
 
 	// usual tcp parameters
 	boost::asio::ip::tcp::socket *socket() { return socket_; }
@@ -49,13 +57,24 @@ public:
 	void start() override;
 	void stop() override;
 	void write(const char *pData, size_t Length) override;
+	void writeDelta(uint32_t Sequence, const char *pData, size_t Length) override;
 
       private:
 	void handleRead(const boost::system::error_code& error, size_t length);
 	void handleWrite(const boost::system::error_code& error);
+	bool queueData(const char *pData, size_t Length);
+	void flushWriteQueue();
 
 	/// Buffer for incoming data.
 	std::array<char, 8192> buffer_;
+
+	/// Outgoing data, only one write is in flight, everything else is batched into the next one
+	std::mutex m_writeMutex;
+	std::string m_pending;
+	std::string m_writeBuffer;
+	uint32_t m_pendingSequence = 0;
+	bool m_bSyncPending = false;
+	bool m_bWriting = false;
 };
 
 #ifndef NOCLOUD
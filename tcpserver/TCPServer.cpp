@@ -11,6 +11,7 @@
 #include "../main/localtime_r.h"
 #include <boost/asio.hpp>
 #include <algorithm>
+#include <random>
 
 namespace tcp {
 namespace server {
@@ -18,6 +19,8 @@ namespace server {
 CTCPServerIntBase::CTCPServerIntBase(CTCPServer *pRoot)
 {
 	m_pRoot=pRoot;
+	//a new session makes slaves of a previous run start over instead of resuming
+	m_replicationSession = std::random_device()();
 }
 
 void CTCPServerInt::start()
@@ -129,6 +132,63 @@ bool CTCPServerIntBase::HandleAuthentication(const CTCPClient_ptr &c, const std:
 	return ((pUser->Username==username)&&(pUser->Password==password));
 }
 
+bool CTCPServerIntBase::IsDeviceShared(const _tRemoteShareUser *pUser, const uint64_t DeviceRowID)
+{
+	if (pUser->Devices.empty())
+		return true;
+	return std::any_of(pUser->Devices.begin(), pUser->Devices.end(), [DeviceRowID](uint64_t d) { return d == DeviceRowID; });
+}
+
+void CTCPServerIntBase::ResumeClient(const CTCPClient_ptr &c, const uint32_t Session, const uint32_t Sequence)
+{
+	std::lock_guard<std::mutex> l(connectionMutex);
+	_tRemoteShareUser *pUser = FindUser(c->m_username);
+	if (pUser == nullptr)
+		return;
+
+	//SendToAll also holds connectionMutex, so the replay is queued before any live update
+	c->m_bProtocolV2 = true;
+	c->m_bIsLoggedIn = true;
+
+	bool bResumed = false;
+	if ((Session == m_replicationSession) && (Sequence != 0))
+	{
+		if ((!m_replicationHistory.empty()) && (Sequence + 1 < m_replicationHistory.front().Sequence))
+		{
+			_log.Log(LOG_STATUS, "Domoticz client %s (%s) missed too many updates, sending current device states", c->m_username.c_str(), c->m_endpoint.c_str());
+		}
+		else
+		{
+			int nReplayed = 0;
+			for (const auto &delta : m_replicationHistory)
+			{
+				if ((delta.Sequence <= Sequence) || (!IsDeviceShared(pUser, delta.DeviceRowID)))
+					continue;
+				c->writeDelta(delta.Sequence, delta.Data.c_str(), delta.Data.size());
+				nReplayed++;
+			}
+			_log.Debug(DEBUG_NORM, "Domoticz client %s (%s) resumed at %u, %d update(s) replayed", c->m_username.c_str(), c->m_endpoint.c_str(), Sequence, nReplayed);
+			bResumed = true;
+		}
+	}
+	if (!bResumed)
+	{
+		//send the last known message of every shared device, in the order they were received
+		std::vector<const _tReplicationDelta *> states;
+		for (const auto &itt : m_replicationLatest)
+		{
+			if (IsDeviceShared(pUser, itt.first))
+				states.push_back(&itt.second);
+		}
+		std::sort(states.begin(), states.end(), [](const _tReplicationDelta *a, const _tReplicationDelta *b) { return a->Sequence < b->Sequence; });
+		for (const auto &delta : states)
+			c->writeDelta(delta->Sequence, delta->Data.c_str(), delta->Data.size());
+		_log.Debug(DEBUG_NORM, "Domoticz client %s (%s) synchronized, %d device state(s) sent", c->m_username.c_str(), c->m_endpoint.c_str(), (int)states.size());
+	}
+	//empty frame, tells the client the current session and sequence
+	c->writeDelta(m_replicationSequence, nullptr, 0);
+}
+
 void CTCPServerIntBase::DoDecodeMessage(const CTCPClientBase *pClient, const unsigned char *pRXCommand)
 {
 	m_pRoot->DoDecodeMessage(pClient,pRXCommand);
@@ -185,6 +245,11 @@ void CTCPServerIntBase::SendToAll(const int /*HardwareID*/, const uint64_t Devic
 		)
 		return;
 
+	_tReplicationDelta delta;
+	delta.Sequence = ++m_replicationSequence;
+	delta.DeviceRowID = DeviceRowID;
+	delta.Data.assign(pData, Length);
+
 	for (const auto &c : connections_)
 	{
 		CTCPClientBase *pClient = c.get();
@@ -194,20 +259,17 @@ void CTCPServerIntBase::SendToAll(const int /*HardwareID*/, const uint64_t Devic
 		if (pClient)
 		{
 			_tRemoteShareUser *pUser=FindUser(pClient->m_username);
-			if (pUser != nullptr)
-			{
-				//check if we are allowed to get this device
-				bool bOk2Send=false;
-				if (pUser->Devices.empty())
-					bOk2Send=true;
-				else
-					bOk2Send = std::any_of(pUser->Devices.begin(), pUser->Devices.end(), [DeviceRowID](uint64_t d) { return d == DeviceRowID; });
-
-				if (bOk2Send)
-					pClient->write(pData,Length);
-			}
+			//check if we are allowed to get this device
+			if ((pUser != nullptr) && IsDeviceShared(pUser, DeviceRowID))
+				pClient->writeDelta(delta.Sequence, pData, Length);
 		}
 	}
+
+	if (DeviceRowID != 0)
+		m_replicationLatest[DeviceRowID] = delta;
+	m_replicationHistory.push_back(std::move(delta));
+	while (m_replicationHistory.size() > REPLICATION_HISTORY_SIZE)
+		m_replicationHistory.pop_front();
 }
 
 CTCPServerInt::CTCPServerInt(const std::string& address, const std::string& port, CTCPServer *pRoot) :
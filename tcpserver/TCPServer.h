@@ -2,6 +2,8 @@
 
 #include "../hardware/DomoticzHardware.h"
 #include "TCPClient.h"
+#include <deque>
+#include <map>
 #include <set>
 
 namespace tcp {
@@ -28,6 +30,24 @@ struct _tRemoteMessage
 	//data
 };
 
+//Replication protocol v2 (negotiated with "AUTHV2:<session>:<sequence>;user;pass")
+//Frame: magic(4) flags(1) session(4) sequence(4) rawlength(4) payloadlength(4) payload
+//All integers little endian, payload is a sequence of RFX messages
+#define REPLICATION_AUTH "AUTHV2"
+#define REPLICATION_MAGIC "DZR2"
+#define REPLICATION_HEADER_SIZE 21
+#define REPLICATION_FLAG_ZLIB 0x01
+#define REPLICATION_COMPRESS_MIN 128
+#define REPLICATION_MAX_PAYLOAD (1024 * 1024)
+#define REPLICATION_HISTORY_SIZE 1024
+
+struct _tReplicationDelta
+{
+	uint32_t Sequence;
+	uint64_t DeviceRowID;
+	std::string Data;
+};
+
 class CTCPServerIntBase
 {
 public:
@@ -52,8 +72,10 @@ protected:
 	};
 
 	_tRemoteShareUser* FindUser(const std::string &username);
+	static bool IsDeviceShared(const _tRemoteShareUser *pUser, uint64_t DeviceRowID);
 
 	bool HandleAuthentication(const CTCPClient_ptr &c, const std::string &username, const std::string &password);
+	void ResumeClient(const CTCPClient_ptr &c, uint32_t Session, uint32_t Sequence);
 	void DoDecodeMessage(const CTCPClientBase *pClient, const unsigned char *pRXCommand);
 
 	std::vector<_tRemoteShareUser> m_users;
@@ -62,6 +84,13 @@ protected:
 	std::set<CTCPClient_ptr> connections_;
 	std::mutex connectionMutex;
 
+	//replication state, protected by connectionMutex
+	uint32_t m_replicationSession;
+	uint32_t m_replicationSequence = 0;
+	std::deque<_tReplicationDelta> m_replicationHistory;
+	//last message of every device, sent to clients that can not resume
+	std::map<uint64_t, _tReplicationDelta> m_replicationLatest;
+
 	friend class CTCPClient;
 	friend class CSharedClient;
 };
@@ -10,14 +10,165 @@
 #include "../main/Logger.h"
 
 #define WEBSOCKET_SESSION_TIMEOUT 86400 // 1 day
+#define WEBSOCKET_COALESCE_MS 100	 // collect a burst of changes before rendering them
+#define WEBSOCKET_SEND_QUEUE_SIZE 64	 // pending packets per client before the oldest is dropped
 
 namespace http {
 	namespace server {
 
+		CWebsocketBroadcaster::~CWebsocketBroadcaster()
+		{
+			Shutdown();
+		}
+
+		void CWebsocketBroadcaster::Register(CWebsocketHandler *pHandler)
+		{
+			std::lock_guard<std::mutex> l(m_lifecycleMutex);
+			bool bFirst;
+			{
+				std::lock_guard<std::mutex> lHandlers(m_handlersMutex);
+				if (std::find(m_handlers.begin(), m_handlers.end(), pHandler) != m_handlers.end())
+					return;
+				m_handlers.push_back(pHandler);
+				bFirst = (m_handlers.size() == 1);
+			}
+			if (bFirst)
+				Start();
+		}
+
+		void CWebsocketBroadcaster::Unregister(CWebsocketHandler *pHandler)
+		{
+			std::lock_guard<std::mutex> l(m_lifecycleMutex);
+			bool bLast;
+			{
+				std::lock_guard<std::mutex> lHandlers(m_handlersMutex);
+				auto itt = std::find(m_handlers.begin(), m_handlers.end(), pHandler);
+				if (itt == m_handlers.end())
+					return;
+				m_handlers.erase(itt);
+				bLast = m_handlers.empty();
+			}
+			if (bLast)
+				Stop();
+		}
+
+		// Stops the worker even while clients are still registered, a later Register restarts it
+		void CWebsocketBroadcaster::Shutdown()
+		{
+			std::lock_guard<std::mutex> l(m_lifecycleMutex);
+			Stop();
+		}
+
+		void CWebsocketBroadcaster::Start()
+		{
+			RequestStart();
+			m_sDeviceReceived = m_mainworker.sOnDeviceReceived.connect([this](auto id, auto idx, auto &&name, auto rx) { OnDeviceChanged(idx); });
+			m_sDeviceUpdate = m_mainworker.sOnDeviceUpdate.connect([this](auto id, auto idx) { OnDeviceChanged(idx); });
+			m_sSceneChanged = m_mainworker.sOnSwitchScene.connect([this](auto idx, auto &&name) { OnSceneChanged(idx); });
+			m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
+			SetThreadName(m_thread->native_handle(), "WSBroadcaster");
+		}
+
+		void CWebsocketBroadcaster::Stop()
+		{
+			m_sDeviceReceived.disconnect();
+			m_sDeviceUpdate.disconnect();
+			m_sSceneChanged.disconnect();
+			if (m_thread)
+			{
+				RequestStop();
+				{
+					std::lock_guard<std::mutex> l(m_queueMutex);
+					m_queueCondition.notify_one();
+				}
+				m_thread->join();
+				m_thread.reset();
+			}
+			std::lock_guard<std::mutex> l(m_queueMutex);
+			m_pendingDevices.clear();
+			m_pendingScenes.clear();
+		}
+
+		// Called on the thread that raised the change (usually the RX worker), so only queue it
+		void CWebsocketBroadcaster::OnDeviceChanged(const uint64_t DeviceRowIdx)
+		{
+			std::lock_guard<std::mutex> l(m_queueMutex);
+			m_pendingDevices.insert(DeviceRowIdx);
+			m_queueCondition.notify_one();
+		}
+
+		void CWebsocketBroadcaster::OnSceneChanged(const uint64_t SceneRowIdx)
+		{
+			std::lock_guard<std::mutex> l(m_queueMutex);
+			m_pendingScenes.insert(SceneRowIdx);
+			m_queueCondition.notify_one();
+		}
+
+		void CWebsocketBroadcaster::Do_Work()
+		{
+			while (!IsStopRequested(0))
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_queueMutex);
+					m_queueCondition.wait_for(lock, std::chrono::seconds(1), [this] { return !m_pendingDevices.empty() || !m_pendingScenes.empty() || IsStopRequested(0); });
+					if (m_pendingDevices.empty() && m_pendingScenes.empty())
+						continue;
+				}
+
+				// Let a burst of updates settle so each device is rendered once
+				if (IsStopRequested(WEBSOCKET_COALESCE_MS))
+					break;
+
+				std::set<uint64_t> devices;
+				std::set<uint64_t> scenes;
+				{
+					std::lock_guard<std::mutex> l(m_queueMutex);
+					devices.swap(m_pendingDevices);
+					scenes.swap(m_pendingScenes);
+				}
+				Broadcast("device_request", "devices", devices);
+				Broadcast("scene_request", "scenes", scenes);
+			}
+		}
+
+		void CWebsocketBroadcaster::Broadcast(const std::string &szEvent, const std::string &szType, const std::set<uint64_t> &Idxs)
+		{
+			std::lock_guard<std::mutex> l(m_handlersMutex);
+			for (const auto idx : Idxs)
+			{
+				std::string query = "type=" + szType + "&rid=" + std::to_string(idx);
+				std::string key = szType + "_" + std::to_string(idx);
+
+				// The result only depends on the user, clients logged in as the same user share one rendering
+				std::map<std::string, std::string> rendered;
+				for (auto pHandler : m_handlers)
+				{
+					try
+					{
+						std::string renderkey = pHandler->RenderKey();
+						auto itt = rendered.find(renderkey);
+						if (itt == rendered.end())
+						{
+							std::string response;
+							pHandler->Render(szEvent, query, response);
+							itt = rendered.insert(std::make_pair(renderkey, response)).first;
+						}
+						if (!itt->second.empty())
+							pHandler->QueueWrite(key, itt->second);
+					}
+					catch (std::exception &e)
+					{
+						_log.Log(LOG_ERROR, "WebsocketBroadcaster::%s Exception: %s", __func__, e.what());
+					}
+				}
+			}
+		}
+
 		CWebsocketHandler::CWebsocketHandler(cWebem *pWebem, std::function<void(const std::string &packet_data)> _MyWrite)
 			: MyWrite(std::move(_MyWrite))
 			, myWebem(pWebem)
 			, m_Push(this)
+			, m_LastDateTime(0)
 		{
 		}
 
@@ -26,32 +177,93 @@ namespace http {
 			Stop();
 		}
 
-		boost::tribool CWebsocketHandler::Handle(const std::string &packet_data, bool outbound)
+		void CWebsocketHandler::GetSession(WebEmSession &session, const bool outbound)
 		{
+			// WebSockets only do security during set up so keep pushing the expiry out to stop it being cleaned up
+			std::map<std::string, WebEmSession>::iterator itt = myWebem->m_sessions.find(sessionid);
+			if (itt != myWebem->m_sessions.end())
+			{
+				session = itt->second;
+			}
+			else
+				// for outbound messages create a temporary session if required
+				// todo: Add the username and rights from the original connection
+				if (outbound)
+				{
+					time_t nowAnd1Day = ((time_t)mytime(nullptr)) + WEBSOCKET_SESSION_TIMEOUT;
+					session.timeout = nowAnd1Day;
+					session.expires = nowAnd1Day;
+					session.isnew = false;
+					session.forcelogin = false;
+					session.rememberme = false;
+					session.reply_status = 200;
+				}
+		}
+
+		bool CWebsocketHandler::Render(WebEmSession &session, const std::string &szEvent, const std::string &query, const int64_t requestid, std::string &response)
+		{
+			request req;
+			req.method = "GET";
+			req.uri = myWebem->GetWebRoot() + "/json.htm?" + query;
+			req.http_version_major = 1;
+			req.http_version_minor = 1;
+			req.headers.resize(0); // todo: do we need any headers?
+			req.content.clear();
+			reply rep;
+			if (!myWebem->CheckForPageOverride(session, req, rep))
+				return false;
+			if (rep.status != reply::ok)
+				return false;
 			Json::Value jsonValue;
-			try
+			jsonValue["request"] = szEvent;
+			jsonValue["event"] = "response";
+			jsonValue["requestid"] = (Json::Value::Int64)requestid;
+			jsonValue["data"] = rep.content;
+			response = JSonToFormatString(jsonValue);
+			return true;
+		}
+
+		bool CWebsocketHandler::Render(const std::string &szEvent, const std::string &query, std::string &response)
+		{
+			WebEmSession session;
+			GetSession(session, true);
+			return Render(session, szEvent, query, -1, response);
+		}
+
+		// Clients with the same key get the same rendering of a device
+		std::string CWebsocketHandler::RenderKey()
+		{
+			std::map<std::string, WebEmSession>::iterator itt = myWebem->m_sessions.find(sessionid);
+			if (itt == myWebem->m_sessions.end())
+				return "";
+			return itt->second.username + "|" + std::to_string(itt->second.rights);
+		}
+
+		void CWebsocketHandler::QueueWrite(const std::string &key, const std::string &packet)
+		{
+			std::lock_guard<std::mutex> l(m_mutex);
+			// A newer state of the same device replaces the one still waiting to be sent
+			for (auto &itt : m_sendQueue)
 			{
-				// WebSockets only do security during set up so keep pushing the expiry out to stop it being cleaned up
-				WebEmSession session;
-				std::map<std::string, WebEmSession>::iterator itt = myWebem->m_sessions.find(sessionid);
-				if (itt != myWebem->m_sessions.end())
+				if (itt.first == key)
 				{
-					session = itt->second;
+					itt.second = packet;
+					return;
 				}
-				else
-					// for outbound messages create a temporary session if required
-					// todo: Add the username and rights from the original connection
-					if (outbound)
-					{
-						time_t nowAnd1Day = ((time_t)mytime(nullptr)) + WEBSOCKET_SESSION_TIMEOUT;
-						session.timeout = nowAnd1Day;
-						session.expires = nowAnd1Day;
-						session.isnew = false;
-						session.forcelogin = false;
-						session.rememberme = false;
-						session.reply_status = 200;
-					}
+			}
+			if (m_sendQueue.size() >= WEBSOCKET_SEND_QUEUE_SIZE)
+				m_sendQueue.pop_front();
+			m_sendQueue.emplace_back(key, packet);
+			m_sendCondition.notify_one();
+		}
 
+		boost::tribool CWebsocketHandler::Handle(const std::string &packet_data, bool outbound)
+		{
+			Json::Value jsonValue;
+			try
+			{
+				WebEmSession session;
+				GetSession(session, outbound);
 
 				Json::Value value;
 				if (!ParseJSon(packet_data, value)) {
@@ -61,26 +273,11 @@ namespace http {
 				if (szEvent.find("request") == std::string::npos)
 					return true;
 
-				request req;
-				req.method = "GET";
-				std::string querystring = value["query"].asString();
-				req.uri = myWebem->GetWebRoot() + "/json.htm?" + querystring;
-				req.http_version_major = 1;
-				req.http_version_minor = 1;
-				req.headers.resize(0); // todo: do we need any headers?
-				req.content.clear();
-				reply rep;
-				if (myWebem->CheckForPageOverride(session, req, rep)) {
-					if (rep.status == reply::ok) {
-						jsonValue["request"] = szEvent;
-						jsonValue["event"] = "response";
-						Json::Value::Int64 reqID = value["requestid"].asInt64();
-						jsonValue["requestid"] = reqID;
-						jsonValue["data"] = rep.content;
-						std::string response = JSonToFormatString(jsonValue);
-						MyWrite(response);
-						return true;
-					}
+				std::string response;
+				if (Render(session, szEvent, value["query"].asString(), value["requestid"].asInt64(), response))
+				{
+					MyWrite(response);
+					return true;
 				}
 			}
 			catch (std::exception& e)
@@ -102,14 +299,21 @@ namespace http {
 
 			//Start worker thread
 			m_thread = std::make_shared<std::thread>([this] { Do_Work(); });
+
+			myWebem->m_wsBroadcaster.Register(this);
 		}
 
 		void CWebsocketHandler::Stop()
 		{
+			myWebem->m_wsBroadcaster.Unregister(this);
 			m_Push.Stop();
 			if (m_thread)
 			{
 				RequestStop();
+				{
+					std::lock_guard<std::mutex> l(m_mutex);
+					m_sendCondition.notify_one();
+				}
 				m_thread->join();
 				m_thread.reset();
 			}
@@ -117,12 +321,22 @@ namespace http {
 
 		void CWebsocketHandler::Do_Work()
 		{
-			while (!IsStopRequested(1000))
+			while (!IsStopRequested(0))
 			{
+				std::deque<std::pair<std::string, std::string>> queue;
+				{
+					std::unique_lock<std::mutex> lock(m_mutex);
+					m_sendCondition.wait_for(lock, std::chrono::seconds(1), [this] { return !m_sendQueue.empty() || IsStopRequested(0); });
+					queue.swap(m_sendQueue);
+				}
+				for (const auto &packet : queue)
+					MyWrite(packet.second);
+
 				time_t atime = mytime(nullptr);
-				if (atime % 10 == 0)
+				if ((atime % 10 == 0) && (atime != m_LastDateTime))
 				{
 					//Send Date/Time every 10 seconds
+					m_LastDateTime = atime;
 					SendDateTime();
 				}
 			}
@@ -173,41 +387,15 @@ namespace http {
 			}
 		}
 
+		// Device and scene changes are rendered by the broadcaster, which subscribes to them for all clients
 		void CWebsocketHandler::OnDeviceChanged(const uint64_t DeviceRowIdx)
 		{
-			try
-			{
-				std::string query = "type=devices&rid=" + std::to_string(DeviceRowIdx);
-				Json::Value request;
-				request["event"] = "device_request";
-				request["requestid"] = -1;
-				request["query"] = query;
-				std::string packet = JSonToFormatString(request);
-				Handle(packet, true);
-			}
-			catch (std::exception& e)
-			{
-				_log.Log(LOG_ERROR, "WebsocketHandler::%s Exception: %s", __func__, e.what());
-			}
+			myWebem->m_wsBroadcaster.OnDeviceChanged(DeviceRowIdx);
 		}
 
 		void CWebsocketHandler::OnSceneChanged(const uint64_t SceneRowIdx)
 		{
-			try
-			{
-				std::string query = "type=scenes&rid=" + std::to_string(SceneRowIdx);
-				Json::Value request;
-				request["event"] = "scene_request";
-				request["requestid"] = -1;
-				request["query"] = query;
-
-				std::string packet = JSonToFormatString(request);
-				Handle(packet, true);
-			}
-			catch (std::exception& e)
-			{
-				_log.Log(LOG_ERROR, "WebsocketHandler::%s Exception: %s", __func__, e.what());
-			}
+			myWebem->m_wsBroadcaster.OnSceneChanged(SceneRowIdx);
 		}
 
 		void CWebsocketHandler::SendNotification(const std::string &Subject, const std::string &Text, const std::string &ExtraData, const int Priority, const std::string &Sound, const bool bFromNotification)
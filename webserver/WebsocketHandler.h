@@ -8,6 +8,9 @@
 #include <thread>
 #include <mutex>
 #include <memory>
+#include <condition_variable>
+#include <deque>
+#include <set>
 
 namespace http
 {
@@ -15,6 +18,38 @@ namespace http
 	{
 
 		class cWebem;
+		class CWebsocketHandler;
+		struct _tWebEmSession;
+
+		// Renders each device/scene change once per user and fans it out to the connected websocket clients
+		class CWebsocketBroadcaster : public StoppableTask
+		{
+		      public:
+			~CWebsocketBroadcaster();
+			void Register(CWebsocketHandler *pHandler);
+			void Unregister(CWebsocketHandler *pHandler);
+			void Shutdown();
+			void OnDeviceChanged(uint64_t DeviceRowIdx);
+			void OnSceneChanged(uint64_t SceneRowIdx);
+
+		      private:
+			void Start();
+			void Stop();
+			void Do_Work();
+			void Broadcast(const std::string &szEvent, const std::string &szType, const std::set<uint64_t> &Idxs);
+
+			std::set<uint64_t> m_pendingDevices;
+			std::set<uint64_t> m_pendingScenes;
+			std::mutex m_queueMutex;
+			std::condition_variable m_queueCondition;
+			std::vector<CWebsocketHandler *> m_handlers;
+			std::mutex m_handlersMutex;  // held while fanning out so a handler is never used after Unregister
+			std::mutex m_lifecycleMutex; // serializes Register/Unregister and starting/stopping the worker
+			std::shared_ptr<std::thread> m_thread;
+			boost::signals2::connection m_sDeviceReceived;
+			boost::signals2::connection m_sDeviceUpdate;
+			boost::signals2::connection m_sSceneChanged;
+		};
 
 		class CWebsocketHandler : public StoppableTask
 		{
@@ -30,6 +65,11 @@ namespace http
 						      bool bFromNotification);
 			virtual void store_session_id(const request &req, const reply &rep);
 
+			// used by the broadcaster
+			std::string RenderKey();
+			bool Render(const std::string &szEvent, const std::string &query, std::string &response);
+			void QueueWrite(const std::string &key, const std::string &packet);
+
 		      protected:
 			std::function<void(const std::string &packet_data)> MyWrite;
 			std::string sessionid;
@@ -37,9 +77,14 @@ namespace http
 			CWebSocketPush m_Push;
 
 		      private:
+			void GetSession(_tWebEmSession &session, bool outbound);
+			bool Render(_tWebEmSession &session, const std::string &szEvent, const std::string &query, int64_t requestid, std::string &response);
 			void SendDateTime();
 			std::shared_ptr<std::thread> m_thread;
 			std::mutex m_mutex;
+			std::condition_variable m_sendCondition;
+			std::deque<std::pair<std::string, std::string>> m_sendQueue; // bounded, keyed so a newer state replaces a pending one
+			time_t m_LastDateTime;
 			void Do_Work();
 		};
 
@@ -113,6 +113,7 @@ namespace http {
 			{
 				myServer->stop();
 			}
+			m_wsBroadcaster.Shutdown();
 		}
 
 		void cWebem::SetAuthenticationMethod(const _eAuthenticationMethod amethod)
@@ -796,7 +797,9 @@ namespace http {
 				{
 					reply::add_header(&rep, "Cache-Control", "max-age=3600, public");
 				}
-				reply::add_header_content_type(&rep, strMimeType);
+				// keep a content type set by the page itself (binary responses)
+				if (!strMimeType.empty())
+					reply::add_header_if_absent(&rep, "Content-Type", strMimeType);
 				return true;
 			}
 
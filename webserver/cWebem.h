@@ -4,6 +4,7 @@
 #include <boost/thread.hpp>
 #include "server.hpp"
 #include "session_store.hpp"
+#include "WebsocketHandler.h"
 
 namespace http
 {
@@ -154,6 +155,7 @@ namespace http
 		class cWebem
 		{
 			friend class CProxyClient;
+			friend class CWebsocketHandler;
 
 		      public:
 			cWebem(const server_settings &settings, const std::string &doc_root);
@@ -240,6 +242,8 @@ namespace http
 			std::map<std::string, webem_page_function> myPages_w;
 			void CleanSessions();
 			session_store_impl_ptr mySessionStore; /// session store
+			/// shared by the websocket clients of this server, declared before myServer so it outlives their handlers
+			CWebsocketBroadcaster m_wsBroadcaster;
 			/// request handler specialized to handle webem requests
 			/// Rene: Beware: myRequestHandler should be declared BEFORE myServer
 			cWebemRequestHandler myRequestHandler;
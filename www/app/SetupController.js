@@ -577,6 +577,9 @@ define(['app'], function (app) {
 					if (typeof data.UVCParams != 'undefined') {
 						$("#uvctable #UVCParams").val(data.UVCParams);
 					}
+					if (typeof data.CameraSnapshotMaxAge != 'undefined') {
+						$("#camcachetable #CameraSnapshotMaxAge").val(data.CameraSnapshotMaxAge);
+					}
 					if (typeof data.AcceptNewHardware != 'undefined') {
 						$("#acceptnewhardwaretable #AcceptNewHardware").prop('checked', data.AcceptNewHardware == 1);
 					}